@@ -0,0 +1,25 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include "../include/solverAPI.h"
+
+/* Largest width and length solved in lanes, the placements of every line tabled */
+#define BATCH_MAX_SIZE 16
+
+/* One puzzle of a batch, its clues as solveClues() takes them (rows, then columns) */
+typedef struct BatchPuzzle {
+	const int * const * clues;
+	const int * clueCounts;
+} BatchPuzzle;
+
+/* Outcome of one puzzle of a batch */
+typedef struct BatchResult {
+	SolveStatus status;
+	bool searched;                  /* Finished by the scalar solver rather than in lanes */
+	uint64_t rows[BATCH_MAX_SIZE];  /* For SOLVE_SOLVED, bit c of rows[r] set when (r, c) is filled */
+} BatchResult;
+
+int solveBatch (SolverContext *, int, int, const BatchPuzzle *, BatchResult *, int);
+
+#endif
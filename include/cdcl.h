@@ -0,0 +1,21 @@
+#ifndef CDCL_H
+#define CDCL_H
+
+#include "../include/puzzle.h"
+
+typedef struct Cdcl Cdcl;
+
+/* Receives each solution found, returns FALSE to stop the search */
+typedef bool (* SolutionHandler) (const int *, void *);
+
+SolveStatus cdclSolve (Puzzle *, const int *, int);
+
+SolveStatus cdclEnumerate (Puzzle *, const int *, int, long, SolutionHandler, void *, long *);
+
+Cdcl * createCdcl (Puzzle *, const int *, int);
+
+SolveStatus resumeCdcl (Cdcl *, long, SolutionHandler, void *, long *);
+
+void freeCdcl (Cdcl *);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef COLOUR_H
+#define COLOUR_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "../include/utility.h"
+
+/*
+ * Placements a colour line stores once it is down to them. Lines with more are solved from
+ * the placement table, which costs about as much as filtering a few dozen permutations.
+ */
+#define COLOUR_PERMUTATION_LIMIT 64
+
+/*
+ * A line of a colour puzzle. Its solved state lives in the puzzle as colourCount + 1 bit
+ * planes, plane k holding the cells that may still be colour k and plane 0 those that may
+ * still be background, so a cell is solved once exactly one plane holds it.
+ */
+typedef struct ColourLine {
+	int size;
+	int colourCount;
+	LineClue * clueSet;
+	uint64_t * permutations;   /* colourCount words each, word k - 1 the cells of colour k */
+	int permutationCount;
+} ColourLine;
+
+typedef struct ColourPuzzle {
+	int width;
+	int length;
+	int colourCount;
+	int iterations;
+	long deadline;
+	atomic_bool * cancel;
+	LineClue ** lineClues;
+	ColourLine * lines;        /* Rows, then columns */
+	uint64_t * planes;         /* colourCount + 1 planes per line, in line order */
+} ColourPuzzle;
+
+bool validateColourClues (LineClue **, int, int, int);
+
+ColourPuzzle * createColourPuzzle (LineClue **, int, int, int);
+
+void freeColourPuzzle (ColourPuzzle *);
+
+double countColourPlacements (ColourLine *, const uint64_t *);
+
+bool solveColourPlacements (ColourLine *, uint64_t *);
+
+bool enumerateColourPermutations (ColourLine *, const uint64_t *);
+
+bool filterColourPermutations (ColourLine *, uint64_t *);
+
+bool solveColourLine (ColourLine *, uint64_t *);
+
+SolveStatus solveColourPuzzle (ColourPuzzle *, const SolveOptions *);
+
+int * colourGameBoard (ColourPuzzle *);
+
+int * solveColourFile (FILE *, int *, int *, int *, int *, SolveStatus *, const SolveOptions *);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "../include/puzzle.h"
+
+/* Solves the region of unsolved cells given (see solveComponents()) */
+typedef SolveStatus (* RegionSolver) (Puzzle *, const int *, int);
+
+int findComponents (Puzzle *, int *);
+
+SolveStatus solveComponents (Puzzle *, RegionSolver, bool);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "../include/solverAPI.h"
+
+int runDaemon (int, int, const SolveOptions *, SearchEngine);
+
+int runSocketDaemon (const char *, const SolveOptions *, SearchEngine);
+
+#endif
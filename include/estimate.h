@@ -0,0 +1,32 @@
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#include <stddef.h>
+#include "../include/utility.h"
+
+/* How costly a puzzle looks before solving, see estimateClues() */
+typedef enum RiskClass {
+	RISK_TRIVIAL = 0,
+	RISK_LIGHT,
+	RISK_HEAVY,
+	RISK_EXTREME
+} RiskClass;
+
+typedef struct PuzzleEstimate {
+	int width;
+	int length;
+	int openLines;            /* Lines the rules leave unsolved, to be enumerated */
+	int largestLine;          /* Line index (rows, then columns) with the most placements, -1 if none open */
+	double largestPlacements;
+	double totalPlacements;   /* Over the open lines, the enumeration work */
+	double peakBytes;         /* Permutation memory once every open line is enumerated */
+	RiskClass risk;
+} PuzzleEstimate;
+
+bool estimateClues (LineClue **, int, int, PuzzleEstimate *, double *);
+
+bool estimateBuffer (const char *, size_t, PuzzleEstimate *, char *, size_t);
+
+const char * riskClassName (RiskClass);
+
+#endif
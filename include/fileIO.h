@@ -8,4 +8,14 @@ FILE * getFile (int, char *);
 
 LineClue ** readFile (FILE *, int *, int *);
 
+LineClue ** readBuffer (const char *, size_t, int *, int *, char *, size_t);
+
+LineClue ** readColourFile (FILE *, int *, int *, int *);
+
+LineClue ** readColourBuffer (const char *, size_t, int *, int *, int *, char *, size_t);
+
+bool isColourFile (FILE *);
+
+int * readGameBoard (FILE *, int, int);
+
 #endif
@@ -1,15 +1,33 @@
 #ifndef GAMEBOARD_H
 #define GAMEBOARD_H
 
+#include <stdio.h>
 #include "../include/utility.h"
 
+/* How a gameboard is written out, see renderGameBoard() */
+typedef enum BoardFormat {
+	BOARD_GRID = 0,
+	BOARD_ROWS,
+	BOARD_PBM,
+	BOARD_BINARY,
+	BOARD_QUIET
+} BoardFormat;
+
 int * createGameBoard (int, int);
 
+size_t renderGameBoard (const int *, int, int, BoardFormat, char *, size_t);
+
+bool writeGameBoard (FILE *, const int *, int, int, BoardFormat);
+
+size_t renderColourBoard (const int *, int, int, BoardFormat, char *, size_t);
+
+bool writeColourBoard (FILE *, const int *, int, int, BoardFormat);
+
 void printGameBoard (int *, int, int);
 
-void setGameBoardRow (int *, Line *, int *);
+bool setGameBoardRow (int *, Line *, int *);
 
-void setGameBoardColumn (int *, Line *, int, int *);
+bool setGameBoardColumn (int *, Line *, int, int *);
 
 void getGameBoardColumn (int *, int *, int, int, int);
 
@@ -0,0 +1,21 @@
+#ifndef LINE_CACHE_H
+#define LINE_CACHE_H
+
+#include <stdint.h>
+#include "../include/utility.h"
+
+typedef struct LineCache LineCache;
+
+LineCache * createLineCache (int);
+
+void freeLineCache (LineCache *);
+
+int lineCacheKey (LineCache *, const int *, int, int);
+
+int lineCacheLookup (LineCache *, int, uint64_t *, uint64_t *);
+
+void lineCacheStore (LineCache *, int, uint64_t, uint64_t, bool, uint64_t, uint64_t);
+
+void lineCacheStats (LineCache *, long *, long *);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef LINE_SOLVE_H
+#define LINE_SOLVE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "../include/utility.h"
+
+/* How solveSingleLine() deduces a line's cells, both find every cell the clues force */
+typedef enum LineEngine {
+	LINE_ENGINE_PLACEMENTS = 0,   /* Placement tables, see solveLinePlacements() */
+	LINE_ENGINE_PERMUTATIONS      /* Rules, then enumerating the permutations that fit */
+} LineEngine;
+
+/*
+ * One captured line solve: the line, its known (maskBits) and filled (partialBits) cells,
+ * and what the solver deduced from them.
+ */
+typedef struct LineRecord {
+	int size;
+	int clueCount;
+	int clues[MAX_CLUES];
+	uint64_t maskBits;
+	uint64_t partialBits;
+	bool feasible;
+	uint64_t solvedMask;          /* Only meaningful when feasible */
+	uint64_t solvedPartial;
+} LineRecord;
+
+/* Outcome of replaying a capture, see replayLineCapture() */
+typedef struct LineReplay {
+	long solves;                  /* Records times passes */
+	long contradictions;          /* Per pass */
+	long mismatches;              /* Records the engine answered differently, per pass */
+	long elapsedNanos;
+	double linesPerSecond;
+} LineReplay;
+
+SolveStatus solveSingleLine (LineEngine, const int *, int, int, uint64_t *, uint64_t *);
+
+bool startLineCapture (FILE *);
+
+void stopLineCapture (void);
+
+void captureLineSolve (const Line *, uint64_t, uint64_t, bool, uint64_t, uint64_t);
+
+LineRecord * readLineCapture (FILE *, int *, char *, size_t);
+
+SolveStatus replayLineCapture (const LineRecord *, int, LineEngine, int, LineReplay *);
+
+const char * lineEngineName (LineEngine);
+
+#endif
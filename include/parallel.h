@@ -0,0 +1,21 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdbool.h>
+
+typedef void (* ParallelTask) (void *, int);
+
+/* Tasks running on the pool behind runParallel(), see queueParallel() */
+typedef struct ParallelJob ParallelJob;
+
+int getWorkerCount (void);
+
+void setWorkerCount (int);
+
+void runParallel (ParallelTask, void *, int);
+
+ParallelJob * queueParallel (ParallelTask, void *, int, int);
+
+void finishParallel (ParallelJob *);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef PATTERN_TABLE_H
+#define PATTERN_TABLE_H
+
+#include <stdint.h>
+#include "../include/utility.h"
+
+/* Longest line whose placements are tabled, its clues packing into one word */
+#define PATTERN_TABLE_MAX_SIZE 20
+
+bool lookupPatterns (const int *, int, int, const uint64_t **, int *);
+
+#endif
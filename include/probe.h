@@ -0,0 +1,8 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include "../include/puzzle.h"
+
+SolveStatus probePuzzle (Puzzle *);
+
+#endif
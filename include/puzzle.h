@@ -0,0 +1,83 @@
+#ifndef PUZZLE_H
+#define PUZZLE_H
+
+#include "../include/utility.h"
+#include "../include/lineCache.h"
+#include "../include/speculate.h"
+
+typedef struct Puzzle {
+	int width;
+	int length;
+	int iterations;
+	LineClue ** lineClues;
+	Line ** lines;
+	int * gameBoard;
+	int * rowsToUpdate;
+	int * columnsToUpdate;
+	int * columnPartialSolution;
+	int * probeStamps;
+	int * lineKeys;
+	LineCache * lineCache;
+	bool sharedLineCache;
+	long deadline;
+	size_t permutationBudget;
+	size_t permutationBytes;
+	size_t spillLimit;         /* Largest spill file per line, 0 for SPILL_DEFAULT_BYTES */
+	atomic_bool * cancel;
+	long stepUnits;
+	long stepDone;
+	long stepDeadline;
+	Speculation * speculation;
+	bool speculated;
+	ProgressCallback progress;
+	void * progressContext;
+	int progressCells;
+	long startNanos;
+	unsigned char * reportedCells;
+	int * newCells;
+	int reportedCount;
+} Puzzle;
+
+bool validateClues (LineClue **, int, int);
+
+Puzzle * createPuzzle (LineClue **, int, int);
+
+Puzzle * createPuzzleWithCache (LineClue **, int, int, LineCache *);
+
+void freeLineClues (LineClue **, int);
+
+void freePuzzle (Puzzle *);
+
+long monotonicNanos (void);
+
+void setSolveOptions (Puzzle *, const SolveOptions *);
+
+void setStepBudget (Puzzle *, long, long);
+
+SolveStatus checkDeadline (Puzzle *);
+
+SolveStatus checkLimits (Puzzle *);
+
+void reportProgress (Puzzle *, ProgressStage, SolveStatus);
+
+void markAllDirty (Puzzle *);
+
+SolveStatus propagateRules (Puzzle *);
+
+SolveStatus propagatePuzzle (Puzzle *);
+
+SolveStatus resumePropagation (Puzzle *);
+
+void endSpeculation (Puzzle *);
+
+void readBoardLine (Puzzle *, const int *, int, uint64_t *, uint64_t *);
+
+bool writeBoardLine (Puzzle *, int *, int, uint64_t, uint64_t, int *);
+
+bool solveBoardLine (Puzzle *, int, uint64_t *, uint64_t *);
+
+bool propagateBoard (Puzzle *, int *, int *);
+
+int adoptBoard (Puzzle *, const int *);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "../include/puzzle.h"
+
+SolveStatus searchPuzzle (Puzzle *, const int *, int, long, long *);
+
+#endif
@@ -11,12 +11,36 @@ int totalRemainingLength (Line *, int);
 
 void updateBitMasks(Line *, const int *);
 
-void filterPermutations (Line *);
+bool checkEnumerationGuard (EnumerationGuard *);
 
-void generateConsistentPattern (Line *);
+bool enumeratePermutations (Line *);
+
+bool buildCellIndex (Line *);
+
+bool filterPermutations (Line *);
+
+bool generateConsistentPattern (Line *);
+
+bool solveLineState (Line *, uint64_t *, uint64_t *);
 
 int minRequiredLength (Line *);
 
 void overlap (Line *);
 
+bool applyLineRules (Line *);
+
+bool isLineFeasible (Line *, uint64_t, uint64_t);
+
+bool solveLinePlacements (Line *, uint64_t *, uint64_t *);
+
+double countPlacements (Line *);
+
+bool isLineSolved (Line *);
+
+void moveLinePermutations (Line *, Line *);
+
+void clearLinePermutations (Line *);
+
+void freeLine (Line *);
+
 #endif
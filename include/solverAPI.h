@@ -2,7 +2,60 @@
 #define SOLVER_API_H
 
 #include <stdio.h>
+#include "../include/gameBoard.h"
+#include "../include/lineCache.h"
+#include "../include/utility.h"
 
-int * solvePuzzle (FILE *, char, int *);
+/* How solvePuzzle() finishes a puzzle once line logic and probing stall */
+typedef enum SearchEngine {
+	SEARCH_CDCL = 0,
+	SEARCH_PARALLEL
+} SearchEngine;
+
+/* Receives each solution (gameboard, width, length) and the caller's context */
+typedef void (* SolutionCallback) (const int *, int, int, void *);
+
+/*
+ * Outcome of a solve through a SolverContext. The context owns it (gameBoard included)
+ * until its next solve or freeSolverContext().
+ */
+typedef struct SolveResult {
+	SolveStatus status;
+	int width;
+	int length;
+	int * gameBoard;      /* Row major, 1 filled, 0 empty, -1 unsolved; NULL without a board */
+	int iterations;       /* Line propagation passes */
+	long elapsedNanos;    /* Wall time of the call (of every step so far), parsing included */
+	long cacheLookups;    /* Line cache lookups and hits, see lineCacheStats() */
+	long cacheHits;
+	char error[256];      /* Why the input was rejected, for SOLVE_INVALID_INPUT */
+} SolveResult;
+
+/* Reentrant solver state: one per thread, or one per puzzle solved step-wise */
+typedef struct SolverContext SolverContext;
+
+void setSearchEngine (SearchEngine);
+
+void setBoardFormat (BoardFormat);
+
+int * solvePuzzle (FILE *, char, int *, SolveStatus *);
+
+int * solvePuzzleWithOptions (FILE *, char, int *, SolveStatus *, const SolveOptions *);
+
+SolveStatus countSolutions (FILE *, long, SolutionCallback, void *, long *, int *, const SolveOptions *);
+
+SolverContext * createSolverContext (const SolveOptions *, SearchEngine);
+
+void freeSolverContext (SolverContext *);
+
+void shareLineCache (SolverContext *, LineCache *);
+
+const SolveResult * solveBuffer (SolverContext *, const char *, size_t);
+
+const SolveResult * solveClues (SolverContext *, int, int, const int * const *, const int *);
+
+const SolveResult * beginSolve (SolverContext *, const char *, size_t);
+
+const SolveResult * stepSolve (SolverContext *, long, long);
 
 #endif
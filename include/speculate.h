@@ -0,0 +1,17 @@
+#ifndef SPECULATE_H
+#define SPECULATE_H
+
+#include "../include/utility.h"
+
+struct Puzzle;
+
+/* Lines being enumerated ahead of the propagation sweep, see startSpeculation() */
+typedef struct Speculation Speculation;
+
+Speculation * startSpeculation (struct Puzzle *);
+
+Line * takeSpeculation (Speculation *, int);
+
+void stopSpeculation (Speculation *);
+
+#endif
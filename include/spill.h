@@ -0,0 +1,42 @@
+#ifndef SPILL_H
+#define SPILL_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../include/utility.h"
+
+/* Permutations moved per sequential read or write of a spill file (8 MB) */
+#define SPILL_CHUNK_WORDS (1 << 20)
+
+/* Lines with more placements than this are spilled whatever memory is free: an int cannot
+	count them */
+#define SPILL_MIN_PLACEMENTS ((double)INT_MAX)
+
+/* Largest spill file a line may write (1 GB) unless SolveOptions.spillBytes says otherwise,
+	bigger lines are solved without permutations */
+#define SPILL_DEFAULT_BYTES (1024.0 * 1024 * 1024)
+
+/*
+ * A line's permutations kept in an anonymous temporary file instead of memory, for lines
+ * too large to enumerate in RAM. Every permutation in the file agrees with the line's
+ * appliedMaskBits, the file holds count of them from its start.
+ */
+typedef struct PermutationSpill {
+	FILE * file;
+	uint64_t count;
+	uint64_t * chunk;          /* chunkWords permutations, the buffer of every transfer */
+	size_t chunkWords;
+} PermutationSpill;
+
+struct Puzzle;
+
+bool needsSpill (double, int);
+
+SolveStatus spillPermutations (Line *, struct Puzzle *);
+
+SolveStatus filterSpilledPermutations (Line *, struct Puzzle *);
+
+void freeSpill (PermutationSpill *);
+
+#endif
@@ -1,33 +1,132 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "../include/bitSet.h"
 
 #define TRUE 1
 #define FALSE 0
 
+/* Upper bounds imposed by the file format (clues per line and colours, 'a' to 'p') and
+	uint64_t line storage */
+#define MAX_CLUES 32
+#define MAX_COLOURS 16
+#define MAX_LINE_SIZE 64
+
+/*
+ * Outcome of solving a puzzle, or of one stage of the solve (SOLVE_IN_PROGRESS). SOLVE_PAUSED
+ * ends a step of a step-wise solve (see stepSolve()) with work left.
+ */
+typedef enum SolveStatus {
+	SOLVE_SOLVED = 0,
+	SOLVE_IN_PROGRESS,
+	SOLVE_INCOMPLETE,
+	SOLVE_UNSATISFIABLE,
+	SOLVE_INVALID_INPUT,
+	SOLVE_OUT_OF_MEMORY,
+	SOLVE_TIMED_OUT,
+	SOLVE_CANCELLED,
+	SOLVE_PAUSED
+} SolveStatus;
+
+/* Where a progress report (see SolveProgress) was made */
+typedef enum ProgressStage {
+	PROGRESS_RULES = 0,
+	PROGRESS_SWEEP,
+	PROGRESS_PROBE,
+	PROGRESS_DONE
+} ProgressStage;
+
+/*
+ * A report on a solve in flight, made after each rule pass and line sweep, after each
+ * probe that solves cells, and once when the solve ends (PROGRESS_DONE, with its status).
+ * The cells and gameboard belong to the solver and are only valid during the callback.
+ */
+typedef struct SolveProgress {
+	ProgressStage stage;
+	SolveStatus status;        /* SOLVE_IN_PROGRESS until PROGRESS_DONE */
+	int width;
+	int length;
+	int iterations;            /* Line propagation passes so far */
+	int solvedCells;           /* Of width * length */
+	int newCellCount;
+	const int * newCells;      /* Cells (row major) solved since the last report */
+	const int * gameBoard;     /* 1 filled, 0 empty, -1 unsolved */
+	long elapsedNanos;
+} SolveProgress;
+
+/* Receives each progress report and the caller's context */
+typedef void (* ProgressCallback) (const SolveProgress *, void *);
+
+/*
+ * Bounds on one solve, a zero (or NULL) field sets no bound:
+ * - timeLimitMillis  : Wall clock time allowed, the solve stops with SOLVE_TIMED_OUT.
+ * - permutationBytes : Memory allowed for stored permutations. Lines that would exceed it
+ *                      are solved without enumerating their permutations.
+ * - cancel           : Set (from any thread) to stop the solve with SOLVE_CANCELLED.
+ * - spillBytes       : Largest temporary file a line too big for memory may keep its
+ *                      permutations in. Zero keeps the default of SPILL_DEFAULT_BYTES.
+ * And optionally how it reports progress, called on the solving thread:
+ * - progress         : Receives each report (see SolveProgress), with progressContext.
+ * - progressCells    : Holds reports back until at least this many cells are newly solved,
+ *                      0 reports every pass. The final report always goes out.
+ */
+typedef struct SolveOptions {
+	long timeLimitMillis;
+	size_t permutationBytes;
+	atomic_bool * cancel;
+	ProgressCallback progress;
+	void * progressContext;
+	int progressCells;
+	size_t spillBytes;
+} SolveOptions;
+
 typedef struct LineClue {
 	int * clues;
 	int clueCount;
+	int * colours;    /* Colour (1 based) of each clue, NULL when every clue is colour 1 */
 } LineClue;
 
+/*
+ * Lets enumeration running off the solving thread be abandoned: stop is raised by its
+ * owner or once the cancel flag (NULL for none) is set or the deadline (0 for none) has
+ * passed, see checkEnumerationGuard().
+ */
+typedef struct EnumerationGuard {
+	atomic_bool stop;
+	atomic_bool * cancel;
+	long deadline;
+} EnumerationGuard;
+
 typedef struct Line {
 	int lineId;
 	int permutationCount;
 	int storeCount;
+	int liveCount;
 	int size;
 	BitSet * bitSet;
 	struct LineClue * clueSet;
 	uint64_t * permutations;
+	uint64_t * cellWords;
+	int * cellCounts;
 	uint64_t partialBits;
 	uint64_t maskBits;
+	uint64_t appliedMaskBits;
+	bool sharedPermutations;
+	struct PermutationSpill * spill;   /* Permutations kept on disk instead, see spill.h */
+	struct EnumerationGuard * guard;   /* Abandons enumeration when stopped, NULL for none */
 } Line;
 
 LineClue * createLineClueSet (int *, int);
 
+LineClue * createColourClueSet (int *, int *, int);
+
 void printLineDetails (Line *);
 
 void printFormattedTime (long);
 
+const char * solveStatusName (SolveStatus);
+
 #endif
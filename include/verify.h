@@ -0,0 +1,19 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <stdint.h>
+#include "../include/utility.h"
+
+bool lineMatchesClues (uint64_t, int, const LineClue *);
+
+void packGameBoard (const int *, int, int, uint64_t *, uint64_t *);
+
+int verifyPackedBoard (LineClue **, int, int, const uint64_t *);
+
+int checkPackedBoard (LineClue **, int, int, const uint64_t *, const uint64_t *);
+
+int verifyGameBoard (LineClue **, int, int, const int *);
+
+int checkGameBoard (LineClue **, int, int, const int *);
+
+#endif
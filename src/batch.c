@@ -0,0 +1,360 @@
+#include "../include/batch.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../include/verify.h"
+
+/*
+ * Solves many small puzzles of the same dimensions together. Solving them one by one
+ * through solveClues() spends most of the time building and freeing each puzzle's lines,
+ * permutation sets and caches; here up to BATCH_LANES puzzles, one per lane, are
+ * bit-sliced across words: every cell is a pair of words (filled, empty) with a bit per
+ * lane, and every clue a word per clue index and length holding the lanes whose clue it
+ * is. One pass over a line then solves it for all lanes at once.
+ *
+ * A line is solved exactly by the usual dynamic program over (clues placed, cells
+ * passed) run forwards and backwards, except that each state is the word of lanes that
+ * can reach it: placing clue j of length len from cell p carries the lanes with that clue
+ * (clueIs[line][j][len]) whose cells p to p + len - 1 may all be filled. A cell can be
+ * filled in the lanes where a block covering it joins a forward and a backward state, and
+ * empty where a gap there does, so the lanes in only one of the two have solved it. Which
+ * lanes still have to solve a line is a word per line, so a sweep skips lines no lane
+ * changed and a pass only carries the lanes that did. Lanes the sweeps leave unfinished
+ * (those that need probing or search) are handed to the scalar solver.
+ */
+
+/* Puzzles propagated together, one bit of a lane word each */
+#define BATCH_LANES 64
+
+/* Lines of a batch puzzle: rows, then columns, as the clues are numbered */
+#define BATCH_MAX_LINES (2 * BATCH_MAX_SIZE)
+
+/* Most clues a line of BATCH_MAX_SIZE cells holds, blocks and gaps alternating */
+#define BATCH_MAX_CLUES ((BATCH_MAX_SIZE + 1) / 2)
+
+typedef struct BatchLanes {
+	int width;
+	int length;
+	uint64_t filled[BATCH_MAX_SIZE][BATCH_MAX_SIZE];  /* Lanes with cell (row, column) filled */
+	uint64_t empty[BATCH_MAX_SIZE][BATCH_MAX_SIZE];   /* Lanes with it empty */
+	uint64_t clueIs[BATCH_MAX_LINES][BATCH_MAX_CLUES][BATCH_MAX_SIZE + 1];
+	uint64_t clueCountIs[BATCH_MAX_LINES][BATCH_MAX_CLUES + 1];
+	int maxClues[BATCH_MAX_LINES];    /* Most clues any lane has on the line */
+	int maxLength[BATCH_MAX_LINES][BATCH_MAX_CLUES];  /* Longest clue j of any lane */
+	uint64_t dirty[BATCH_MAX_LINES];  /* Lanes that have to solve the line */
+	uint64_t failed;                  /* Lanes whose clues contradict */
+} BatchLanes;
+
+/*
+ * Clears the cells and clues of every lane, for the next group of puzzles.
+ */
+static void clearLanes (BatchLanes * lanes)
+{
+	memset(lanes->filled, 0, sizeof(lanes->filled));
+	memset(lanes->empty, 0, sizeof(lanes->empty));
+	memset(lanes->clueIs, 0, sizeof(lanes->clueIs));
+	memset(lanes->clueCountIs, 0, sizeof(lanes->clueCountIs));
+	memset(lanes->maxClues, 0, sizeof(lanes->maxClues));
+	memset(lanes->maxLength, 0, sizeof(lanes->maxLength));
+
+	return;
+}
+
+/*
+ * Adds a puzzle's clues to a lane. Returns FALSE, leaving the lane's clues unset, if a
+ * line's clues are malformed or cannot fit it, leaving the scalar solver to report why.
+ */
+static bool loadLane (BatchLanes * lanes, int lane, const BatchPuzzle * puzzle)
+{
+	int i, j, size, required;
+	const uint64_t laneBit = 1ULL << lane;
+
+	for (i = 0; i < lanes->width + lanes->length; ++i)
+	{
+		size = (i < lanes->length) ? lanes->width : lanes->length;
+
+		if (puzzle->clueCounts[i] < 0 || puzzle->clueCounts[i] > BATCH_MAX_CLUES || (puzzle->clueCounts[i] > 0 && puzzle->clues[i] == NULL))
+			return FALSE;
+
+		for (j = 0, required = puzzle->clueCounts[i] - 1; j < puzzle->clueCounts[i]; ++j)
+		{
+			if (puzzle->clues[i][j] < 1 || puzzle->clues[i][j] > size)
+				return FALSE;
+
+			required += puzzle->clues[i][j];
+		}
+
+		if (required > size)
+			return FALSE;
+	}
+
+	for (i = 0; i < lanes->width + lanes->length; ++i)
+	{
+		for (j = 0; j < puzzle->clueCounts[i]; ++j)
+		{
+			lanes->clueIs[i][j][puzzle->clues[i][j]] |= laneBit;
+
+			if (puzzle->clues[i][j] > lanes->maxLength[i][j])
+				lanes->maxLength[i][j] = puzzle->clues[i][j];
+		}
+
+		lanes->clueCountIs[i][puzzle->clueCounts[i]] |= laneBit;
+
+		if (puzzle->clueCounts[i] > lanes->maxClues[i])
+			lanes->maxClues[i] = puzzle->clueCounts[i];
+	}
+
+	return TRUE;
+}
+
+/*
+ * Solves one line for the given lanes: in each lane the cells every placement of its
+ * clues consistent with its known cells agrees on become known and the crossing lines
+ * are marked to be solved in that lane. Lanes with no consistent placement fail.
+ *
+ * reach[j][p] holds the lanes that can have placed clues 0 to j - 1 in the first p cells
+ * with cell p free to start a block, reachEnded[j][p] those that just ended block j - 1
+ * at cell p, so cell p must stay empty. The backward pass keeps of each state the lanes
+ * that can also place their remaining clues in the cells after it (rest and restEnded).
+ * Only a gap enters a free state, and a lane's clue j has a single length, so a lane in
+ * rest[j][p + 1] can leave cell p empty and one in restEnded[j + 1][q] has clue j end at
+ * cell q.
+ */
+static void solveLaneLine (BatchLanes * lanes, int line, uint64_t active)
+{
+	int j, p, len, maxLength, cross;
+	const bool row = line < lanes->length;
+	const int size = row ? lanes->width : lanes->length;
+	const int clueCount = lanes->maxClues[line];
+	const uint64_t (* clueIs)[BATCH_MAX_SIZE + 1] = lanes->clueIs[line];
+	uint64_t * filled[BATCH_MAX_SIZE], * empty[BATCH_MAX_SIZE], mayFill[BATCH_MAX_SIZE], mayEmpty[BATCH_MAX_SIZE];
+	uint64_t reach[BATCH_MAX_CLUES + 1][BATCH_MAX_SIZE + 1], reachEnded[BATCH_MAX_CLUES + 1][BATCH_MAX_SIZE + 1];
+	uint64_t rest[BATCH_MAX_CLUES + 1][BATCH_MAX_SIZE + 1], restEnded[BATCH_MAX_CLUES + 1][BATCH_MAX_SIZE + 1];
+	uint64_t canFill[BATCH_MAX_SIZE] = { 0 }, canEmpty[BATCH_MAX_SIZE] = { 0 };
+	uint64_t run, covered, solved, feasible = 0ULL;
+
+	/* Row r's cell c is column c's cell r */
+	for (p = 0; p < size; ++p)
+	{
+		filled[p] = row ? &lanes->filled[line][p] : &lanes->filled[p][line - lanes->length];
+		empty[p] = row ? &lanes->empty[line][p] : &lanes->empty[p][line - lanes->length];
+		mayFill[p] = ~*empty[p];
+		mayEmpty[p] = ~*filled[p];
+	}
+
+	memset(reach, 0, sizeof(reach));
+	memset(reachEnded, 0, sizeof(reachEnded));
+	reach[0][0] = active;
+
+	for (p = 0; p < size; ++p)
+		for (j = 0; j <= clueCount; ++j)
+		{
+			reach[j][p + 1] |= (reach[j][p] | reachEnded[j][p]) & mayEmpty[p];
+
+			if (j == clueCount || reach[j][p] == 0ULL)
+				continue;
+
+			maxLength = (lanes->maxLength[line][j] < size - p) ? lanes->maxLength[line][j] : size - p;
+
+			for (len = 1, run = reach[j][p]; len <= maxLength && run != 0ULL; ++len)
+			{
+				run &= mayFill[p + len - 1];
+				reachEnded[j + 1][p + len] |= run & clueIs[j][len];
+			}
+		}
+
+	/* A lane is at the end only with all its clues placed */
+	for (j = 0; j <= clueCount; ++j)
+	{
+		rest[j][size] = reach[j][size] & lanes->clueCountIs[line][j];
+		restEnded[j][size] = reachEnded[j][size] & lanes->clueCountIs[line][j];
+		feasible |= rest[j][size] | restEnded[j][size];
+	}
+
+	lanes->failed |= active & ~feasible;
+
+	if (feasible == 0ULL)
+		return;
+
+	for (p = size - 1; p >= 0; --p)
+		for (j = clueCount; j >= 0; --j)
+		{
+			rest[j][p] = reach[j][p] & mayEmpty[p] & rest[j][p + 1];
+			restEnded[j][p] = reachEnded[j][p] & mayEmpty[p] & rest[j][p + 1];
+			canEmpty[p] |= rest[j][p + 1];
+
+			if (j == clueCount || reach[j][p] == 0ULL)
+				continue;
+
+			maxLength = (lanes->maxLength[line][j] < size - p) ? lanes->maxLength[line][j] : size - p;
+
+			for (len = 1, run = reach[j][p]; len <= maxLength && run != 0ULL; ++len)
+			{
+				run &= mayFill[p + len - 1];
+				rest[j][p] |= run & clueIs[j][len] & restEnded[j + 1][p + len];
+			}
+		}
+
+	/* Clue j - 1 ending at cell q covers the len cells before it, collected longest first */
+	for (j = 1; j <= clueCount; ++j)
+		for (p = 1; p <= size; ++p)
+		{
+			if (restEnded[j][p] == 0ULL)
+				continue;
+
+			maxLength = (lanes->maxLength[line][j - 1] < p) ? lanes->maxLength[line][j - 1] : p;
+
+			for (len = maxLength, covered = 0ULL; len >= 1; --len)
+			{
+				covered |= restEnded[j][p] & clueIs[j - 1][len];
+				canFill[p - len] |= covered;
+			}
+		}
+
+	for (p = 0; p < size; ++p)
+	{
+		solved = feasible & (canFill[p] ^ canEmpty[p]) & ~(*filled[p] | *empty[p]);
+
+		if (solved == 0ULL)
+			continue;
+
+		*filled[p] |= solved & canFill[p];
+		*empty[p] |= solved & canEmpty[p];
+
+		cross = row ? lanes->length + p : p;
+		lanes->dirty[cross] |= solved;
+	}
+
+	return;
+}
+
+/*
+ * Sweeps the lines until no lane has a line left to solve.
+ */
+static void propagateLanes (BatchLanes * lanes, uint64_t active)
+{
+	int line;
+	bool progress = TRUE;
+	uint64_t pending;
+	const int lineCount = lanes->width + lanes->length;
+
+	lanes->failed = 0ULL;
+	for (line = 0; line < lineCount; ++line)
+		lanes->dirty[line] = active;
+
+	while (progress)
+	{
+		progress = FALSE;
+
+		for (line = 0; line < lineCount; ++line)
+		{
+			pending = lanes->dirty[line] & ~lanes->failed;
+			lanes->dirty[line] = 0ULL;
+
+			if (pending == 0ULL)
+				continue;
+
+			solveLaneLine(lanes, line, pending);
+			progress = TRUE;
+		}
+	}
+
+	return;
+}
+
+/*
+ * Solves a puzzle of the batch with the scalar solver.
+ */
+static void solveScalar (SolverContext * context, int width, int length, const BatchPuzzle * puzzle, BatchResult * result)
+{
+	const SolveResult * solved = solveClues(context, width, length, puzzle->clues, puzzle->clueCounts);
+
+	result->status = solved->status;
+	result->searched = TRUE;
+
+	if (solved->status == SOLVE_SOLVED)
+		packGameBoard(solved->gameBoard, width, length, result->rows, NULL);
+
+	return;
+}
+
+/*
+ * Solves a batch of puzzles of the same dimensions, up to BATCH_MAX_SIZE each way,
+ * propagating them in lanes and finishing those line logic alone cannot with the scalar
+ * solver (see solveClues()). Meant for large volumes of small puzzles, where building a
+ * puzzle for each costs more than solving it.
+ *
+ * Parameters:
+ * - context : Finishes the puzzles that need more than line logic, under its options.
+ * - width, length : The dimensions of every puzzle, each between 1 and BATCH_MAX_SIZE.
+ * - puzzles : count puzzles.
+ * - results : Receives count results, in the order of puzzles.
+ *
+ * Return:
+ * - The number of puzzles the scalar solver finished (or rejected), or -1 if the
+ *   dimensions are out of range or memory runs out, with no results written.
+ */
+int solveBatch (SolverContext * context, int width, int length, const BatchPuzzle * puzzles, BatchResult * results, int count)
+{
+	int first, lane, laneCount, row, column, scalarCount = 0;
+	uint64_t active, complete;
+	BatchLanes * lanes = NULL;
+
+	if (width < 1 || width > BATCH_MAX_SIZE || length < 1 || length > BATCH_MAX_SIZE || count < 0)
+		return -1;
+
+	lanes = (BatchLanes *)malloc(sizeof(BatchLanes));
+	if (lanes == NULL)
+		return -1;
+
+	lanes->width = width;
+	lanes->length = length;
+
+	for (first = 0; first < count; first += BATCH_LANES)
+	{
+		laneCount = (count - first < BATCH_LANES) ? count - first : BATCH_LANES;
+		active = 0ULL;
+		clearLanes(lanes);
+
+		for (lane = 0; lane < laneCount; ++lane)
+		{
+			memset(&results[first + lane], 0, sizeof(BatchResult));
+
+			if (loadLane(lanes, lane, &puzzles[first + lane]))
+				active |= 1ULL << lane;
+		}
+
+		propagateLanes(lanes, active);
+
+		/* Lanes with every cell known are solved */
+		complete = active & ~lanes->failed;
+		for (row = 0; row < length; ++row)
+			for (column = 0; column < width; ++column)
+				complete &= lanes->filled[row][column] | lanes->empty[row][column];
+
+		for (lane = 0; lane < laneCount; ++lane)
+		{
+			if ((active & lanes->failed) >> lane & 1ULL)
+			{
+				results[first + lane].status = SOLVE_UNSATISFIABLE;
+				continue;
+			}
+
+			if (!(complete >> lane & 1ULL))
+			{
+				solveScalar(context, width, length, &puzzles[first + lane], &results[first + lane]);
+				++scalarCount;
+				continue;
+			}
+
+			results[first + lane].status = SOLVE_SOLVED;
+
+			for (row = 0; row < length; ++row)
+				for (column = 0; column < width; ++column)
+					results[first + lane].rows[row] |= (lanes->filled[row][column] >> lane & 1ULL) << column;
+		}
+	}
+
+	free(lanes);
+
+	return scalarCount;
+}
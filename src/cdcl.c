@@ -0,0 +1,1123 @@
+#include "../include/cdcl.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../include/lineSolve.h"
+#include "../include/solver.h"
+
+/*
+ * Conflict driven clause learning over the cells of a puzzle.
+ *
+ * Every cell is a variable, a literal is 2 * cell + 1 for "cell is empty" and 2 * cell for
+ * "cell is filled". The clue constraints are never written out as clauses: each line acts
+ * as a propagator through solveLinePlacements(), and every cell it forces is given an
+ * explanation clause (the forced literal or the negation of the line's other assigned
+ * cells). Explanations are built lazily, only for the cells conflict analysis visits, and
+ * shrunk to the cells that still force the deduction. Learned clauses are kept in a
+ * clause database with two watched literals.
+ */
+
+#define REASON_DECISION 0
+#define REASON_CLAUSE 1
+#define REASON_LINE 2
+
+#define RESTART_BASE 100
+#define LEARNED_BASE 4000
+#define ACTIVITY_DECAY 0.95
+#define ACTIVITY_LIMIT 1e100
+
+typedef struct IntVector {
+	int * data;
+	int size;
+	int capacity;
+} IntVector;
+
+struct Cdcl {
+	Puzzle * puzzle;
+	const int * cells;
+	int cellCount;
+	int varCount;
+	int lineCount;
+	int decisionLevel;
+	int trailSize;
+	int queueHead;
+	int * value;
+	int * level;
+	int * reasonKind;
+	int * reasonRef;
+	int * trail;
+	int * trailLim;
+	int * trailPos;
+	int * lineDirty;
+	char * seen;
+	char * phase;
+	double * activity;
+	double activityIncrement;
+	int * heap;
+	int * heapIndex;
+	int heapSize;
+	IntVector explanation;
+	IntVector * explained;
+	IntVector clauseLits;
+	IntVector clauseStart;
+	IntVector learned;
+	IntVector permanent;
+	IntVector * watches;
+	long conflicts;
+	long restartCount;
+	long conflictsUntilRestart;
+	long learnedLimit;
+	long found;
+};
+
+/*
+ * Appends a value to an IntVector, growing it as needed. Returns FALSE if growing fails.
+ */
+static bool pushInt (IntVector * vector, int item)
+{
+	int * grown;
+	int capacity;
+
+	if (vector->size == vector->capacity)
+	{
+		capacity = (vector->capacity == 0) ? 16 : vector->capacity * 2;
+		grown = (int *)realloc(vector->data, sizeof(int) * capacity);
+		if (grown == NULL)
+			return FALSE;
+
+		vector->data = grown;
+		vector->capacity = capacity;
+	}
+
+	vector->data[vector->size++] = item;
+
+	return TRUE;
+}
+
+static int literalOf (int cell, int filled)
+{
+	return (cell << 1) | (filled ? 0 : 1);
+}
+
+static bool isTrue (Cdcl * solver, int literal)
+{
+	return solver->value[literal >> 1] == 1 - (literal & 1);
+}
+
+static bool isFalse (Cdcl * solver, int literal)
+{
+	return solver->value[literal >> 1] == (literal & 1);
+}
+
+/*
+ * Returns the cell at position i of a line.
+ */
+static int lineCell (Puzzle * puzzle, int index, int i)
+{
+	if (index < puzzle->length)
+		return index * puzzle->width + i;
+
+	return i * puzzle->width + (index - puzzle->length);
+}
+
+/*
+ * Makes a literal true at the current decision level and flags its row and column for
+ * the line propagators.
+ */
+static bool assign (Cdcl * solver, int literal, int kind, int ref)
+{
+	int cell = literal >> 1;
+
+	solver->value[cell] = 1 - (literal & 1);
+	solver->level[cell] = solver->decisionLevel;
+	solver->reasonKind[cell] = kind;
+	solver->reasonRef[cell] = ref;
+	solver->trailPos[cell] = solver->trailSize;
+	solver->explained[cell].size = 0;
+	solver->trail[solver->trailSize++] = literal;
+
+	solver->lineDirty[cell / solver->puzzle->width] = 1;
+	solver->lineDirty[solver->puzzle->length + (cell % solver->puzzle->width)] = 1;
+
+	return TRUE;
+}
+
+/*
+ * Returns the literals and length of a learned clause.
+ */
+static int * clauseLiterals (Cdcl * solver, int clause, int * length)
+{
+	*length = solver->clauseStart.data[clause + 1] - solver->clauseStart.data[clause];
+
+	return solver->clauseLits.data + solver->clauseStart.data[clause];
+}
+
+/*
+ * Adds a clause to the database and watches its first two literals. Permanent clauses
+ * (those blocking found solutions) survive reduceClauses().
+ * Returns the clause index or -1 if memory runs out.
+ */
+static int addClause (Cdcl * solver, const int * literals, int length, bool permanent)
+{
+	int i, index = solver->clauseStart.size - 1;
+
+	for (i = 0; i < length; ++i)
+		if (!pushInt(&solver->clauseLits, literals[i]))
+			return -1;
+
+	if (!pushInt(&solver->clauseStart, solver->clauseLits.size)
+		|| !pushInt(&solver->permanent, permanent ? 1 : 0)
+		|| !pushInt(&solver->watches[literals[0]], index)
+		|| !pushInt(&solver->watches[literals[1]], index))
+		return -1;
+
+	return index;
+}
+
+/*
+ * Unit propagation over the learned clauses for every literal assigned since the last
+ * call. Returns the index of a falsified clause, -1 if none, or -2 if memory runs out.
+ */
+static int propagateClauses (Cdcl * solver)
+{
+	int i, j, k, clause, length, falseLiteral, swap;
+	int * literals;
+	IntVector * list;
+
+	while (solver->queueHead < solver->trailSize)
+	{
+		falseLiteral = solver->trail[solver->queueHead++] ^ 1;
+		list = &solver->watches[falseLiteral];
+
+		for (i = 0, j = 0; i < list->size; ++i)
+		{
+			clause = list->data[i];
+			literals = clauseLiterals(solver, clause, &length);
+
+			/* Keep the falsified watch in position 1 */
+			if (literals[0] == falseLiteral)
+			{
+				literals[0] = literals[1];
+				literals[1] = falseLiteral;
+			}
+
+			if (isTrue(solver, literals[0]))
+			{
+				list->data[j++] = clause;
+				continue;
+			}
+
+			for (k = 2; k < length; ++k)
+				if (!isFalse(solver, literals[k]))
+					break;
+
+			if (k < length)
+			{
+				swap = literals[1];
+				literals[1] = literals[k];
+				literals[k] = swap;
+
+				if (!pushInt(&solver->watches[literals[1]], clause))
+					return -2;
+
+				continue;
+			}
+
+			list->data[j++] = clause;
+
+			if (isFalse(solver, literals[0]))
+			{
+				for (++i; i < list->size; ++i)
+					list->data[j++] = list->data[i];
+
+				list->size = j;
+
+				return clause;
+			}
+
+			assign(solver, literals[0], REASON_CLAUSE, clause);
+		}
+
+		list->size = j;
+	}
+
+	return -1;
+}
+
+/*
+ * Checks whether the line deduction still holds for the given solved cells: no placement
+ * fits at all when forcedPosition is -1, otherwise no placement gives the cell at
+ * forcedPosition any value but forcedValue.
+ */
+static bool lineForces (Puzzle * puzzle, int index, uint64_t maskBits, uint64_t partialBits, int forcedPosition, int forcedValue)
+{
+	uint64_t bit, solvedMask, solvedPartial;
+	int cached;
+
+	if (forcedPosition >= 0)
+	{
+		bit = 1ULL << forcedPosition;
+		maskBits |= bit;
+		partialBits = forcedValue ? partialBits & ~bit : partialBits | bit;
+	}
+
+	/* Only contradictions are stored, a feasibility check has no solve to record */
+	solvedMask = maskBits;
+	solvedPartial = partialBits;
+	cached = lineCacheLookup(puzzle->lineCache, puzzle->lineKeys[index], &solvedMask, &solvedPartial);
+
+	if (cached >= 0)
+		return cached == 0;
+
+	if (isLineFeasible(puzzle->lines[index], maskBits, partialBits))
+		return FALSE;
+
+	lineCacheStore(puzzle->lineCache, puzzle->lineKeys[index], maskBits, partialBits, FALSE, 0ULL, 0ULL);
+
+	return TRUE;
+}
+
+/*
+ * Builds the explanation clause of a line deduction in target: the forced
+ * literal (forced is -1 for a line conflict) followed by the negation of the line cells
+ * it depends on.
+ *
+ * The deduction was made from the line's cells assigned before the forced cell. Those
+ * are dropped one at a time, latest first, as long as the line still forces the same
+ * result, which keeps learned clauses short and their literals on early levels. Level 0
+ * cells are facts and are neither tried nor written out.
+ *
+ * Returns FALSE if memory runs out.
+ */
+static bool explainLine (Cdcl * solver, int index, int forced, IntVector * target)
+{
+	int i, j, cell, position, count = 0, forcedPosition = -1;
+	int positions[MAX_LINE_SIZE];
+	Line * line = solver->puzzle->lines[index];
+	const int limit = (forced >= 0) ? solver->trailPos[forced >> 1] : solver->trailSize;
+	uint64_t maskBits = 0ULL, partialBits = 0ULL, bit;
+
+	for (i = 0; i < line->size; ++i)
+	{
+		cell = lineCell(solver->puzzle, index, i);
+
+		if (forced >= 0 && cell == (forced >> 1))
+			forcedPosition = i;
+
+		if (solver->value[cell] == -1 || solver->trailPos[cell] >= limit)
+			continue;
+
+		maskBits |= 1ULL << i;
+		partialBits |= (uint64_t)solver->value[cell] << i;
+
+		if (solver->level[cell] == 0)
+			continue;
+
+		/* Insertion sort, latest assignment first */
+		for (j = count++; j > 0 && solver->trailPos[lineCell(solver->puzzle, index, positions[j - 1])] < solver->trailPos[cell]; --j)
+			positions[j] = positions[j - 1];
+
+		positions[j] = i;
+	}
+
+	for (i = 0; i < count; ++i)
+	{
+		bit = 1ULL << positions[i];
+
+		if (lineForces(solver->puzzle, index, maskBits & ~bit, partialBits & ~bit, forcedPosition, 1 - (forced & 1)))
+		{
+			maskBits &= ~bit;
+			partialBits &= ~bit;
+			positions[i] = -1;
+		}
+	}
+
+	target->size = 0;
+
+	if (forced >= 0 && !pushInt(target, forced))
+		return FALSE;
+
+	for (i = 0; i < count; ++i)
+	{
+		position = positions[i];
+		if (position < 0)
+			continue;
+
+		cell = lineCell(solver->puzzle, index, position);
+
+		if (!pushInt(target, literalOf(cell, !solver->value[cell])))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Returns the literals and length of the clause a (kind, ref) pair stands for, literal
+ * being the literal it implied (-1 for a conflict). A cell's line explanation is kept
+ * until the cell is reassigned, since analysis keeps revisiting the same early cells.
+ * Returns NULL if memory runs out.
+ */
+static int * reasonOf (Cdcl * solver, int kind, int ref, int literal, int * length)
+{
+	IntVector * target;
+
+	if (kind == REASON_CLAUSE)
+		return clauseLiterals(solver, ref, length);
+
+	target = (literal < 0) ? &solver->explanation : &solver->explained[literal >> 1];
+
+	if ((literal < 0 || target->size == 0) && !explainLine(solver, ref, literal, target))
+		return NULL;
+
+	*length = target->size;
+
+	return target->data;
+}
+
+/*
+ * solveLinePlacements() for line index, answered from the line cache when the same
+ * known cells were solved before: restarts and backjumps keep bringing lines back to
+ * states already seen.
+ */
+static bool solveCachedPlacements (Puzzle * puzzle, int index, uint64_t * maskBits, uint64_t * partialBits)
+{
+	const uint64_t mask = *maskBits;
+	const uint64_t partial = *partialBits;
+	int cached = lineCacheLookup(puzzle->lineCache, puzzle->lineKeys[index], maskBits, partialBits);
+	bool feasible;
+
+	if (cached >= 0)
+		return cached == 1;
+
+	feasible = solveLinePlacements(puzzle->lines[index], maskBits, partialBits);
+
+	lineCacheStore(puzzle->lineCache, puzzle->lineKeys[index], mask, partial, feasible, *maskBits, *partialBits);
+	captureLineSolve(puzzle->lines[index], mask, partial, feasible, *maskBits, *partialBits);
+
+	return feasible;
+}
+
+/*
+ * Runs clause and line propagation to a fixpoint.
+ *
+ * Returns 0 with no conflict, 1 with the conflicting clause in (kind, ref), or -1 if
+ * memory runs out.
+ */
+static int propagate (Cdcl * solver, int * kind, int * ref)
+{
+	int index, i, clause;
+	uint64_t maskBits, partialBits, newMask, newPartial, implied;
+	Puzzle * puzzle = solver->puzzle;
+
+	for ( ; ; )
+	{
+		clause = propagateClauses(solver);
+
+		if (clause == -2)
+			return -1;
+
+		if (clause >= 0)
+		{
+			*kind = REASON_CLAUSE;
+			*ref = clause;
+			return 1;
+		}
+
+		for (index = 0; index < solver->lineCount; ++index)
+			if (solver->lineDirty[index] == 1)
+				break;
+
+		if (index == solver->lineCount)
+			return 0;
+
+		solver->lineDirty[index] = 0;
+
+		readBoardLine(puzzle, solver->value, index, &maskBits, &partialBits);
+		newMask = maskBits;
+		newPartial = partialBits;
+
+		if (!solveCachedPlacements(puzzle, index, &newMask, &newPartial))
+		{
+			*kind = REASON_LINE;
+			*ref = index;
+			return 1;
+		}
+
+		for (implied = newMask & ~maskBits; implied != 0; implied &= implied - 1)
+		{
+			i = __builtin_ctzll(implied);
+			assign(solver, literalOf(lineCell(puzzle, index, i), (int)((newPartial >> i) & 1ULL)), REASON_LINE, index);
+		}
+	}
+}
+
+/*
+ * Binary max-heap of cells by activity, heapIndex[cell] is -1 for cells not in it.
+ */
+static void heapSwap (Cdcl * solver, int a, int b)
+{
+	int cell = solver->heap[a];
+
+	solver->heap[a] = solver->heap[b];
+	solver->heap[b] = cell;
+	solver->heapIndex[solver->heap[a]] = a;
+	solver->heapIndex[solver->heap[b]] = b;
+
+	return;
+}
+
+static void heapUp (Cdcl * solver, int position)
+{
+	while (position > 0 && solver->activity[solver->heap[(position - 1) / 2]] < solver->activity[solver->heap[position]])
+	{
+		heapSwap(solver, position, (position - 1) / 2);
+		position = (position - 1) / 2;
+	}
+
+	return;
+}
+
+static void heapDown (Cdcl * solver, int position)
+{
+	int child;
+
+	for ( ; ; )
+	{
+		child = 2 * position + 1;
+		if (child >= solver->heapSize)
+			return;
+
+		if (child + 1 < solver->heapSize && solver->activity[solver->heap[child + 1]] > solver->activity[solver->heap[child]])
+			++child;
+
+		if (solver->activity[solver->heap[child]] <= solver->activity[solver->heap[position]])
+			return;
+
+		heapSwap(solver, position, child);
+		position = child;
+	}
+}
+
+static void heapInsert (Cdcl * solver, int cell)
+{
+	if (solver->heapIndex[cell] >= 0)
+		return;
+
+	solver->heap[solver->heapSize] = cell;
+	solver->heapIndex[cell] = solver->heapSize++;
+	heapUp(solver, solver->heapSize - 1);
+
+	return;
+}
+
+static void bumpActivity (Cdcl * solver, int cell)
+{
+	int i;
+
+	solver->activity[cell] += solver->activityIncrement;
+
+	if (solver->heapIndex[cell] >= 0)
+		heapUp(solver, solver->heapIndex[cell]);
+
+	if (solver->activity[cell] > ACTIVITY_LIMIT)
+	{
+		for (i = 0; i < solver->varCount; ++i)
+			solver->activity[i] *= 1e-100;
+
+		solver->activityIncrement *= 1e-100;
+	}
+
+	return;
+}
+
+/*
+ * First unique implication point conflict analysis. Leaves the learned clause in
+ * solver->learned with the asserting literal first and a literal of the backjump level
+ * second, and returns that backjump level, or -1 if memory runs out.
+ */
+static int analyse (Cdcl * solver, int kind, int ref)
+{
+	int i, length, cell, pathCount = 0, literal = -1, trailIndex = solver->trailSize - 1;
+	int backjump = 0, highest = 1;
+	int * literals;
+
+	solver->learned.size = 0;
+	if (!pushInt(&solver->learned, -1))
+		return -1;
+
+	for ( ; ; )
+	{
+		literals = reasonOf(solver, kind, ref, literal, &length);
+		if (literals == NULL)
+			return -1;
+
+		for (i = 0; i < length; ++i)
+		{
+			cell = literals[i] >> 1;
+
+			if ((literal >= 0 && cell == (literal >> 1)) || solver->seen[cell] || solver->level[cell] == 0)
+				continue;
+
+			solver->seen[cell] = 1;
+			bumpActivity(solver, cell);
+
+			if (solver->level[cell] == solver->decisionLevel)
+				++pathCount;
+			else if (!pushInt(&solver->learned, literals[i]))
+				return -1;
+		}
+
+		while (!solver->seen[solver->trail[trailIndex] >> 1])
+			--trailIndex;
+
+		literal = solver->trail[trailIndex--];
+		cell = literal >> 1;
+		solver->seen[cell] = 0;
+
+		if (--pathCount <= 0)
+			break;
+
+		kind = solver->reasonKind[cell];
+		ref = solver->reasonRef[cell];
+	}
+
+	solver->learned.data[0] = literal ^ 1;
+
+	for (i = 1; i < solver->learned.size; ++i)
+	{
+		cell = solver->learned.data[i] >> 1;
+		solver->seen[cell] = 0;
+
+		if (solver->level[cell] > backjump)
+		{
+			backjump = solver->level[cell];
+			highest = i;
+		}
+	}
+
+	if (solver->learned.size > 1)
+	{
+		literal = solver->learned.data[1];
+		solver->learned.data[1] = solver->learned.data[highest];
+		solver->learned.data[highest] = literal;
+	}
+
+	solver->activityIncrement /= ACTIVITY_DECAY;
+
+	return backjump;
+}
+
+/*
+ * Undoes every assignment above the given level, saving each cell's value as its
+ * preferred phase.
+ */
+static void backtrack (Cdcl * solver, int level)
+{
+	int i, cell;
+
+	if (solver->decisionLevel <= level)
+		return;
+
+	for (i = solver->trailSize - 1; i >= solver->trailLim[level]; --i)
+	{
+		cell = solver->trail[i] >> 1;
+		solver->phase[cell] = (char)solver->value[cell];
+		solver->value[cell] = -1;
+		heapInsert(solver, cell);
+	}
+
+	solver->trailSize = solver->trailLim[level];
+	solver->queueHead = solver->trailSize;
+	solver->decisionLevel = level;
+
+	memset(solver->lineDirty, 0x00, sizeof(int) * solver->lineCount);
+
+	return;
+}
+
+/*
+ * Picks the unassigned cell with the highest activity, or -1 if every cell is assigned.
+ */
+static int pickBranchCell (Cdcl * solver)
+{
+	int cell;
+
+	while (solver->heapSize > 0)
+	{
+		cell = solver->heap[0];
+		solver->heapIndex[cell] = -1;
+
+		if (--solver->heapSize > 0)
+		{
+			solver->heap[0] = solver->heap[solver->heapSize];
+			solver->heapIndex[solver->heap[0]] = 0;
+			heapDown(solver, 0);
+		}
+
+		if (solver->value[cell] == -1)
+			return cell;
+	}
+
+	return -1;
+}
+
+/*
+ * Returns element i (1-based) of the Luby restart sequence 1 1 2 1 1 2 4 ...
+ */
+static long luby (long i)
+{
+	int k;
+
+	for ( ; ; )
+	{
+		for (k = 1; (1L << k) - 1 < i; ++k)
+			;
+
+		if ((1L << k) - 1 == i)
+			return 1L << (k - 1);
+
+		i -= (1L << (k - 1)) - 1;
+	}
+}
+
+/*
+ * Drops the longer half of the learned clauses at a restart (when no learned clause is
+ * the reason of an assignment above level 0) and rebuilds the watch lists.
+ */
+static void reduceClauses (Cdcl * solver)
+{
+	int i, clause, below = 0, kept = 0, litCount = 0, median;
+	int * literals, * lengths, * histogram;
+	int clauseCount = solver->clauseStart.size - 1;
+
+	lengths = (int *)malloc(sizeof(int) * clauseCount);
+	histogram = (int *)calloc(solver->varCount + 1, sizeof(int));
+	if (lengths == NULL || histogram == NULL)
+	{
+		free(lengths);
+		free(histogram);
+		return;
+	}
+
+	for (clause = 0; clause < clauseCount; ++clause)
+	{
+		lengths[clause] = solver->clauseStart.data[clause + 1] - solver->clauseStart.data[clause];
+		++histogram[lengths[clause]];
+	}
+
+	/* Median length, clauses are at most varCount long */
+	for (median = 2; median < solver->varCount; ++median)
+	{
+		below += histogram[median];
+		if (below >= clauseCount / 2)
+			break;
+	}
+
+	free(histogram);
+
+	for (i = 0; i < 2 * solver->varCount; ++i)
+		solver->watches[i].size = 0;
+
+	for (clause = 0; clause < clauseCount; ++clause)
+	{
+		if (lengths[clause] > median && !solver->permanent.data[clause])
+			continue;
+
+		literals = solver->clauseLits.data + solver->clauseStart.data[clause];
+		memmove(solver->clauseLits.data + litCount, literals, sizeof(int) * lengths[clause]);
+		solver->clauseStart.data[kept] = litCount;
+		solver->permanent.data[kept] = solver->permanent.data[clause];
+		pushInt(&solver->watches[solver->clauseLits.data[litCount]], kept);
+		pushInt(&solver->watches[solver->clauseLits.data[litCount + 1]], kept);
+		litCount += lengths[clause];
+		++kept;
+	}
+
+	solver->clauseStart.data[kept] = litCount;
+	solver->clauseStart.size = kept + 1;
+	solver->clauseLits.size = litCount;
+	solver->permanent.size = kept;
+
+	/* Level 0 assignments may name dropped clauses, their reasons are never read */
+	free(lengths);
+
+	return;
+}
+
+void freeCdcl (Cdcl * solver)
+{
+	int i;
+
+	if (solver == NULL) return;
+
+	if (solver->watches != NULL)
+		for (i = 0; i < 2 * solver->varCount; ++i)
+			free(solver->watches[i].data);
+
+	if (solver->explained != NULL)
+		for (i = 0; i < solver->varCount; ++i)
+			free(solver->explained[i].data);
+
+	free(solver->explained);
+	free(solver->watches);
+	free(solver->value);
+	free(solver->level);
+	free(solver->reasonKind);
+	free(solver->reasonRef);
+	free(solver->trail);
+	free(solver->trailLim);
+	free(solver->trailPos);
+	free(solver->lineDirty);
+	free(solver->seen);
+	free(solver->phase);
+	free(solver->activity);
+	free(solver->heap);
+	free(solver->heapIndex);
+	free(solver->explanation.data);
+	free(solver->clauseLits.data);
+	free(solver->clauseStart.data);
+	free(solver->learned.data);
+	free(solver->permanent.data);
+
+	free(solver);
+
+	return;
+}
+
+/*
+ * Excludes the solution just found by adding the clause that negates its decisions
+ * (propagation from those decisions alone produced it, so no other solution is lost),
+ * then backjumps so the clause asserts the negation of the last decision.
+ *
+ * Returns 0 when the clause was added, 1 when there were no decisions and so no other
+ * solution can exist, or -1 if memory runs out.
+ */
+static int blockSolution (Cdcl * solver)
+{
+	int level, ref;
+
+	if (solver->decisionLevel == 0)
+		return 1;
+
+	/* Latest decision first, the one before it second */
+	solver->learned.size = 0;
+	for (level = solver->decisionLevel - 1; level >= 0; --level)
+		if (!pushInt(&solver->learned, solver->trail[solver->trailLim[level]] ^ 1))
+			return -1;
+
+	backtrack(solver, solver->decisionLevel - 1);
+
+	if (solver->learned.size == 1)
+	{
+		assign(solver, solver->learned.data[0], REASON_DECISION, 0);
+		return 0;
+	}
+
+	ref = addClause(solver, solver->learned.data, solver->learned.size, TRUE);
+	if (ref < 0)
+		return -1;
+
+	assign(solver, solver->learned.data[0], REASON_CLAUSE, ref);
+
+	return 0;
+}
+
+/*
+ * Loads the gameboard's solved cells as the level 0 facts and queues the cells to search,
+ * either every unsolved cell or only the region's cells.
+ *
+ * A region is a set of unsolved cells whose rows and columns hold no other unsolved cell
+ * (see findComponents()). Only its own lines are read and propagated, so solvers working
+ * on different regions of one gameboard never touch the same cells.
+ */
+static void loadFacts (Cdcl * solver, const int * cells, int cellCount)
+{
+	int i, index, cell;
+	Puzzle * puzzle = solver->puzzle;
+
+	if (cells == NULL)
+	{
+		for (cell = 0; cell < solver->varCount; ++cell)
+			if (puzzle->gameBoard[cell] != -1)
+				assign(solver, literalOf(cell, puzzle->gameBoard[cell]), REASON_DECISION, 0);
+			else
+				heapInsert(solver, cell);
+
+		for (index = 0; index < solver->lineCount; ++index)
+			solver->lineDirty[index] = 1;
+
+		return;
+	}
+
+	for (i = 0; i < cellCount; ++i)
+	{
+		solver->seen[cells[i]] = 1;
+		heapInsert(solver, cells[i]);
+	}
+
+	for (index = 0; index < solver->lineCount; ++index)
+	{
+		for (i = 0; i < puzzle->lines[index]->size; ++i)
+			if (solver->seen[lineCell(puzzle, index, i)])
+				break;
+
+		if (i == puzzle->lines[index]->size)
+			continue;
+
+		for (i = 0; i < puzzle->lines[index]->size; ++i)
+		{
+			cell = lineCell(puzzle, index, i);
+
+			if (puzzle->gameBoard[cell] != -1 && solver->value[cell] == -1)
+				assign(solver, literalOf(cell, puzzle->gameBoard[cell]), REASON_DECISION, 0);
+		}
+	}
+
+	/* Facts flag the lines crossing them, only the region's lines are to be propagated */
+	memset(solver->lineDirty, 0x00, sizeof(int) * solver->lineCount);
+
+	for (i = 0; i < cellCount; ++i)
+	{
+		solver->seen[cells[i]] = 0;
+		solver->lineDirty[cells[i] / puzzle->width] = 1;
+		solver->lineDirty[puzzle->length + (cells[i] % puzzle->width)] = 1;
+	}
+
+	return;
+}
+
+/*
+ * Searches for a solution of a stalled puzzle with conflict driven clause learning.
+ *
+ * The current gameboard forms decision level 0. The search then alternates VSIDS style
+ * decisions (highest activity cell, saved phase) with clause and line propagation. Each
+ * conflict is analysed to its first unique implication point, the learned clause is
+ * added, and the search backjumps to the clause's second highest level. Restarts follow
+ * the Luby sequence, and the longer half of the learned clauses is dropped whenever
+ * their number passes a growing limit.
+ *
+ * cells/cellCount restrict the search to a region (see loadFacts()), cells is NULL to
+ * search every unsolved cell.
+ *
+ * Return:
+ * - SOLVE_SOLVED with the solution written to puzzle->gameBoard.
+ * - SOLVE_UNSATISFIABLE when the search space is exhausted.
+ * - SOLVE_OUT_OF_MEMORY when the solver state cannot be allocated.
+ * - SOLVE_TIMED_OUT or SOLVE_CANCELLED when the puzzle's limits stop the search, checked
+ *   before every propagation.
+ */
+SolveStatus cdclSolve (Puzzle * puzzle, const int * cells, int cellCount)
+{
+	return cdclEnumerate(puzzle, cells, cellCount, 1, NULL, NULL, NULL);
+}
+
+/*
+ * cdclSolve() that carries on past the first solution: each solution is passed to
+ * handler (if any) and then excluded with blockSolution() before the search resumes.
+ *
+ * Parameters:
+ * - puzzle        : A puzzle whose gameboard line propagation has taken as far as it can.
+ * - cells         : The region to search, NULL for every unsolved cell (see cdclSolve()).
+ * - cellCount     : Number of cells in the region.
+ * - limit         : Stop after this many solutions, 0 for no limit.
+ * - handler       : Optional, called with each solution, returning FALSE stops the search.
+ *                   Cells outside the region are -1 in the boards it is given.
+ * - context       : Passed through to handler.
+ * - solutionCount : Optional (may be NULL), receives the number of solutions found.
+ *
+ * Return:
+ * - SOLVE_SOLVED with the first solution written to puzzle->gameBoard (only the region's
+ *   cells are written).
+ * - SOLVE_UNSATISFIABLE when there is no solution.
+ * - SOLVE_OUT_OF_MEMORY when the solver state cannot be allocated.
+ * - SOLVE_TIMED_OUT or SOLVE_CANCELLED as for cdclSolve(), solutionCount then holds the
+ *   solutions found so far.
+ */
+SolveStatus cdclEnumerate (Puzzle * puzzle, const int * cells, int cellCount, long limit, SolutionHandler handler, void * context,
+	long * solutionCount)
+{
+	SolveStatus status = SOLVE_OUT_OF_MEMORY;
+	Cdcl * solver = createCdcl(puzzle, cells, cellCount);
+
+	if (solver != NULL)
+		status = resumeCdcl(solver, limit, handler, context, solutionCount);
+
+	else if (solutionCount != NULL)
+		*solutionCount = 0;
+
+	freeCdcl(solver);
+
+	return status;
+}
+
+/*
+ * Allocates the clause learning state for a search of puzzle (or of one region of it,
+ * see cdclSolve()) and loads the gameboard's solved cells as its facts. cells must stay
+ * valid until the solver is freed.
+ *
+ * Returns the solver, to be run with resumeCdcl() and freed with freeCdcl(), or NULL if
+ * memory runs out.
+ */
+Cdcl * createCdcl (Puzzle * puzzle, const int * cells, int cellCount)
+{
+	const int varCount = puzzle->width * puzzle->length;
+	Cdcl * solver = (Cdcl *)calloc(1, sizeof(Cdcl));
+
+	if (solver == NULL)
+		return NULL;
+
+	solver->puzzle = puzzle;
+	solver->cells = cells;
+	solver->cellCount = cellCount;
+	solver->varCount = varCount;
+	solver->lineCount = puzzle->width + puzzle->length;
+	solver->activityIncrement = 1.0;
+	solver->restartCount = 1;
+	solver->conflictsUntilRestart = RESTART_BASE * luby(1);
+	solver->learnedLimit = LEARNED_BASE;
+
+	solver->value = (int *)malloc(sizeof(int) * varCount);
+	solver->level = (int *)calloc(varCount, sizeof(int));
+	solver->reasonKind = (int *)calloc(varCount, sizeof(int));
+	solver->reasonRef = (int *)calloc(varCount, sizeof(int));
+	solver->trail = (int *)malloc(sizeof(int) * varCount);
+	solver->trailLim = (int *)malloc(sizeof(int) * (varCount + 1));
+	solver->trailPos = (int *)malloc(sizeof(int) * varCount);
+	solver->lineDirty = (int *)calloc(solver->lineCount, sizeof(int));
+	solver->seen = (char *)calloc(varCount, sizeof(char));
+	solver->phase = (char *)calloc(varCount, sizeof(char));
+	solver->activity = (double *)calloc(varCount, sizeof(double));
+	solver->heap = (int *)malloc(sizeof(int) * varCount);
+	solver->heapIndex = (int *)malloc(sizeof(int) * varCount);
+	solver->watches = (IntVector *)calloc(2 * varCount, sizeof(IntVector));
+	solver->explained = (IntVector *)calloc(varCount, sizeof(IntVector));
+
+	if (solver->value == NULL || solver->level == NULL || solver->reasonKind == NULL || solver->reasonRef == NULL
+		|| solver->trail == NULL || solver->trailLim == NULL || solver->trailPos == NULL || solver->lineDirty == NULL
+		|| solver->seen == NULL || solver->phase == NULL || solver->activity == NULL || solver->watches == NULL
+		|| solver->heap == NULL || solver->heapIndex == NULL || solver->explained == NULL || !pushInt(&solver->clauseStart, 0))
+	{
+		freeCdcl(solver);
+		return NULL;
+	}
+
+	memset(solver->value, 0xFF, sizeof(int) * varCount);
+	memset(solver->heapIndex, 0xFF, sizeof(int) * varCount);
+
+	loadFacts(solver, cells, cellCount);
+
+	return solver;
+}
+
+/*
+ * Runs (or carries on) a search created with createCdcl(), with the parameters and return
+ * values of cdclEnumerate().
+ *
+ * A stop by the puzzle's limits happens before a propagation, with the search state
+ * intact: after SOLVE_PAUSED (the end of a step, see setStepBudget()) calling again
+ * carries on where the search left off. solutionCount counts the solutions of every run.
+ */
+SolveStatus resumeCdcl (Cdcl * solver, long limit, SolutionHandler handler, void * context, long * solutionCount)
+{
+	int i, kind, ref, result, backjump, cell;
+	Puzzle * puzzle = solver->puzzle;
+	SolveStatus status;
+
+	for ( ; ; )
+	{
+		status = checkLimits(puzzle);
+		if (status != SOLVE_IN_PROGRESS)
+			goto cdcl_Done;
+
+		status = SOLVE_OUT_OF_MEMORY;
+		result = propagate(solver, &kind, &ref);
+
+		if (result < 0)
+			goto cdcl_Done;
+
+		if (result == 1)
+		{
+			++solver->conflicts;
+
+			if (solver->decisionLevel == 0)
+			{
+				status = (solver->found > 0) ? SOLVE_SOLVED : SOLVE_UNSATISFIABLE;
+				goto cdcl_Done;
+			}
+
+			backjump = analyse(solver, kind, ref);
+			if (backjump < 0)
+				goto cdcl_Done;
+
+			backtrack(solver, backjump);
+
+			if (solver->learned.size == 1)
+				assign(solver, solver->learned.data[0], REASON_DECISION, 0);
+
+			else
+			{
+				ref = addClause(solver, solver->learned.data, solver->learned.size, FALSE);
+				if (ref < 0)
+					goto cdcl_Done;
+
+				assign(solver, solver->learned.data[0], REASON_CLAUSE, ref);
+			}
+
+			--solver->conflictsUntilRestart;
+			continue;
+		}
+
+		if (solver->conflictsUntilRestart <= 0)
+		{
+			backtrack(solver, 0);
+			solver->conflictsUntilRestart = RESTART_BASE * luby(++solver->restartCount);
+
+			if (solver->clauseStart.size - 1 > solver->learnedLimit)
+			{
+				reduceClauses(solver);
+				solver->learnedLimit += solver->learnedLimit / 2;
+			}
+		}
+
+		cell = pickBranchCell(solver);
+
+		if (cell < 0)
+		{
+			if (++solver->found == 1 && solver->cells == NULL)
+				memcpy(puzzle->gameBoard, solver->value, sizeof(int) * solver->varCount);
+
+			else if (solver->found == 1)
+				for (i = 0; i < solver->cellCount; ++i)
+					puzzle->gameBoard[solver->cells[i]] = solver->value[solver->cells[i]];
+
+			if ((handler != NULL && !handler(solver->value, context)) || (limit > 0 && solver->found >= limit))
+			{
+				status = SOLVE_SOLVED;
+				goto cdcl_Done;
+			}
+
+			result = blockSolution(solver);
+			if (result < 0)
+				goto cdcl_Done;
+
+			if (result > 0)
+			{
+				status = SOLVE_SOLVED;
+				goto cdcl_Done;
+			}
+
+			continue;
+		}
+
+		solver->trailLim[solver->decisionLevel] = solver->trailSize;
+		++solver->decisionLevel;
+
+		assign(solver, literalOf(cell, solver->phase[cell]), REASON_DECISION, 0);
+	}
+
+cdcl_Done:
+	if (solutionCount != NULL)
+		*solutionCount = solver->found;
+
+	return status;
+}
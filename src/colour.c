@@ -0,0 +1,759 @@
+#include "../include/colour.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../include/fileIO.h"
+#include "../include/gameBoard.h"
+#include "../include/puzzle.h"
+
+/*
+ * Colour nonograms: each clue has a colour, and consecutive blocks need a blank cell
+ * between them only when they share it. A line's state is a bit plane per colour plus one
+ * for the background, so placements are checked, filtered and folded into the consensus a
+ * word per colour, as the black and white solver does with maskBits/partialBits.
+ *
+ * Lines are numbered as the clues are: rows 0..length-1, then columns length.. .
+ */
+
+/* Colour (1 based) of a line's clue */
+static int clueColour (const LineClue * clueSet, int clueIndex)
+{
+	return (clueSet->colours != NULL) ? clueSet->colours[clueIndex] : 1;
+}
+
+/* TRUE if the clue after clueIndex shares its colour, so a blank cell must separate them */
+static bool needsGap (const LineClue * clueSet, int clueIndex)
+{
+	return clueIndex + 1 < clueSet->clueCount && clueColour(clueSet, clueIndex) == clueColour(clueSet, clueIndex + 1);
+}
+
+/* Bits of cells from (inclusive) to to (exclusive) */
+static uint64_t rangeBits (int from, int to)
+{
+	if (from >= to)
+		return 0ULL;
+
+	return ((to == 64) ? ~0ULL : (1ULL << to) - 1ULL) & ~((1ULL << from) - 1ULL);
+}
+
+/*
+ * Cheap pre-solve validation of a colour puzzle's clues, as validateClues() does for black
+ * and white ones: every line's clues (with the gaps their colours require) must fit it,
+ * their colours must be declared, and the rows must demand as many cells of each colour
+ * as the columns.
+ */
+bool validateColourClues (LineClue ** lineClues, int width, int length, int colourCount)
+{
+	int i, j, colour, required;
+	long totals[MAX_COLOURS + 1][2];
+
+	if (colourCount < 1 || colourCount > MAX_COLOURS)
+		return FALSE;
+
+	memset(totals, 0, sizeof(totals));
+
+	for (i = 0; i < width + length; ++i)
+	{
+		required = 0;
+
+		for (j = 0; j < lineClues[i]->clueCount; ++j)
+		{
+			colour = clueColour(lineClues[i], j);
+
+			if (colour < 1 || colour > colourCount)
+				return FALSE;
+
+			required += lineClues[i]->clues[j] + needsGap(lineClues[i], j);
+			totals[colour][i >= length] += lineClues[i]->clues[j];
+		}
+
+		if (required > ((i < length) ? width : length))
+			return FALSE;
+	}
+
+	for (colour = 1; colour <= colourCount; ++colour)
+		if (totals[colour][0] != totals[colour][1])
+			return FALSE;
+
+	return TRUE;
+}
+
+/*
+ * Allocates the solver state for a colour puzzle, every cell of every line open to every
+ * colour. Like createPuzzle(), it takes ownership of lineClues on success and leaves them
+ * with the caller on failure (NULL).
+ */
+ColourPuzzle * createColourPuzzle (LineClue ** lineClues, int width, int length, int colourCount)
+{
+	int i, k;
+	const int stride = colourCount + 1;
+	ColourPuzzle * puzzle = (ColourPuzzle *)calloc(1, sizeof(ColourPuzzle));
+
+	if (puzzle == NULL) return NULL;
+
+	puzzle->width = width;
+	puzzle->length = length;
+	puzzle->colourCount = colourCount;
+	puzzle->lines = (ColourLine *)calloc(width + length, sizeof(ColourLine));
+	puzzle->planes = (uint64_t *)malloc(sizeof(uint64_t) * stride * (width + length));
+
+	if (puzzle->lines == NULL || puzzle->planes == NULL)
+	{
+		freeColourPuzzle(puzzle);
+		return NULL;
+	}
+
+	for (i = 0; i < width + length; ++i)
+	{
+		puzzle->lines[i].size = (i < length) ? width : length;
+		puzzle->lines[i].colourCount = colourCount;
+		puzzle->lines[i].clueSet = lineClues[i];
+
+		for (k = 0; k < stride; ++k)
+			puzzle->planes[i * stride + k] = rangeBits(0, puzzle->lines[i].size);
+	}
+
+	puzzle->lineClues = lineClues;
+
+	return puzzle;
+}
+
+/*
+ * Releases a colour puzzle, its clues included.
+ */
+void freeColourPuzzle (ColourPuzzle * puzzle)
+{
+	int i;
+
+	if (puzzle == NULL) return;
+
+	if (puzzle->lines != NULL)
+		for (i = 0; i < puzzle->width + puzzle->length; ++i)
+			free(puzzle->lines[i].permutations);
+
+	freeLineClues(puzzle->lineClues, puzzle->width + puzzle->length);
+	free(puzzle->lines);
+	free(puzzle->planes);
+	free(puzzle);
+
+	return;
+}
+
+/*
+ * Fills counts[j][p] with the number of placements of clues j.. in cells p.. agreeing with
+ * the planes, the placement table solveColourPlacements() walks. A placement either leaves
+ * cell p background or starts clue j there, followed by a background cell when the next
+ * clue shares its colour.
+ */
+static void buildColourCounts (ColourLine * line, const uint64_t * planes, double counts[][MAX_LINE_SIZE + 2])
+{
+	int clueIndex, position, end;
+	const LineClue * clueSet = line->clueSet;
+	const int clueCount = clueSet->clueCount, size = line->size;
+	double count;
+
+	for (position = 0; position <= size; ++position)
+		counts[clueCount][position] = ((rangeBits(position, size) & ~planes[0]) == 0ULL) ? 1.0 : 0.0;
+
+	for (clueIndex = clueCount - 1; clueIndex >= 0; --clueIndex)
+	{
+		counts[clueIndex][size] = 0.0;
+
+		for (position = size - 1; position >= 0; --position)
+		{
+			count = (planes[0] >> position & 1ULL) ? counts[clueIndex][position + 1] : 0.0;
+			end = position + clueSet->clues[clueIndex];
+
+			if (end <= size && (rangeBits(position, end) & ~planes[clueColour(clueSet, clueIndex)]) == 0ULL)
+			{
+				if (!needsGap(clueSet, clueIndex))
+					count += counts[clueIndex + 1][end];
+
+				else if (end < size && (planes[0] >> end & 1ULL))
+					count += counts[clueIndex + 1][end + 1];
+			}
+
+			counts[clueIndex][position] = count;
+		}
+	}
+
+	return;
+}
+
+/*
+ * Returns the number of placements of a line's clues agreeing with its planes.
+ */
+double countColourPlacements (ColourLine * line, const uint64_t * planes)
+{
+	double counts[MAX_CLUES + 1][MAX_LINE_SIZE + 2];
+
+	buildColourCounts(line, planes, counts);
+
+	return counts[0][0];
+}
+
+/*
+ * solveColourPlacements(), also returning the number of placements agreeing with the
+ * planes in count.
+ */
+static bool narrowColourPlacements (ColourLine * line, uint64_t * planes, double * count)
+{
+	int clueIndex, position, end, colour, k;
+	const LineClue * clueSet = line->clueSet;
+	const int clueCount = clueSet->clueCount, size = line->size;
+	double counts[MAX_CLUES + 1][MAX_LINE_SIZE + 2];
+	bool reached[MAX_CLUES + 1][MAX_LINE_SIZE + 2];
+	uint64_t possible[MAX_COLOURS + 1], range;
+
+	buildColourCounts(line, planes, counts);
+	*count = counts[0][0];
+
+	if (counts[0][0] == 0.0)
+		return FALSE;
+
+	memset(reached, 0, sizeof(reached));
+	memset(possible, 0, sizeof(possible));
+	reached[0][0] = TRUE;
+
+	/* Every move goes right, so one pass in cell order visits each state after its sources */
+	for (position = 0; position <= size; ++position)
+		for (clueIndex = 0; clueIndex <= clueCount; ++clueIndex)
+		{
+			if (!reached[clueIndex][position])
+				continue;
+
+			if (clueIndex == clueCount)
+			{
+				possible[0] |= rangeBits(position, size);
+				continue;
+			}
+
+			if (position < size && (planes[0] >> position & 1ULL) && counts[clueIndex][position + 1] > 0.0)
+			{
+				possible[0] |= 1ULL << position;
+				reached[clueIndex][position + 1] = TRUE;
+			}
+
+			colour = clueColour(clueSet, clueIndex);
+			end = position + clueSet->clues[clueIndex];
+
+			if (end > size || ((range = rangeBits(position, end)) & ~planes[colour]) != 0ULL)
+				continue;
+
+			if (!needsGap(clueSet, clueIndex) && counts[clueIndex + 1][end] > 0.0)
+			{
+				possible[colour] |= range;
+				reached[clueIndex + 1][end] = TRUE;
+			}
+
+			else if (needsGap(clueSet, clueIndex) && end < size && (planes[0] >> end & 1ULL) && counts[clueIndex + 1][end + 1] > 0.0)
+			{
+				possible[colour] |= range;
+				possible[0] |= 1ULL << end;
+				reached[clueIndex + 1][end + 1] = TRUE;
+			}
+		}
+
+	for (k = 0; k <= line->colourCount; ++k)
+		planes[k] &= possible[k];
+
+	return TRUE;
+}
+
+/*
+ * Solves a line from the placement table alone, without enumerating: walks the placements
+ * from the left through the states the table says can still finish, collecting the cells
+ * each colour (and the background) can take. The planes are narrowed to them.
+ *
+ * Returns FALSE if no placement agrees with the planes.
+ */
+bool solveColourPlacements (ColourLine * line, uint64_t * planes)
+{
+	double count;
+
+	return narrowColourPlacements(line, planes, &count);
+}
+
+/* Placement being built by generateColourRuns() and where finished ones go */
+typedef struct ColourGenerator {
+	ColourLine * line;
+	const uint64_t * planes;
+	int minLength[MAX_CLUES + 1];     /* Cells clues j.. need, gaps included */
+	uint64_t current[MAX_COLOURS];
+	int count;
+	int capacity;
+} ColourGenerator;
+
+/*
+ * Places clues clueIndex.. from cell position on, in every way agreeing with the planes,
+ * storing each complete placement.
+ */
+static void generateColourRuns (ColourGenerator * generator, int clueIndex, int position)
+{
+	int start, end, colour;
+	ColourLine * line = generator->line;
+	const uint64_t * planes = generator->planes;
+	uint64_t range;
+
+	if (clueIndex == line->clueSet->clueCount)
+	{
+		if ((rangeBits(position, line->size) & ~planes[0]) == 0ULL && generator->count < generator->capacity)
+			memcpy(line->permutations + (size_t)generator->count++ * line->colourCount, generator->current, sizeof(uint64_t) * line->colourCount);
+
+		return;
+	}
+
+	colour = clueColour(line->clueSet, clueIndex);
+
+	for (start = position; start + generator->minLength[clueIndex] <= line->size; ++start)
+	{
+		/* The cells skipped before the block are background */
+		if (start > position && !(planes[0] >> (start - 1) & 1ULL))
+			break;
+
+		end = start + line->clueSet->clues[clueIndex];
+		range = rangeBits(start, end);
+
+		if ((range & ~planes[colour]) != 0ULL)
+			continue;
+
+		generator->current[colour - 1] |= range;
+
+		if (!needsGap(line->clueSet, clueIndex))
+			generateColourRuns(generator, clueIndex + 1, end);
+
+		else if (planes[0] >> end & 1ULL)
+			generateColourRuns(generator, clueIndex + 1, end + 1);
+
+		generator->current[colour - 1] &= ~range;
+	}
+
+	return;
+}
+
+/*
+ * Stores the count placements agreeing with the planes, see enumerateColourPermutations().
+ */
+static bool storeColourPermutations (ColourLine * line, const uint64_t * planes, double count)
+{
+	int i;
+	ColourGenerator generator;
+
+	if (count > COLOUR_PERMUTATION_LIMIT)
+		return FALSE;
+
+	free(line->permutations);
+	line->permutations = (uint64_t *)malloc(sizeof(uint64_t) * ((count > 0.0) ? (size_t)count : 1) * line->colourCount);
+	line->permutationCount = 0;
+
+	if (line->permutations == NULL)
+		return FALSE;
+
+	memset(&generator, 0, sizeof(generator));
+	generator.line = line;
+	generator.planes = planes;
+	generator.capacity = (int)count;
+
+	for (i = line->clueSet->clueCount - 1; i >= 0; --i)
+		generator.minLength[i] = generator.minLength[i + 1] + line->clueSet->clues[i] + needsGap(line->clueSet, i);
+
+	generateColourRuns(&generator, 0, 0);
+	line->permutationCount = generator.count;
+
+	return TRUE;
+}
+
+/*
+ * Stores the placements of a line's clues agreeing with its planes, colourCount words
+ * each (see ColourLine), so later solves only filter them.
+ *
+ * Returns FALSE, storing nothing, if there are more than COLOUR_PERMUTATION_LIMIT or memory
+ * runs out; the line is then solved with solveColourPlacements().
+ */
+bool enumerateColourPermutations (ColourLine * line, const uint64_t * planes)
+{
+	return storeColourPermutations(line, planes, countColourPlacements(line, planes));
+}
+
+/*
+ * Folds the stored permutations agreeing with the planes into them: each plane keeps only
+ * the cells some surviving permutation gives its colour. With compact set, permutations
+ * that no longer agree are dropped for good (the planes only ever narrow).
+ *
+ * Returns FALSE if no permutation agrees with the planes.
+ */
+static bool foldColourPermutations (ColourLine * line, uint64_t * planes, bool compact)
+{
+	int i, k, kept = 0;
+	const int colourCount = line->colourCount;
+	const uint64_t lineBits = rangeBits(0, line->size);
+	const uint64_t * permutation = NULL;
+	uint64_t possible[MAX_COLOURS + 1], occupied, conflicts;
+
+	memset(possible, 0, sizeof(possible));
+
+	for (i = 0; i < line->permutationCount; ++i)
+	{
+		permutation = line->permutations + (size_t)i * colourCount;
+		occupied = 0ULL;
+		conflicts = 0ULL;
+
+		for (k = 0; k < colourCount; ++k)
+		{
+			conflicts |= permutation[k] & ~planes[k + 1];
+			occupied |= permutation[k];
+		}
+
+		if ((conflicts | (lineBits & ~occupied & ~planes[0])) != 0ULL)
+			continue;
+
+		for (k = 0; k < colourCount; ++k)
+			possible[k + 1] |= permutation[k];
+
+		possible[0] |= lineBits & ~occupied;
+
+		if (compact && kept != i)
+			memcpy(line->permutations + (size_t)kept * colourCount, permutation, sizeof(uint64_t) * colourCount);
+
+		++kept;
+	}
+
+	if (compact)
+		line->permutationCount = kept;
+
+	if (kept == 0)
+		return FALSE;
+
+	for (k = 0; k <= colourCount; ++k)
+		planes[k] &= possible[k];
+
+	return TRUE;
+}
+
+/*
+ * Drops the stored permutations that no longer agree with the planes and narrows the
+ * planes to the consensus of the rest. Returns FALSE if none is left.
+ */
+bool filterColourPermutations (ColourLine * line, uint64_t * planes)
+{
+	return foldColourPermutations(line, planes, TRUE);
+}
+
+/*
+ * Narrows hypothetical planes (a search state) to the line's consensus without changing the
+ * line, from its stored permutations when it has them. Returns FALSE if no placement agrees
+ * with the planes.
+ */
+bool solveColourLine (ColourLine * line, uint64_t * planes)
+{
+	if (line->permutations != NULL)
+		return foldColourPermutations(line, planes, FALSE);
+
+	return solveColourPlacements(line, planes);
+}
+
+/*
+ * Solves one of the puzzle's own lines: from its stored permutations once it has them,
+ * otherwise from the placement table, storing the permutations once few enough remain
+ * that filtering them beats rebuilding the table.
+ */
+static bool solveRootLine (ColourPuzzle * puzzle, int index, uint64_t * planes)
+{
+	ColourLine * line = puzzle->lines + index;
+	double count;
+
+	if (line->permutations != NULL)
+		return filterColourPermutations(line, planes);
+
+	if (!narrowColourPlacements(line, planes, &count))
+		return FALSE;
+
+	/* Narrowing to the consensus keeps every placement, so count still holds */
+	storeColourPermutations(line, planes, count);
+
+	return TRUE;
+}
+
+/*
+ * Returns SOLVE_CANCELLED or SOLVE_TIMED_OUT once the solve's bounds are reached, otherwise
+ * SOLVE_IN_PROGRESS (see checkLimits()).
+ */
+static SolveStatus checkColourLimits (ColourPuzzle * puzzle)
+{
+	if (puzzle->cancel != NULL && atomic_load(puzzle->cancel))
+		return SOLVE_CANCELLED;
+
+	if (puzzle->deadline > 0 && monotonicNanos() >= puzzle->deadline)
+		return SOLVE_TIMED_OUT;
+
+	return SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Sweeps the dirty lines of a state until none changes. Each colour a line rules out of a
+ * cell is ruled out of the crossing line's plane too, marking it dirty. The puzzle's own
+ * state (root) uses and filters the stored permutations; search states leave them be.
+ *
+ * Returns SOLVE_IN_PROGRESS once the sweeps settle, SOLVE_UNSATISFIABLE if a line has no
+ * placement left, or the bound reached (see checkColourLimits()).
+ */
+static SolveStatus propagateColours (ColourPuzzle * puzzle, uint64_t * planes, bool * dirty, bool root)
+{
+	int i, k, cell, cross, position;
+	const int stride = puzzle->colourCount + 1, length = puzzle->length;
+	bool progress = TRUE;
+	uint64_t before[MAX_COLOURS + 1], removed, * linePlanes = NULL;
+	SolveStatus status;
+
+	while (progress)
+	{
+		if ((status = checkColourLimits(puzzle)) != SOLVE_IN_PROGRESS)
+			return status;
+
+		progress = FALSE;
+		++puzzle->iterations;
+
+		for (i = 0; i < puzzle->width + length; ++i)
+		{
+			if (!dirty[i])
+				continue;
+
+			dirty[i] = FALSE;
+			linePlanes = planes + (size_t)i * stride;
+			memcpy(before, linePlanes, sizeof(uint64_t) * stride);
+
+			if (!(root ? solveRootLine(puzzle, i, linePlanes) : solveColourLine(puzzle->lines + i, linePlanes)))
+				return SOLVE_UNSATISFIABLE;
+
+			/* Row r's cell c is column c's cell r */
+			position = (i < length) ? i : i - length;
+
+			for (k = 0; k < stride; ++k)
+				for (removed = before[k] & ~linePlanes[k]; removed != 0ULL; removed &= removed - 1)
+				{
+					cell = __builtin_ctzll(removed);
+					cross = (i < length) ? length + cell : cell;
+
+					planes[(size_t)cross * stride + k] &= ~(1ULL << position);
+					dirty[cross] = TRUE;
+					progress = TRUE;
+				}
+		}
+	}
+
+	return SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Returns TRUE if every cell of a state is down to one colour. Line solves leave every
+ * cell at least one, so it is enough for each row's planes to hold width cells between
+ * them.
+ */
+static bool coloursSolved (ColourPuzzle * puzzle, const uint64_t * planes)
+{
+	int row, k, cells;
+	const int stride = puzzle->colourCount + 1;
+
+	for (row = 0; row < puzzle->length; ++row)
+	{
+		for (k = 0, cells = 0; k < stride; ++k)
+			cells += __builtin_popcountll(planes[(size_t)row * stride + k]);
+
+		if (cells != puzzle->width)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Depth-first search over a settled state: picks the open cell with the fewest colours
+ * left and tries each, propagating every guess. On success the solution is copied into
+ * planes.
+ *
+ * Returns SOLVE_SOLVED, SOLVE_UNSATISFIABLE when no guess works, SOLVE_OUT_OF_MEMORY, or
+ * the bound reached.
+ */
+static SolveStatus searchColours (ColourPuzzle * puzzle, uint64_t * planes)
+{
+	int row, cell, k, options, fewest = MAX_COLOURS + 2, bestRow = 0, bestCell = 0;
+	const int stride = puzzle->colourCount + 1, length = puzzle->length;
+	const size_t stateWords = (size_t)stride * (puzzle->width + length);
+	bool dirty[2 * MAX_LINE_SIZE];
+	uint64_t * state = NULL;
+	SolveStatus status = SOLVE_UNSATISFIABLE;
+
+	for (row = 0; row < length; ++row)
+		for (cell = 0; cell < puzzle->width; ++cell)
+		{
+			for (k = 0, options = 0; k < stride; ++k)
+				options += (planes[(size_t)row * stride + k] >> cell) & 1ULL;
+
+			if (options > 1 && options < fewest)
+			{
+				fewest = options;
+				bestRow = row;
+				bestCell = cell;
+			}
+		}
+
+	state = (uint64_t *)malloc(sizeof(uint64_t) * stateWords);
+	if (state == NULL)
+		return SOLVE_OUT_OF_MEMORY;
+
+	for (k = 0; k < stride; ++k)
+	{
+		if (!(planes[(size_t)bestRow * stride + k] >> bestCell & 1ULL))
+			continue;
+
+		memcpy(state, planes, sizeof(uint64_t) * stateWords);
+
+		/* Every other colour ruled out of the cell, in its row and its column */
+		for (options = 0; options < stride; ++options)
+			if (options != k)
+			{
+				state[(size_t)bestRow * stride + options] &= ~(1ULL << bestCell);
+				state[(size_t)(length + bestCell) * stride + options] &= ~(1ULL << bestRow);
+			}
+
+		memset(dirty, 0, sizeof(dirty));
+		dirty[bestRow] = TRUE;
+		dirty[length + bestCell] = TRUE;
+
+		status = propagateColours(puzzle, state, dirty, FALSE);
+
+		if (status == SOLVE_UNSATISFIABLE)
+			continue;
+
+		if (status == SOLVE_IN_PROGRESS)
+			status = coloursSolved(puzzle, state) ? SOLVE_SOLVED : searchColours(puzzle, state);
+
+		if (status == SOLVE_SOLVED)
+			memcpy(planes, state, sizeof(uint64_t) * stateWords);
+
+		if (status != SOLVE_UNSATISFIABLE)
+			break;
+	}
+
+	free(state);
+
+	return status;
+}
+
+/*
+ * Solves a colour puzzle: line propagation over the planes, then a depth-first search
+ * when the lines stall. The solution (or, when stopped early, what was solved) is left in
+ * the puzzle's planes, see colourGameBoard().
+ *
+ * Parameters:
+ * - options : Bounds on the solve (NULL for none); the time limit and cancel flag apply,
+ *             colour lines keep within COLOUR_PERMUTATION_LIMIT instead of a byte budget.
+ *
+ * Returns SOLVE_SOLVED, SOLVE_UNSATISFIABLE, SOLVE_OUT_OF_MEMORY, SOLVE_TIMED_OUT or
+ * SOLVE_CANCELLED.
+ */
+SolveStatus solveColourPuzzle (ColourPuzzle * puzzle, const SolveOptions * options)
+{
+	bool dirty[2 * MAX_LINE_SIZE];
+	SolveStatus status;
+
+	puzzle->deadline = (options != NULL && options->timeLimitMillis > 0) ? monotonicNanos() + options->timeLimitMillis * 1000000L : 0;
+	puzzle->cancel = (options != NULL) ? options->cancel : NULL;
+
+	memset(dirty, TRUE, sizeof(dirty));
+
+	status = propagateColours(puzzle, puzzle->planes, dirty, TRUE);
+
+	if (status != SOLVE_IN_PROGRESS)
+		return status;
+
+	if (coloursSolved(puzzle, puzzle->planes))
+		return SOLVE_SOLVED;
+
+	return searchColours(puzzle, puzzle->planes);
+}
+
+/*
+ * Returns the puzzle's gameboard (0 background, k colour k, -1 unsolved, row major) as its
+ * planes stand, or NULL if memory runs out.
+ */
+int * colourGameBoard (ColourPuzzle * puzzle)
+{
+	int row, cell, k, colour;
+	const int stride = puzzle->colourCount + 1;
+	const uint64_t * planes = NULL;
+	int * gameBoard = createGameBoard(puzzle->width, puzzle->length);
+
+	if (gameBoard == NULL)
+		return NULL;
+
+	for (row = 0; row < puzzle->length; ++row)
+	{
+		planes = puzzle->planes + (size_t)row * stride;
+
+		for (cell = 0; cell < puzzle->width; ++cell)
+		{
+			for (k = 0, colour = -1; k < stride; ++k)
+				if (planes[k] >> cell & 1ULL)
+					colour = (colour == -1) ? k : -2;
+
+			gameBoard[row * puzzle->width + cell] = (colour >= 0) ? colour : -1;
+		}
+	}
+
+	return gameBoard;
+}
+
+/*
+ * Reads and solves a black and white or colour puzzle file (see readColourFile()).
+ *
+ * Parameters:
+ * - fPtr : The open puzzle file.
+ * - width, length, colourCount : Receive the puzzle's dimensions and number of colours.
+ * - iterations : Receives the number of line propagation passes.
+ * - status : Receives the outcome, see solveColourPuzzle().
+ * - options : Bounds on the solve, may be NULL.
+ *
+ * Returns the gameboard (see colourGameBoard()), partly solved unless status is
+ * SOLVE_SOLVED, or NULL if the file is invalid, the clues are unsatisfiable or memory runs
+ * out.
+ */
+int * solveColourFile (FILE * fPtr, int * width, int * length, int * colourCount, int * iterations, SolveStatus * status, const SolveOptions * options)
+{
+	int * gameBoard = NULL;
+	ColourPuzzle * puzzle = NULL;
+	LineClue ** lineClues = readColourFile(fPtr, width, length, colourCount);
+
+	*iterations = 0;
+
+	if (lineClues == NULL)
+	{
+		*status = SOLVE_INVALID_INPUT;
+		return NULL;
+	}
+
+	if (!validateColourClues(lineClues, *width, *length, *colourCount))
+	{
+		freeLineClues(lineClues, *width + *length);
+		*status = SOLVE_UNSATISFIABLE;
+		return NULL;
+	}
+
+	puzzle = createColourPuzzle(lineClues, *width, *length, *colourCount);
+
+	if (puzzle == NULL)
+	{
+		freeLineClues(lineClues, *width + *length);
+		*status = SOLVE_OUT_OF_MEMORY;
+		return NULL;
+	}
+
+	*status = solveColourPuzzle(puzzle, options);
+	*iterations = puzzle->iterations;
+
+	if (*status != SOLVE_UNSATISFIABLE)
+		gameBoard = colourGameBoard(puzzle);
+
+	freeColourPuzzle(puzzle);
+
+	return gameBoard;
+}
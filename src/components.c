@@ -0,0 +1,232 @@
+#include "../include/components.h"
+#include <stdlib.h>
+#include "../include/parallel.h"
+
+/*
+ * Splitting a stalled puzzle into independent regions.
+ *
+ * Every unsolved cell ties its row to its column: whatever one of them is solved to
+ * constrains the other. Rows and columns tied together, directly or through a chain of
+ * unsolved cells, form a component, and the unsolved cells on them are its region. No
+ * line has unsolved cells in two regions, so each region can be searched on its own and
+ * the results simply combined, a sum of searches in place of one search over their
+ * product.
+ */
+
+typedef struct ComponentJob {
+	Puzzle * puzzle;
+	RegionSolver solver;
+	int * cells;
+	int * starts;
+	int * order;
+	SolveStatus * results;
+} ComponentJob;
+
+/*
+ * Returns the representative of a line's component, halving the paths on the way.
+ */
+static int findRoot (int * parent, int index)
+{
+	while (parent[index] != index)
+	{
+		parent[index] = parent[parent[index]];
+		index = parent[index];
+	}
+
+	return index;
+}
+
+/*
+ * Labels each unsolved cell with the component its row and column belong to.
+ *
+ * Parameters:
+ * - puzzle        : The puzzle, its gameboard gives the unsolved cells.
+ * - cellComponent : Receives a component number for every unsolved cell, -1 for solved
+ *                   cells (one entry per cell).
+ *
+ * Components are numbered from 0 in the order of their first cell. Returns the number of
+ * components, 0 for a solved gameboard.
+ */
+int findComponents (Puzzle * puzzle, int * cellComponent)
+{
+	int i, row, column, root, count = 0;
+	int parent[2 * MAX_LINE_SIZE], label[2 * MAX_LINE_SIZE];
+	const int lineCount = puzzle->width + puzzle->length;
+
+	for (i = 0; i < lineCount; ++i)
+	{
+		parent[i] = i;
+		label[i] = -1;
+	}
+
+	for (i = 0; i < puzzle->width * puzzle->length; ++i)
+		if (puzzle->gameBoard[i] == -1)
+		{
+			row = findRoot(parent, i / puzzle->width);
+			column = findRoot(parent, puzzle->length + (i % puzzle->width));
+
+			if (row != column)
+				parent[column] = row;
+		}
+
+	for (i = 0; i < puzzle->width * puzzle->length; ++i)
+	{
+		cellComponent[i] = -1;
+
+		if (puzzle->gameBoard[i] != -1)
+			continue;
+
+		root = findRoot(parent, i / puzzle->width);
+
+		if (label[root] < 0)
+			label[root] = count++;
+
+		cellComponent[i] = label[root];
+	}
+
+	return count;
+}
+
+/*
+ * Task body for runParallel(): solves one region, largest regions first.
+ */
+static void componentTask (void * arg, int task)
+{
+	ComponentJob * job = (ComponentJob *)arg;
+	int component = job->order[task];
+
+	job->results[component] = job->solver(job->puzzle, job->cells + job->starts[component],
+		job->starts[component + 1] - job->starts[component]);
+
+	return;
+}
+
+/*
+ * Searches a stalled puzzle one independent region at a time.
+ *
+ * Parameters:
+ * - puzzle     : A puzzle whose gameboard line propagation has taken as far as it can.
+ * - solver     : Searches one region, writing its cells to the gameboard when it finds a
+ *                solution. Called with a NULL region when there is only one component.
+ * - concurrent : TRUE runs the regions on runParallel() workers (for single threaded
+ *                solvers), FALSE runs them one after another, stopping at the first
+ *                region without a solution.
+ *
+ * Regions share no line with unsolved cells, so concurrent solvers only ever write
+ * disjoint cells and read solved ones.
+ *
+ * Return:
+ * - SOLVE_SOLVED when every region is solved.
+ * - SOLVE_UNSATISFIABLE when some region has no solution.
+ * - SOLVE_OUT_OF_MEMORY when memory runs out, in a solver or here.
+ * - SOLVE_TIMED_OUT or SOLVE_CANCELLED when the puzzle's limits stop a solver, regions
+ *   solved before then are on the gameboard.
+ */
+SolveStatus solveComponents (Puzzle * puzzle, RegionSolver solver, bool concurrent)
+{
+	int i, j, component, count;
+	const int cellCount = puzzle->width * puzzle->length;
+	int * cellComponent = (int *)malloc(sizeof(int) * cellCount);
+	ComponentJob job;
+	SolveStatus status = SOLVE_OUT_OF_MEMORY, result;
+
+	job.puzzle = puzzle;
+	job.solver = solver;
+	job.cells = NULL;
+	job.starts = NULL;
+	job.order = NULL;
+	job.results = NULL;
+
+	if (cellComponent == NULL)
+		goto components_Free;
+
+	count = findComponents(puzzle, cellComponent);
+
+	if (count <= 1)
+	{
+		status = solver(puzzle, NULL, 0);
+		goto components_Free;
+	}
+
+	job.cells = (int *)malloc(sizeof(int) * cellCount);
+	job.starts = (int *)calloc(count + 1, sizeof(int));
+	job.order = (int *)malloc(sizeof(int) * count);
+	job.results = (SolveStatus *)malloc(sizeof(SolveStatus) * count);
+
+	if (job.cells == NULL || job.starts == NULL || job.order == NULL || job.results == NULL)
+		goto components_Free;
+
+	/* Group the cells by component, starts[c] is where component c's cells begin */
+	for (i = 0; i < cellCount; ++i)
+		if (cellComponent[i] >= 0)
+			++job.starts[cellComponent[i] + 1];
+
+	for (component = 0; component < count; ++component)
+		job.starts[component + 1] += job.starts[component];
+
+	for (i = 0; i < cellCount; ++i)
+		if (cellComponent[i] >= 0)
+			job.cells[job.starts[cellComponent[i]]++] = i;
+
+	for (component = count; component > 0; --component)
+		job.starts[component] = job.starts[component - 1];
+
+	job.starts[0] = 0;
+
+	/* Largest regions first, by insertion sort as components are few */
+	for (i = 0; i < count; ++i)
+	{
+		for (j = i; j > 0 && job.starts[job.order[j - 1] + 1] - job.starts[job.order[j - 1]] < job.starts[i + 1] - job.starts[i]; --j)
+			job.order[j] = job.order[j - 1];
+
+		job.order[j] = i;
+	}
+
+	/* Regions left unsolved after another fails stay SOLVE_IN_PROGRESS */
+	for (component = 0; component < count; ++component)
+		job.results[component] = SOLVE_IN_PROGRESS;
+
+	if (concurrent)
+		runParallel(componentTask, &job, count);
+
+	else
+		for (i = 0; i < count; ++i)
+		{
+			componentTask(&job, i);
+
+			if (job.results[job.order[i]] != SOLVE_SOLVED)
+				break;
+		}
+
+	/* Running out of memory outranks a region without solution, which outranks a stop */
+	status = SOLVE_SOLVED;
+
+	for (component = 0; component < count; ++component)
+	{
+		result = job.results[component];
+
+		if (result == SOLVE_SOLVED || result == SOLVE_IN_PROGRESS || status == SOLVE_OUT_OF_MEMORY)
+			continue;
+
+		if (status == SOLVE_SOLVED || result == SOLVE_OUT_OF_MEMORY || result == SOLVE_UNSATISFIABLE)
+			status = result;
+	}
+
+components_Free:
+	free(cellComponent);
+	cellComponent = NULL;
+
+	free(job.cells);
+	job.cells = NULL;
+
+	free(job.starts);
+	job.starts = NULL;
+
+	free(job.order);
+	job.order = NULL;
+
+	free(job.results);
+	job.results = NULL;
+
+	return status;
+}
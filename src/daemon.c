@@ -0,0 +1,724 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../include/daemon.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../include/parallel.h"
+#include "../include/puzzle.h"
+
+/*
+ * Long running solver: answers newline delimited puzzle requests from stdin or from the
+ * clients of a Unix domain socket, so a stream of puzzles pays for process startup and
+ * thread creation once.
+ *
+ * Protocol, one line per message:
+ * - "<id> <puzzle>" solves a puzzle given in the puzzle file format with its lines
+ *   separated by ';' instead of newlines (for example "a 2 2;2;1;2;1"). The id is any
+ *   word and comes back in the response, which may arrive out of order.
+ * - "stats" reports the daemon's counters at once, ahead of queued work.
+ *
+ * Responses:
+ * - "<id> <status> <solve us> <wait us> <board>", the board being its rows separated by
+ *   ';' ('#' filled, '.' empty, '?' unsolved), "-" when the solve produced none, or the
+ *   parse error for status "invalid-input".
+ * - "stats uptime_ms=.. received=.. completed=.. queued=.. active=.. throughput=..
+ *   cache_lookups=.. cache_hits=.. latency_us=100:..,1000:..,..,inf:.." where latency
+ *   counts the microseconds from a request being read to its response being written, in
+ *   decade buckets, and the cache counts are the shared line cache's.
+ *
+ * A fixed pool of getWorkerCount() workers, each with its own SolverContext, takes
+ * requests off one queue. Every request builds a fresh puzzle, but the workers share one
+ * LineCache for the daemon's lifetime (see shareLineCache()), so a line solved for one
+ * request is reused by every later request with the same clues and known cells. The
+ * pattern table (see lookupPatterns()) is process wide and so shared already.
+ */
+
+/* Latency histogram buckets: up to 100us, 1ms, ... 10s, and longer */
+#define LATENCY_BUCKETS 7
+
+/* Slots of the line cache the workers share */
+#define DAEMON_CACHE_SLOTS (1 << 18)
+
+/* How often (milliseconds) the socket accept loop checks for a stop */
+#define ACCEPT_POLL_MILLIS 100
+
+/* One client stream: requests come in on inputFd, responses go out on outputFd */
+typedef struct Connection {
+	struct Connection * next;
+	int inputFd;
+	int outputFd;
+	bool ownsFds;
+	pthread_mutex_t lock;       /* Serialises responses, guards pending and finished */
+	int pending;                /* Requests queued or being solved */
+	bool finished;              /* No more requests will be read */
+} Connection;
+
+typedef struct Request {
+	struct Request * next;
+	Connection * connection;
+	char * line;
+	long readAt;
+} Request;
+
+typedef struct Daemon Daemon;
+
+typedef struct Worker {
+	Daemon * daemon;
+	SolverContext * context;
+	pthread_t thread;
+} Worker;
+
+struct Daemon {
+	pthread_mutex_t lock;       /* Guards everything below */
+	pthread_cond_t ready;       /* A request was queued or the workers should stop */
+	pthread_cond_t readersDone; /* The last socket reader returned */
+	Request * head;
+	Request * tail;
+	Connection * connections;
+	Worker * workers;
+	int workerCount;
+	LineCache * lineCache;      /* Shared by the workers' contexts, NULL if it could not be made */
+	int readers;
+	bool stopping;
+	long startedAt;
+	long received;
+	long completed;
+	int queued;
+	int active;
+	long latency[LATENCY_BUCKETS];
+};
+
+typedef struct SocketReader {
+	Daemon * daemon;
+	Connection * connection;
+} SocketReader;
+
+/*
+ * Protocol name of a status, one word.
+ */
+static const char * statusToken (SolveStatus status)
+{
+	switch (status)
+	{
+		case SOLVE_SOLVED: 			return "solved";
+		case SOLVE_IN_PROGRESS: 	return "in-progress";
+		case SOLVE_INCOMPLETE: 		return "incomplete";
+		case SOLVE_UNSATISFIABLE: 	return "unsatisfiable";
+		case SOLVE_INVALID_INPUT: 	return "invalid-input";
+		case SOLVE_OUT_OF_MEMORY: 	return "out-of-memory";
+		case SOLVE_TIMED_OUT: 		return "timed-out";
+		case SOLVE_CANCELLED: 		return "cancelled";
+		case SOLVE_PAUSED: 			return "paused";
+	}
+
+	return "unknown";
+}
+
+/*
+ * Writes a whole response, giving up quietly if the client has gone away.
+ */
+static void writeResponse (Connection * connection, const char * text, size_t size)
+{
+	ssize_t written;
+
+	pthread_mutex_lock(&connection->lock);
+
+	while (size > 0)
+	{
+		written = write(connection->outputFd, text, size);
+
+		if (written < 0 && errno == EINTR)
+			continue;
+
+		if (written <= 0)
+			break;
+
+		text += written;
+		size -= (size_t)written;
+	}
+
+	pthread_mutex_unlock(&connection->lock);
+
+	return;
+}
+
+static Connection * openConnection (Daemon * daemon, int inputFd, int outputFd, bool ownsFds)
+{
+	Connection * connection = (Connection *)calloc(1, sizeof(Connection));
+
+	if (connection == NULL)
+		return NULL;
+
+	connection->inputFd = inputFd;
+	connection->outputFd = outputFd;
+	connection->ownsFds = ownsFds;
+	pthread_mutex_init(&connection->lock, NULL);
+
+	pthread_mutex_lock(&daemon->lock);
+	connection->next = daemon->connections;
+	daemon->connections = connection;
+	pthread_mutex_unlock(&daemon->lock);
+
+	return connection;
+}
+
+/*
+ * Drops a reference to a connection: the reader's once it reaches the end of its input
+ * (readerDone), a request's once answered. The last one closes and frees it.
+ */
+static void releaseConnection (Daemon * daemon, Connection * connection, bool readerDone)
+{
+	bool closing;
+	Connection ** link = NULL;
+
+	pthread_mutex_lock(&connection->lock);
+
+	if (readerDone)
+		connection->finished = TRUE;
+	else
+		--connection->pending;
+
+	closing = connection->finished && connection->pending == 0;
+
+	pthread_mutex_unlock(&connection->lock);
+
+	if (!closing)
+		return;
+
+	pthread_mutex_lock(&daemon->lock);
+
+	for (link = &daemon->connections; *link != connection; link = &(*link)->next);
+	*link = connection->next;
+
+	pthread_mutex_unlock(&daemon->lock);
+
+	if (connection->ownsFds)
+	{
+		close(connection->inputFd);
+
+		if (connection->outputFd != connection->inputFd)
+			close(connection->outputFd);
+	}
+
+	pthread_mutex_destroy(&connection->lock);
+	free(connection);
+
+	return;
+}
+
+/*
+ * Appends a request line to the queue. Returns FALSE if memory runs out.
+ */
+static bool queueRequest (Daemon * daemon, Connection * connection, const char * line)
+{
+	Request * request = (Request *)malloc(sizeof(Request));
+
+	if (request == NULL)
+		return FALSE;
+
+	request->line = strdup(line);
+	if (request->line == NULL)
+	{
+		free(request);
+		return FALSE;
+	}
+
+	request->next = NULL;
+	request->connection = connection;
+	request->readAt = monotonicNanos();
+
+	pthread_mutex_lock(&connection->lock);
+	++connection->pending;
+	pthread_mutex_unlock(&connection->lock);
+
+	pthread_mutex_lock(&daemon->lock);
+
+	if (daemon->tail != NULL)
+		daemon->tail->next = request;
+	else
+		daemon->head = request;
+
+	daemon->tail = request;
+	++daemon->queued;
+	++daemon->received;
+
+	pthread_cond_signal(&daemon->ready);
+	pthread_mutex_unlock(&daemon->lock);
+
+	return TRUE;
+}
+
+/*
+ * Waits for the next request. Returns NULL once the daemon stops and the queue is empty.
+ */
+static Request * nextRequest (Daemon * daemon)
+{
+	Request * request = NULL;
+
+	pthread_mutex_lock(&daemon->lock);
+
+	while (daemon->head == NULL && !daemon->stopping)
+		pthread_cond_wait(&daemon->ready, &daemon->lock);
+
+	request = daemon->head;
+
+	if (request != NULL)
+	{
+		daemon->head = request->next;
+
+		if (daemon->head == NULL)
+			daemon->tail = NULL;
+
+		--daemon->queued;
+		++daemon->active;
+	}
+
+	pthread_mutex_unlock(&daemon->lock);
+
+	return request;
+}
+
+/*
+ * Solves one request with the worker's context and writes its response.
+ */
+static void answerRequest (Daemon * daemon, SolverContext * context, Request * request)
+{
+	int bucket;
+	long waited, latency, bound;
+	size_t size, capacity;
+	char * response = NULL, * text = NULL, * cursor = NULL;
+	const SolveResult * result = NULL;
+
+	/* "<id> <puzzle>": split off the id and restore the puzzle's newlines */
+	text = strchr(request->line, ' ');
+
+	if (text != NULL)
+		*text++ = '\0';
+	else
+		text = request->line + strlen(request->line);
+
+	for (cursor = text; *cursor != '\0'; ++cursor)
+		if (*cursor == ';')
+			*cursor = '\n';
+
+	waited = monotonicNanos() - request->readAt;
+	result = solveBuffer(context, text, strlen(text));
+
+	capacity = strlen(request->line) + sizeof(result->error) + 96;
+	if (result->gameBoard != NULL)
+		capacity += (size_t)(result->width + 1) * result->length;
+
+	response = (char *)malloc(capacity);
+
+	if (response != NULL)
+	{
+		size = (size_t)snprintf(response, capacity, "%s %s %ld %ld ", request->line, statusToken(result->status),
+			result->elapsedNanos / 1000, waited / 1000);
+
+		/* The rows format ends the line itself */
+		if (result->gameBoard != NULL)
+			size += renderGameBoard(result->gameBoard, result->width, result->length, BOARD_ROWS, response + size, capacity - size);
+
+		else
+		{
+			if (result->status == SOLVE_INVALID_INPUT)
+				size += (size_t)snprintf(response + size, capacity - size, "%s", result->error);
+			else
+				response[size++] = '-';
+
+			response[size++] = '\n';
+		}
+
+		writeResponse(request->connection, response, size);
+	}
+
+	else
+		writeResponse(request->connection, "- out-of-memory\n", 16);
+
+	free(response);
+	response = NULL;
+
+	latency = monotonicNanos() - request->readAt;
+
+	for (bucket = 0, bound = 100000L; bucket < LATENCY_BUCKETS - 1 && latency > bound; ++bucket, bound *= 10);
+
+	pthread_mutex_lock(&daemon->lock);
+	--daemon->active;
+	++daemon->completed;
+	++daemon->latency[bucket];
+	pthread_mutex_unlock(&daemon->lock);
+
+	releaseConnection(daemon, request->connection, FALSE);
+
+	free(request->line);
+	free(request);
+
+	return;
+}
+
+/*
+ * Worker thread body: answers requests until the daemon stops.
+ */
+static void * serveRequests (void * arg)
+{
+	Worker * worker = (Worker *)arg;
+	Request * request = NULL;
+
+	while ((request = nextRequest(worker->daemon)) != NULL)
+		answerRequest(worker->daemon, worker->context, request);
+
+	return NULL;
+}
+
+/*
+ * Answers a "stats" request with a snapshot of the daemon's counters.
+ */
+static void writeStats (Daemon * daemon, Connection * connection)
+{
+	char response[512];
+	int i, size;
+	long bound, uptime, lookups = 0, hits = 0;
+
+	if (daemon->lineCache != NULL)
+		lineCacheStats(daemon->lineCache, &lookups, &hits);
+
+	pthread_mutex_lock(&daemon->lock);
+
+	uptime = monotonicNanos() - daemon->startedAt;
+
+	size = snprintf(response, sizeof(response), "stats uptime_ms=%ld received=%ld completed=%ld queued=%d active=%d throughput=%.2f cache_lookups=%ld cache_hits=%ld latency_us=",
+		uptime / 1000000, daemon->received, daemon->completed, daemon->queued, daemon->active,
+		(uptime > 0) ? daemon->completed * 1e9 / uptime : 0.0, lookups, hits);
+
+	for (i = 0, bound = 100; i < LATENCY_BUCKETS; ++i, bound *= 10)
+	{
+		if (i < LATENCY_BUCKETS - 1)
+			size += snprintf(response + size, sizeof(response) - size, "%ld:%ld,", bound, daemon->latency[i]);
+		else
+			size += snprintf(response + size, sizeof(response) - size, "inf:%ld\n", daemon->latency[i]);
+	}
+
+	pthread_mutex_unlock(&daemon->lock);
+
+	writeResponse(connection, response, (size_t)size);
+
+	return;
+}
+
+/*
+ * Reads a connection's requests until the end of its input (or a read interrupted by a
+ * signal), then drops the reader's reference to it.
+ */
+static void readRequests (Daemon * daemon, Connection * connection)
+{
+	char * line = NULL;
+	size_t capacity = 0;
+	ssize_t count;
+	FILE * input = NULL;
+	int inputFd = dup(connection->inputFd);
+
+	/* A duplicate, so closing the stream leaves the connection's descriptor alone */
+	if (inputFd >= 0)
+		input = fdopen(inputFd, "r");
+
+	if (input == NULL && inputFd >= 0)
+		close(inputFd);
+
+	while (input != NULL && (count = getline(&line, &capacity, input)) != -1)
+	{
+		while (count > 0 && (line[count - 1] == '\n' || line[count - 1] == '\r'))
+			line[--count] = '\0';
+
+		if (count == 0)
+			continue;
+
+		if (strcmp(line, "stats") == 0)
+			writeStats(daemon, connection);
+
+		else if (!queueRequest(daemon, connection, line))
+			writeResponse(connection, "- out-of-memory\n", 16);
+	}
+
+	free(line);
+	line = NULL;
+
+	if (input != NULL)
+		fclose(input);
+
+	releaseConnection(daemon, connection, TRUE);
+
+	return;
+}
+
+/*
+ * Starts the worker pool. Workers block SIGINT so it reaches the thread reading
+ * requests. Returns FALSE if the pool cannot be started.
+ */
+static bool startDaemon (Daemon * daemon, const SolveOptions * options, SearchEngine engine)
+{
+	int i;
+	sigset_t blocked, previous;
+
+	memset(daemon, 0, sizeof(Daemon));
+	pthread_mutex_init(&daemon->lock, NULL);
+	pthread_cond_init(&daemon->ready, NULL);
+	pthread_cond_init(&daemon->readersDone, NULL);
+	daemon->startedAt = monotonicNanos();
+
+	daemon->workers = (Worker *)calloc(getWorkerCount(), sizeof(Worker));
+	if (daemon->workers == NULL)
+		return FALSE;
+
+	/* Without the shared cache each request falls back to a cache of its own */
+	daemon->lineCache = createLineCache(DAEMON_CACHE_SLOTS);
+
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+
+	for (i = 0; i < getWorkerCount(); ++i)
+	{
+		daemon->workers[i].daemon = daemon;
+		daemon->workers[i].context = createSolverContext(options, engine);
+
+		if (daemon->workers[i].context == NULL)
+			break;
+
+		shareLineCache(daemon->workers[i].context, daemon->lineCache);
+
+		if (pthread_create(&daemon->workers[i].thread, NULL, serveRequests, &daemon->workers[i]) != 0)
+		{
+			freeSolverContext(daemon->workers[i].context);
+			break;
+		}
+
+		++daemon->workerCount;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+	return daemon->workerCount > 0;
+}
+
+/*
+ * Lets the workers drain the queue, then joins them and releases the pool.
+ */
+static void stopDaemon (Daemon * daemon)
+{
+	int i;
+
+	pthread_mutex_lock(&daemon->lock);
+	daemon->stopping = TRUE;
+	pthread_cond_broadcast(&daemon->ready);
+	pthread_mutex_unlock(&daemon->lock);
+
+	for (i = 0; i < daemon->workerCount; ++i)
+	{
+		pthread_join(daemon->workers[i].thread, NULL);
+		freeSolverContext(daemon->workers[i].context);
+	}
+
+	free(daemon->workers);
+	daemon->workers = NULL;
+
+	freeLineCache(daemon->lineCache);
+	daemon->lineCache = NULL;
+
+	pthread_cond_destroy(&daemon->readersDone);
+	pthread_cond_destroy(&daemon->ready);
+	pthread_mutex_destroy(&daemon->lock);
+
+	return;
+}
+
+/*
+ * Serves the requests read from inputFd (stdin for the command line), writing responses
+ * to outputFd, until the end of the input.
+ *
+ * Parameters:
+ * - inputFd  : Descriptor requests are read from.
+ * - outputFd : Descriptor responses are written to.
+ * - options  : Optional (may be NULL), bounds applied to every request (see SolveOptions).
+ * - engine   : The search used once line logic and probing stall.
+ *
+ * Return:
+ * - 0 once every request read has been answered, -1 if the daemon could not start.
+ */
+int runDaemon (int inputFd, int outputFd, const SolveOptions * options, SearchEngine engine)
+{
+	Daemon daemon;
+	Connection * connection = NULL;
+
+	if (!startDaemon(&daemon, options, engine))
+	{
+		stopDaemon(&daemon);
+		return -1;
+	}
+
+	connection = openConnection(&daemon, inputFd, outputFd, FALSE);
+
+	if (connection != NULL)
+		readRequests(&daemon, connection);
+
+	stopDaemon(&daemon);
+
+	return (connection != NULL) ? 0 : -1;
+}
+
+/*
+ * Thread body for a socket client's requests.
+ */
+static void * readSocket (void * arg)
+{
+	SocketReader * reader = (SocketReader *)arg;
+	Daemon * daemon = reader->daemon;
+
+	readRequests(daemon, reader->connection);
+	free(reader);
+
+	pthread_mutex_lock(&daemon->lock);
+
+	if (--daemon->readers == 0)
+		pthread_cond_broadcast(&daemon->readersDone);
+
+	pthread_mutex_unlock(&daemon->lock);
+
+	return NULL;
+}
+
+/*
+ * Starts a detached reader thread for a newly accepted client. Returns FALSE (the client
+ * then being closed) if it cannot be started.
+ */
+static bool acceptClient (Daemon * daemon, int clientFd)
+{
+	pthread_t thread;
+	sigset_t blocked, previous;
+	SocketReader * reader = (SocketReader *)malloc(sizeof(SocketReader));
+	bool started = FALSE;
+
+	if (reader == NULL)
+		return FALSE;
+
+	reader->daemon = daemon;
+	reader->connection = openConnection(daemon, clientFd, clientFd, TRUE);
+
+	if (reader->connection == NULL)
+	{
+		free(reader);
+		return FALSE;
+	}
+
+	pthread_mutex_lock(&daemon->lock);
+	++daemon->readers;
+	pthread_mutex_unlock(&daemon->lock);
+
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+
+	started = pthread_create(&thread, NULL, readSocket, reader) == 0;
+
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+	if (started)
+	{
+		pthread_detach(thread);
+		return TRUE;
+	}
+
+	/* Undo as the thread would have: the connection owns (and closes) clientFd */
+	pthread_mutex_lock(&daemon->lock);
+	--daemon->readers;
+	pthread_mutex_unlock(&daemon->lock);
+
+	releaseConnection(daemon, reader->connection, TRUE);
+	free(reader);
+
+	return TRUE;
+}
+
+/*
+ * Serves requests from the clients of a Unix domain socket created at path (replacing a
+ * stale one), each client on its own reader thread, until options' cancel flag is raised.
+ *
+ * Parameters:
+ * - path    : Filesystem path of the socket, removed again on return.
+ * - options : Optional (may be NULL), bounds applied to every request (see SolveOptions).
+ *             Without a cancel flag the daemon serves until the process ends.
+ * - engine  : The search used once line logic and probing stall.
+ *
+ * Return:
+ * - 0 after a requested stop, -1 if the socket or the daemon could not be set up.
+ */
+int runSocketDaemon (const char * path, const SolveOptions * options, SearchEngine engine)
+{
+	int listenFd, clientFd, result = -1;
+	struct sockaddr_un address;
+	struct pollfd waiting;
+	Daemon daemon;
+	Connection * connection = NULL;
+
+	if (strlen(path) >= sizeof(address.sun_path))
+		return -1;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0)
+		return -1;
+
+	unlink(path);
+
+	if (bind(listenFd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listenFd, 16) != 0)
+	{
+		close(listenFd);
+		return -1;
+	}
+
+	if (!startDaemon(&daemon, options, engine))
+		goto socket_Done;
+
+	result = 0;
+	waiting.fd = listenFd;
+	waiting.events = POLLIN;
+
+	/* Polling with a timeout rather than blocking in accept() notices a stop promptly */
+	while (options == NULL || options->cancel == NULL || !atomic_load(options->cancel))
+	{
+		if (poll(&waiting, 1, ACCEPT_POLL_MILLIS) <= 0)
+			continue;
+
+		clientFd = accept(listenFd, NULL, NULL);
+
+		if (clientFd >= 0 && !acceptClient(&daemon, clientFd))
+			close(clientFd);
+	}
+
+	/* Wake the readers still waiting on their clients and wait for them to return */
+	pthread_mutex_lock(&daemon.lock);
+
+	for (connection = daemon.connections; connection != NULL; connection = connection->next)
+		shutdown(connection->inputFd, SHUT_RD);
+
+	while (daemon.readers > 0)
+		pthread_cond_wait(&daemon.readersDone, &daemon.lock);
+
+	pthread_mutex_unlock(&daemon.lock);
+
+socket_Done:
+	stopDaemon(&daemon);
+
+	close(listenFd);
+	unlink(path);
+
+	return result;
+}
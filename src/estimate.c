@@ -0,0 +1,196 @@
+#include "../include/estimate.h"
+#include <stdio.h>
+#include <string.h>
+#include "../include/fileIO.h"
+#include "../include/puzzle.h"
+#include "../include/solver.h"
+
+/*
+ * Dry-run planning: predicts a puzzle's permutation work and memory from its clues alone,
+ * without building the puzzle, so admission control and batch ordering can afford it on
+ * every request.
+ */
+
+/* Peak permutation memory below which a puzzle is trivial, light and heavy */
+#define RISK_LIGHT_BYTES (64.0 * 1024)
+#define RISK_HEAVY_BYTES (16.0 * 1024 * 1024)
+#define RISK_EXTREME_BYTES (1024.0 * 1024 * 1024)
+
+/*
+ * Applies the rule based line deductions (see applyLineRules()) across the puzzle until
+ * they stop solving cells, as propagateRules() does before the sweeps, over packed line
+ * words instead of a built puzzle. Lines are indexed as the clues are, rows then columns.
+ *
+ * Returns FALSE if a line's clues contradict its cells.
+ */
+static bool propagateEstimate (LineClue ** lineClues, int width, int length, uint64_t * known, uint64_t * filled)
+{
+	int i, cell, cross, position;
+	bool progress = TRUE;
+	uint64_t solved;
+	Line line;
+
+	memset(known, 0, sizeof(uint64_t) * (width + length));
+	memset(filled, 0, sizeof(uint64_t) * (width + length));
+
+	while (progress)
+	{
+		progress = FALSE;
+
+		for (i = 0; i < width + length; ++i)
+		{
+			memset(&line, 0, sizeof(line));
+			line.clueSet = lineClues[i];
+			line.size = (i < length) ? width : length;
+			line.maskBits = known[i];
+			line.partialBits = filled[i];
+
+			if (!applyLineRules(&line))
+				return FALSE;
+
+			solved = line.maskBits & ~known[i];
+			if (solved == 0ULL)
+				continue;
+
+			known[i] = line.maskBits;
+			filled[i] = line.partialBits & line.maskBits;
+			progress = TRUE;
+
+			/* Row r's cell c is column c's cell r */
+			position = (i < length) ? i : i - length;
+
+			for ( ; solved != 0ULL; solved &= solved - 1)
+			{
+				cell = __builtin_ctzll(solved);
+				cross = (i < length) ? length + cell : cell;
+
+				if ((known[cross] >> position & 1ULL) && (filled[cross] >> position & 1ULL) != (filled[i] >> cell & 1ULL))
+					return FALSE;
+
+				known[cross] |= 1ULL << position;
+				filled[cross] |= (filled[i] >> cell & 1ULL) << position;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+/*
+ * Estimates a puzzle's cost. The rule based deductions are propagated across the lines
+ * first (see propagateEstimate()), then each line left open is priced by the placements
+ * consistent with its solved cells (see countPlacements()), as solveLinePermutations()
+ * budgets them: a word, a BitSet bit and a bit per cell of index each.
+ *
+ * The sweeps enumerate lines after solving more cells than the rules do, so the counts
+ * are upper bounds; nor can the estimate tell whether probing and search will be needed.
+ *
+ * Parameters:
+ * - lineClues : The clues, rows then columns, as readFile() returns them.
+ * - width, length : The puzzle dimensions, each at most 64.
+ * - estimate : Receives the estimate.
+ * - lineCounts : Optional (may be NULL), receives width + length placement counts, 0 for
+ *                lines the rules solve.
+ *
+ * Returns FALSE if the clues cannot fit their lines, their row and column totals differ
+ * (see validateClues()) or the rules find them contradictory, with estimate left empty.
+ */
+bool estimateClues (LineClue ** lineClues, int width, int length, PuzzleEstimate * estimate, double * lineCounts)
+{
+	int i;
+	double placements;
+	uint64_t known[2 * MAX_LINE_SIZE], filled[2 * MAX_LINE_SIZE];
+	Line line;
+
+	memset(estimate, 0, sizeof(PuzzleEstimate));
+	estimate->largestLine = -1;
+
+	if (!validateClues(lineClues, width, length) || !propagateEstimate(lineClues, width, length, known, filled))
+		return FALSE;
+
+	estimate->width = width;
+	estimate->length = length;
+
+	for (i = 0; i < width + length; ++i)
+	{
+		memset(&line, 0, sizeof(line));
+		line.clueSet = lineClues[i];
+		line.size = (i < length) ? width : length;
+		line.maskBits = known[i];
+		line.partialBits = filled[i];
+
+		placements = isLineSolved(&line) ? 0.0 : countPlacements(&line);
+
+		if (lineCounts != NULL)
+			lineCounts[i] = placements;
+
+		if (placements == 0.0)
+			continue;
+
+		++estimate->openLines;
+		estimate->totalPlacements += placements;
+		estimate->peakBytes += placements * (sizeof(uint64_t) + (line.size + 1) / 8.0);
+
+		if (placements > estimate->largestPlacements)
+		{
+			estimate->largestPlacements = placements;
+			estimate->largestLine = i;
+		}
+	}
+
+	if (estimate->peakBytes < RISK_LIGHT_BYTES)
+		estimate->risk = RISK_TRIVIAL;
+	else if (estimate->peakBytes < RISK_HEAVY_BYTES)
+		estimate->risk = RISK_LIGHT;
+	else if (estimate->peakBytes < RISK_EXTREME_BYTES)
+		estimate->risk = RISK_HEAVY;
+	else
+		estimate->risk = RISK_EXTREME;
+
+	return TRUE;
+}
+
+/*
+ * estimateClues() for puzzle text held in memory (see readBuffer()).
+ *
+ * Returns FALSE if the text does not parse or the clues are rejected, with the reason in
+ * error (optional, may be NULL).
+ */
+bool estimateBuffer (const char * buffer, size_t size, PuzzleEstimate * estimate, char * error, size_t errorSize)
+{
+	int width = 0, length = 0;
+	bool valid;
+	LineClue ** lineClues = readBuffer(buffer, size, &width, &length, error, errorSize);
+
+	if (lineClues == NULL)
+	{
+		memset(estimate, 0, sizeof(PuzzleEstimate));
+		estimate->largestLine = -1;
+		return FALSE;
+	}
+
+	valid = estimateClues(lineClues, width, length, estimate, NULL);
+
+	if (!valid && error != NULL && errorSize > 0)
+		snprintf(error, errorSize, "Clues contradict each other.");
+
+	freeLineClues(lineClues, width + length);
+
+	return valid;
+}
+
+/*
+ * Returns the name of a risk class.
+ */
+const char * riskClassName (RiskClass risk)
+{
+	switch (risk)
+	{
+		case RISK_TRIVIAL: return "trivial";
+		case RISK_LIGHT: return "light";
+		case RISK_HEAVY: return "heavy";
+		case RISK_EXTREME: return "extreme";
+	}
+
+	return "unknown";
+}
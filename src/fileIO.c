@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
 
 /*
  * Opens an input file either from the command-line argument or via user input.
@@ -60,49 +61,126 @@ FILE * getFile (int argc, char * argv)
 	return fPtr;
 }
 
+/* Where parseClues() reads puzzle text from: an open stream or a memory buffer */
+typedef struct ClueSource {
+	FILE * filePtr;
+	const char * buffer;
+	size_t size;
+	size_t position;
+} ClueSource;
+
+/*
+ * Reads the next line of a clue source into line (at most capacity - 1 characters, like
+ * fgets(), keeping the newline). Returns FALSE at the end of the source.
+ */
+static bool readSourceLine (ClueSource * source, char * line, int capacity)
+{
+	int count = 0;
+
+	if (source->filePtr != NULL)
+		return fgets(line, capacity, source->filePtr) != NULL;
+
+	if (source->position >= source->size || source->buffer[source->position] == '\0')
+		return FALSE;
+
+	while (count < capacity - 1 && source->position < source->size && source->buffer[source->position] != '\0')
+	{
+		line[count] = source->buffer[source->position++];
+
+		if (line[count++] == '\n')
+			break;
+	}
+
+	line[count] = '\0';
+
+	return TRUE;
+}
+
+/*
+ * Formats a parse error into the caller's buffer (ignored when error is NULL).
+ */
+static void reportError (char * error, size_t errorSize, const char * format, ...)
+{
+	va_list args;
+
+	if (error == NULL || errorSize == 0)
+		return;
+
+	va_start(args, format);
+	vsnprintf(error, errorSize, format, args);
+	va_end(args);
+
+	return;
+}
+
 /*
- * Parses a puzzle file to extract the gameboard dimensions and clues.
+ * Parses puzzle text to extract the gameboard dimensions and clues.
  *
- * Expected file format:
- * - First line: two integers (width height)
+ * Expected format:
+ * - First line: two integers (width height), then for colour puzzles the number of colours
+ *   (not counting the background)
  * - Next (width + height) lines: clues for each row and column, space-separated
  *
  * Parsing details:
- * - Width and height must be integers with no trailing garbage.
+ * - Width and height must be integers between 1 and MAX_LINE_SIZE with no trailing garbage.
  * - Each clue line must contain only valid integers (1–50), separated by spaces.
+ * - In colour puzzles a clue may be followed directly by its colour, a letter from 'a' (the
+ *   first colour, and the colour of clues without one), e.g. "3a 1b 2a".
  * - Ignores trailing whitespace, but rejects any other trailing characters.
- * - Maximum 32 clues per line.
+ * - Maximum MAX_CLUES clues per line.
+ *
+ * Parameters:
+ * - colourCount : Receives the number of colours, 1 for black and white puzzles, whose
+ *                 clues are left without colours. NULL rejects colour puzzles.
  *
  * Returns:
  * - A pointer to an array of LineClue pointers (rows first, then columns), or NULL on error.
- * - On error, prints a detailed message and frees all allocated memory.
+ * - On error, describes the problem in error and frees all allocated memory.
  *
  * TODO: Add support for alternative delimiters beyond space (e.g., tabs or commas).
  */
-LineClue ** readFile (FILE * fPtr, int * width, int * length)
+static LineClue ** parseClues (ClueSource * source, int * width, int * length, int * colourCount, char * error, size_t errorSize)
 {
 	char fileLine[256], * rest = NULL;
 	int numCharsRead = 0, fileLineNum = 0;
-	int i, j, offset = 0;
-	int clueBuffer[32];
+	int i, j, offset = 0, colours = 1;
+	int clueBuffer[MAX_CLUES], colourBuffer[MAX_CLUES];
 	LineClue ** lineClues = NULL;
 
-	/* Reading gameboard width and length from file with validation checking */
-	if (!fgets(fileLine, sizeof(fileLine), fPtr))
+	/* Reading gameboard width and length with validation checking */
+	if (!readSourceLine(source, fileLine, sizeof(fileLine)))
 	{
-		fprintf(stderr,"Error: Empty file or read error.\n");
+		reportError(error, errorSize, "Error: Empty file or read error.");
 		return NULL;
 	}
 	++fileLineNum;
 	
 	if (sscanf(fileLine, "%d %d %n", width, length, &numCharsRead) != 2)
 	{
-		fprintf(stderr,"Invalid contents on line %d: expected two integers (width, length).\n", fileLineNum);
+		reportError(error, errorSize, "Invalid contents on line %d: expected two integers (width, length).", fileLineNum);
 		return NULL;
 	}
 
 	rest = fileLine + numCharsRead;
 
+	/* An optional third integer makes it a colour puzzle */
+	if (sscanf(rest, "%d %n", &colours, &numCharsRead) == 1)
+	{
+		if (colourCount == NULL)
+		{
+			reportError(error, errorSize, "Invalid contents on line %d: colour puzzles are not supported here.", fileLineNum);
+			return NULL;
+		}
+
+		if (colours < 1 || colours > MAX_COLOURS)
+		{
+			reportError(error, errorSize, "Invalid contents on line %d: colours must be between 1 and %d.", fileLineNum, MAX_COLOURS);
+			return NULL;
+		}
+
+		rest += numCharsRead;
+	}
+
 	/* Looping until the null terminator is reach or a non space character */
 	while (*rest != '\0' && isspace((unsigned char) *rest)) ++rest;
 
@@ -110,7 +188,14 @@ LineClue ** readFile (FILE * fPtr, int * width, int * length)
 		and length */
 	if (*rest != '\0')
 	{
-		fprintf(stderr,"Invalid contents on line %d: trailing characters after width/length.\n", fileLineNum);
+		reportError(error, errorSize, "Invalid contents on line %d: trailing characters after width/length.", fileLineNum);
+		return NULL;
+	}
+
+	/* Each line is stored as bits of a uint64_t */
+	if (*width < 1 || *width > MAX_LINE_SIZE || *length < 1 || *length > MAX_LINE_SIZE)
+	{
+		reportError(error, errorSize, "Invalid contents on line %d: width and length must be between 1 and %d.", fileLineNum, MAX_LINE_SIZE);
 		return NULL;
 	}
 
@@ -118,16 +203,16 @@ LineClue ** readFile (FILE * fPtr, int * width, int * length)
 
 	if (lineClues == NULL)
 	{
-		fprintf(stderr, "Error allocating memory for references to each lines clues struct\n");
+		reportError(error, errorSize, "Error allocating memory for references to each lines clues struct");
 		return NULL;
 	}
 
 	/* Reading each line of clues */
 	for (i = 0; i < (*width + *length); ++i)
 	{		
-		if (!fgets(fileLine, sizeof(fileLine), fPtr))
+		if (!readSourceLine(source, fileLine, sizeof(fileLine)))
 		{
-			fprintf(stderr,"Error: EOF unexpectedly reached after line: %d\n", fileLineNum);
+			reportError(error, errorSize, "Error: EOF unexpectedly reached after line: %d", fileLineNum);
 			goto free_Memory;
 		}
 		
@@ -138,15 +223,34 @@ LineClue ** readFile (FILE * fPtr, int * width, int * length)
 		/* Reading in one integer at a time until a match is not made or buffer limit reached.
 			Adds a progressive offset to the string being passed to sscanf  to accomplish reading
 			one integer at a time. */
-		while (j < 32 && sscanf(fileLine + offset, "%d %n", &clueBuffer[j], &numCharsRead) == 1)
+		while (j < MAX_CLUES && sscanf(fileLine + offset, "%d%n", &clueBuffer[j], &numCharsRead) == 1)
 		{ 
 			if (clueBuffer[j] < 1 || clueBuffer[j] > 50)
 			{
-				fprintf(stderr,"Invalid file contents line: %d, Expecting integers between 1 and 50.\n", fileLineNum);
+				reportError(error, errorSize, "Invalid file contents line: %d, Expecting integers between 1 and 50.", fileLineNum);
 				goto free_Memory;
 			}
 
 			offset += numCharsRead;
+			colourBuffer[j] = 1;
+
+			/* A colour letter, only in colour puzzles */
+			if (colourCount != NULL && islower((unsigned char) fileLine[offset]))
+			{
+				colourBuffer[j] = fileLine[offset++] - 'a' + 1;
+
+				if (colourBuffer[j] > colours)
+				{
+					reportError(error, errorSize, "Invalid contents on line %d: colour '%c' beyond the %d declared.", fileLineNum, fileLine[offset - 1], colours);
+					goto free_Memory;
+				}
+			}
+
+			/* A clue must end at a space */
+			if (fileLine[offset] != '\0' && !isspace((unsigned char) fileLine[offset]))
+				break;
+
+			while (isspace((unsigned char) fileLine[offset])) ++offset;
 			++j;
 		}
 
@@ -158,18 +262,21 @@ LineClue ** readFile (FILE * fPtr, int * width, int * length)
 		/* If the null terminator is not reached then an invalid character is in the line after the clues */
 		if (*rest != '\0')
 		{
-			fprintf(stderr,"Invalid contents on line %d: trailing characters after clues.\n", fileLineNum);
+			reportError(error, errorSize, "Invalid contents on line %d: trailing characters after clues.", fileLineNum);
 			goto free_Memory;
 		}
 
-		lineClues[i] = createLineClueSet(clueBuffer, j);
+		lineClues[i] = (colours > 1) ? createColourClueSet(clueBuffer, colourBuffer, j) : createLineClueSet(clueBuffer, j);
 
 		if (lineClues[i] == NULL)
 		{
-			fprintf(stderr,"Error allocating memory for clueSet on line: %d\n", fileLineNum);
+			reportError(error, errorSize, "Error allocating memory for clueSet on line: %d", fileLineNum);
 			goto free_Memory;
 		}
 	}
+
+	if (colourCount != NULL)
+		*colourCount = colours;
 	
 	return lineClues;
 
@@ -179,6 +286,9 @@ free_Memory:
 		free(lineClues[i]->clues);
 		lineClues[i]->clues = NULL;
 
+		free(lineClues[i]->colours);
+		lineClues[i]->colours = NULL;
+
 		free(lineClues[i]);
 		lineClues[i] = NULL;
 	}
@@ -188,3 +298,145 @@ free_Memory:
 		
 	return lineClues;
 }
+
+/*
+ * Parses a puzzle file (see parseClues() for the format), printing any error to stderr.
+ *
+ * Returns the clues (rows first, then columns), or NULL on error.
+ */
+LineClue ** readFile (FILE * fPtr, int * width, int * length)
+{
+	char error[256];
+	ClueSource source = { fPtr, NULL, 0, 0 };
+	LineClue ** lineClues = parseClues(&source, width, length, NULL, error, sizeof(error));
+
+	if (lineClues == NULL)
+		fprintf(stderr, "%s\n", error);
+
+	return lineClues;
+}
+
+/*
+ * Parses puzzle text held in memory (see parseClues() for the format) without printing.
+ *
+ * Parameters:
+ * - buffer    : The puzzle text, read up to size bytes or a NUL, whichever comes first.
+ * - size      : Length of buffer in bytes.
+ * - width     : Receives the gameboard width.
+ * - length    : Receives the gameboard length.
+ * - error     : Optional (may be NULL), receives a description of a parse error.
+ * - errorSize : Capacity of error in bytes.
+ *
+ * Returns the clues (rows first, then columns), or NULL on error.
+ */
+LineClue ** readBuffer (const char * buffer, size_t size, int * width, int * length, char * error, size_t errorSize)
+{
+	ClueSource source = { NULL, buffer, size, 0 };
+
+	if (buffer == NULL)
+	{
+		reportError(error, errorSize, "Error: Empty file or read error.");
+		return NULL;
+	}
+
+	return parseClues(&source, width, length, NULL, error, errorSize);
+}
+
+/*
+ * readFile() for black and white or colour puzzles (see parseClues() for the format).
+ *
+ * Parameters:
+ * - colourCount : Receives the number of colours, 1 for a black and white puzzle.
+ *
+ * Returns the clues (rows first, then columns), or NULL on error.
+ */
+LineClue ** readColourFile (FILE * fPtr, int * width, int * length, int * colourCount)
+{
+	char error[256];
+	ClueSource source = { fPtr, NULL, 0, 0 };
+	LineClue ** lineClues = parseClues(&source, width, length, colourCount, error, sizeof(error));
+
+	if (lineClues == NULL)
+		fprintf(stderr, "%s\n", error);
+
+	return lineClues;
+}
+
+/*
+ * readBuffer() for black and white or colour puzzles (see readColourFile()).
+ */
+LineClue ** readColourBuffer (const char * buffer, size_t size, int * width, int * length, int * colourCount, char * error, size_t errorSize)
+{
+	ClueSource source = { NULL, buffer, size, 0 };
+
+	if (buffer == NULL)
+	{
+		reportError(error, errorSize, "Error: Empty file or read error.");
+		return NULL;
+	}
+
+	return parseClues(&source, width, length, colourCount, error, errorSize);
+}
+
+/*
+ * Returns TRUE if the puzzle file's first line declares colours, leaving the file at its
+ * start either way.
+ */
+bool isColourFile (FILE * fPtr)
+{
+	char fileLine[256];
+	int width, length, colours;
+	bool colour;
+
+	colour = fgets(fileLine, sizeof(fileLine), fPtr) != NULL && sscanf(fileLine, "%d %d %d", &width, &length, &colours) == 3;
+	rewind(fPtr);
+
+	return colour;
+}
+
+/*
+ * Reads a gameboard as rows of cells: '#' filled, '.' empty and '?' unknown, anything
+ * else (newlines, spaces, ';' row separators) skipped.
+ *
+ * Parameters:
+ * - fPtr : The open board file.
+ * - width, length : The puzzle dimensions; exactly width * length cells must be read.
+ *
+ * Returns the gameboard (1 filled, 0 empty, -1 unknown, row major), or NULL if the cell
+ * count is wrong or memory runs out; errors are printed to stderr.
+ */
+int * readGameBoard (FILE * fPtr, int width, int length)
+{
+	int character, index = 0;
+	const int cellCount = width * length;
+	int * gameBoard = (int *)malloc(sizeof(int) * cellCount);
+
+	if (gameBoard == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the gameboard\n");
+		return NULL;
+	}
+
+	while ((character = fgetc(fPtr)) != EOF)
+	{
+		if (character != '#' && character != '.' && character != '?')
+			continue;
+
+		if (index == cellCount)
+		{
+			++index;
+			break;
+		}
+
+		gameBoard[index++] = (character == '#') ? 1 : (character == '.') ? 0 : -1;
+	}
+
+	if (index != cellCount)
+	{
+		fprintf(stderr, "Board has %s cells, expected %d (%d x %d).\n", (index > cellCount) ? "too many" : "too few", cellCount, width, length);
+		free(gameBoard);
+		return NULL;
+	}
+
+	return gameBoard;
+}
@@ -31,52 +31,246 @@ int * createGameBoard (int width, int length)
 	return gameBoard;
 }
 
+/* Output being rendered: bytes go in while they fit, length counts them all */
+typedef struct RenderBuffer {
+	char * data;
+	size_t capacity;
+	size_t length;
+} RenderBuffer;
+
+static void putBytes (RenderBuffer * output, const char * bytes, size_t count)
+{
+	if (output->length < output->capacity)
+		memcpy(output->data + output->length, bytes, (output->capacity - output->length < count) ? output->capacity - output->length : count);
+
+	output->length += count;
+
+	return;
+}
+
+static void putByte (RenderBuffer * output, char byte)
+{
+	if (output->length < output->capacity)
+		output->data[output->length] = byte;
+
+	++output->length;
+
+	return;
+}
+
 /*
- * Prints a formatted view of the gameboard to the terminal.
- *
- * Cell representations:
- * - '■' for filled cells (1)
- * - 'X' for empty cells (0)
- * - ' ' for unsolved cells (-1)
- *
- * The board is grouped into 5×5 visual blocks for readability.
+ * Renders the grid view: '■' filled, 'X' empty, ' ' unsolved, grouped into 5×5 blocks.
  */
-void printGameBoard (int * gameBoard, int width, int length)
+static void renderGrid (RenderBuffer * output, const int * gameBoard, int width, int length)
 {
 	int i, j;
 
 	/* charWidth accounts for cell spacing and grid lines */
-	int charWidth = 2 * (width + (width / 5)) + 2;
-	char borderLine[123];
+	const int charWidth = 2 * (width + (width / 5)) + 2;
 
-	/* Create horizontal seperator and null terminate so expected width is printed */
-	memset(borderLine, '-', charWidth);
-	borderLine[0] = ' ';
-	borderLine[charWidth] = '\0';
-
-	for (i = 0; i < length; ++i)
+	for (i = 0; i <= length; ++i)
 	{
-		/* Draw horizontal separator every 5 rows */
-		if (i % 5 == 0)
-			printf("%s\n", borderLine);
+		/* Draw horizontal separator every 5 rows and under the last */
+		if (i % 5 == 0 || i == length)
+		{
+			putByte(output, ' ');
+			for (j = 1; j < charWidth; ++j)
+				putByte(output, '-');
+			putByte(output, '\n');
+		}
+
+		if (i == length)
+			break;
 
 		for (j = 0; j < width; ++j)
 		{
 			/* Draw vertical separator every 5 columns */
 			if (j % 5 == 0)
-				printf(" |");
+				putBytes(output, " |", 2);
 
 			if (gameBoard[j + (i * width)] == 1)
-				printf(" ■");
+				putBytes(output, " ■", sizeof(" ■") - 1);
 			else if (gameBoard[j + (i * width)] == 0)
-				printf(" X");
+				putBytes(output, " X", 2);
 			else
-				printf("  ");
+				putBytes(output, "  ", 2);
 		}
-		printf(" |\n");
+		putBytes(output, " |\n", 3);
 	}
-	printf("%s\n", borderLine);
-	
+
+	return;
+}
+
+/*
+ * Renders a gameboard into buffer in the given format, like snprintf(): at most capacity
+ * bytes are written and the output is not NUL terminated.
+ *
+ * Formats:
+ * - BOARD_GRID   : The terminal view, '■' filled, 'X' empty, ' ' unsolved, in 5×5 blocks.
+ * - BOARD_ROWS   : One line, '#' filled, '.' empty, '?' unsolved, rows separated by ';'.
+ * - BOARD_PBM    : A binary PBM (P4) image, filled cells black, rows padded to bytes.
+ * - BOARD_BINARY : A byte each of width and length, then each row in (width + 7) / 8
+ *                  bytes, cell c at bit c % 8 of byte c / 8 (rows as packGameBoard() packs
+ *                  them, little endian), set when filled.
+ * - BOARD_QUIET  : Nothing.
+ * PBM and binary output do not distinguish unsolved cells from empty ones.
+ *
+ * Returns the full length of the output, which was truncated if it exceeds capacity, so a
+ * call with capacity 0 (buffer may then be NULL) sizes it.
+ */
+size_t renderGameBoard (const int * gameBoard, int width, int length, BoardFormat format, char * buffer, size_t capacity)
+{
+	int i, j;
+	char header[32], byte;
+	RenderBuffer output = { buffer, (buffer != NULL) ? capacity : 0, 0 };
+
+	switch (format)
+	{
+		case BOARD_GRID:
+			renderGrid(&output, gameBoard, width, length);
+			break;
+
+		case BOARD_ROWS:
+			for (i = 0; i < width * length; ++i)
+			{
+				if (i > 0 && i % width == 0)
+					putByte(&output, ';');
+
+				putByte(&output, (gameBoard[i] == 1) ? '#' : (gameBoard[i] == 0) ? '.' : '?');
+			}
+			putByte(&output, '\n');
+			break;
+
+		case BOARD_PBM:
+		case BOARD_BINARY:
+			if (format == BOARD_PBM)
+				putBytes(&output, header, (size_t)snprintf(header, sizeof(header), "P4\n%d %d\n", width, length));
+			else
+			{
+				putByte(&output, (char)width);
+				putByte(&output, (char)length);
+			}
+
+			for (i = 0; i < length; ++i)
+				for (j = 0, byte = 0; j < width; ++j)
+				{
+					/* PBM packs the leftmost pixel in the high bit */
+					if (gameBoard[i * width + j] == 1)
+						byte |= (char)((format == BOARD_PBM) ? 0x80 >> (j % 8) : 1 << (j % 8));
+
+					if (j % 8 == 7 || j == width - 1)
+					{
+						putByte(&output, byte);
+						byte = 0;
+					}
+				}
+			break;
+
+		case BOARD_QUIET:
+			break;
+	}
+
+	return output.length;
+}
+
+/*
+ * Renders the gameboard (see renderGameBoard()) and writes it to fPtr in one write.
+ *
+ * Returns FALSE if memory runs out or the write fails.
+ */
+bool writeGameBoard (FILE * fPtr, const int * gameBoard, int width, int length, BoardFormat format)
+{
+	bool written;
+	size_t size = renderGameBoard(gameBoard, width, length, format, NULL, 0);
+	char * buffer = NULL;
+
+	if (size == 0)
+		return TRUE;
+
+	buffer = (char *)malloc(size);
+	if (buffer == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the gameboard output\n");
+		return FALSE;
+	}
+
+	renderGameBoard(gameBoard, width, length, format, buffer, size);
+	written = fwrite(buffer, 1, size, fPtr) == size;
+
+	free(buffer);
+
+	return written;
+}
+
+/*
+ * Renders a colour gameboard (0 background, k colour k, -1 unsolved, row major) into
+ * buffer like renderGameBoard(), '.' background, 'a' the first colour, 'b' the second
+ * and so on, '?' unsolved.
+ *
+ * Formats:
+ * - BOARD_GRID   : A line per row.
+ * - BOARD_ROWS   : One line, rows separated by ';'.
+ * - BOARD_QUIET  : Nothing.
+ * PBM and binary output hold a bit per cell and cannot show colours, they render nothing.
+ *
+ * Returns the full length of the output, width + 1 bytes a row for the text formats.
+ */
+size_t renderColourBoard (const int * gameBoard, int width, int length, BoardFormat format, char * buffer, size_t capacity)
+{
+	int i;
+	RenderBuffer output = { buffer, (buffer != NULL) ? capacity : 0, 0 };
+
+	if (format != BOARD_GRID && format != BOARD_ROWS)
+		return 0;
+
+	for (i = 0; i < width * length; ++i)
+	{
+		putByte(&output, (gameBoard[i] > 0) ? (char)('a' + gameBoard[i] - 1) : (gameBoard[i] == 0) ? '.' : '?');
+
+		if (i % width == width - 1)
+			putByte(&output, (format == BOARD_ROWS && i < width * length - 1) ? ';' : '\n');
+	}
+
+	return output.length;
+}
+
+/*
+ * Renders a colour gameboard (see renderColourBoard()) and writes it to fPtr in one write.
+ *
+ * Returns FALSE if memory runs out or the write fails.
+ */
+bool writeColourBoard (FILE * fPtr, const int * gameBoard, int width, int length, BoardFormat format)
+{
+	bool written;
+	size_t size = renderColourBoard(gameBoard, width, length, format, NULL, 0);
+	char * buffer = NULL;
+
+	if (size == 0)
+		return TRUE;
+
+	buffer = (char *)malloc(size);
+	if (buffer == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the gameboard output\n");
+		return FALSE;
+	}
+
+	renderColourBoard(gameBoard, width, length, format, buffer, size);
+	written = fwrite(buffer, 1, size, fPtr) == size;
+
+	free(buffer);
+
+	return written;
+}
+
+/*
+ * Prints a formatted view of the gameboard to the terminal (see renderGameBoard() for
+ * BOARD_GRID).
+ */
+void printGameBoard (int * gameBoard, int width, int length)
+{
+	writeGameBoard(stdout, gameBoard, width, length, BOARD_GRID);
+
 	return;
 }
 
@@ -87,10 +281,12 @@ void printGameBoard (int * gameBoard, int width, int length)
  * - If the corresponding gameboard cell is unsolved (-1), it is set to 1 (filled) or 0 (empty)
  *   depending on the matching bit in partialBits.
  * - The corresponding column is marked as updated in columnsToUpdate[].
+ *
+ * Returns FALSE if a solved bit contradicts a cell that is already solved on the gameboard.
  */
-void setGameBoardRow (int * gameBoard, Line * line, int * columnsToUpdate)
+bool setGameBoardRow (int * gameBoard, Line * line, int * columnsToUpdate)
 {
-	int i;
+	int i, value;
 	const int width = line->size;
 	const uint64_t maskBits = line->maskBits;
 	const uint64_t partialBits = line->partialBits;
@@ -101,15 +297,23 @@ void setGameBoardRow (int * gameBoard, Line * line, int * columnsToUpdate)
 
 	for (i = 0; i < width; ++i, compareBit <<= 1)
 	{
+		if ((compareBit & maskBits) == 0)
+			continue;
+
+		value = ((compareBit & partialBits) == 0) ? 0 : 1;
+
 		/* If this bit is marked as solved and the cell in the gameBoard is unsolved */
-		if ((compareBit & maskBits) != 0 && gameBoard[i] == -1)
+		if (gameBoard[i] == -1)
 		{
-			gameBoard[i] = ((compareBit & partialBits) == 0) ? 0 : 1;
+			gameBoard[i] = value;
 			columnsToUpdate[i] = 1;
 		}
+
+		else if (gameBoard[i] != value)
+			return FALSE;
 	}
 
-	return;
+	return TRUE;
 }
 
 /*
@@ -119,10 +323,12 @@ void setGameBoardRow (int * gameBoard, Line * line, int * columnsToUpdate)
  * - If the corresponding gameboard cell is unsolved (-1), it is set to 1 (filled) or 0 (empty)
  *   depending on the matching bit in partialBits.
  * - The corresponding row is marked as updated in rowsToUpdate[].
+ *
+ * Returns FALSE if a solved bit contradicts a cell that is already solved on the gameboard.
  */
-void setGameBoardColumn (int * gameBoard, Line * line, int width, int * rowsToUpdate)
+bool setGameBoardColumn (int * gameBoard, Line * line, int width, int * rowsToUpdate)
 {
-	int i, index = line->lineId - width;
+	int i, value, index = line->lineId - line->size;
 	const int length = line->size;
 	const uint64_t maskBits = line->maskBits;
 	const uint64_t partialBits = line->partialBits;
@@ -130,15 +336,23 @@ void setGameBoardColumn (int * gameBoard, Line * line, int width, int * rowsToUp
 
 	for (i = 0; i < length; ++i, compareBit <<= 1, index += width)
 	{
+		if ((compareBit & maskBits) == 0)
+			continue;
+
+		value = ((compareBit & partialBits) == 0) ? 0 : 1;
+
 		/* If this bit is marked as solved and the cell in the gameBoard is unsolved */
-		if ((compareBit & maskBits) != 0 && gameBoard[index] == -1)
+		if (gameBoard[index] == -1)
 		{
-			gameBoard[index] = ((compareBit & partialBits) == 0) ? 0 : 1;
+			gameBoard[index] = value;
 			rowsToUpdate[i] = 1;
 		}
+
+		else if (gameBoard[index] != value)
+			return FALSE;
 	}
 
-	return;
+	return TRUE;
 }
 
 /*
@@ -0,0 +1,275 @@
+#include "../include/lineCache.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Memo of line solves: maps a line's clues and known cells to the cells they force, or to
+ * a contradiction.
+ *
+ * The result of solving a line only depends on its clues, its size and which cells are
+ * already known, so a state met again (a probe or a search branch revisiting it, or a
+ * line with the same clues as another) can reuse it. The table is direct mapped with a
+ * fixed number of slots: a new state simply replaces whatever shared its slot. Slots are
+ * guarded by a small set of striped locks so the parallel search can share one cache.
+ *
+ * A cache may also outlive its puzzles and be shared by many (the daemon keeps one for its
+ * lifetime). Their lines then take keys from lineCacheKey(), which numbers clue sequences
+ * across every puzzle using the cache. Keys are never reused: once the key table fills it
+ * is emptied and numbering carries on, so entries under the forgotten keys can no longer
+ * be hit and age out of their slots.
+ */
+
+/* Number of striped locks, a power of two */
+#define LINE_CACHE_LOCKS 64
+
+/* Slots of the clue sequence table behind lineCacheKey(), a power of two */
+#define LINE_CACHE_KEY_SLOTS 4096
+
+/* Clue sequences held before the table is emptied, keeping its probe chains short */
+#define LINE_CACHE_MAX_KEYS (LINE_CACHE_KEY_SLOTS / 2)
+
+typedef struct CacheEntry {
+	uint64_t maskBits;
+	uint64_t partialBits;
+	uint64_t solvedMask;
+	uint64_t solvedPartial;
+	int key;
+	int feasible;
+} CacheEntry;
+
+/* A clue sequence and size numbered by lineCacheKey(), key -1 for an empty slot */
+typedef struct KeyRecord {
+	int key;
+	int size;
+	int clueCount;
+	int clues[MAX_CLUES];
+} KeyRecord;
+
+struct LineCache {
+	CacheEntry * entries;
+	uint64_t slotMask;
+	pthread_mutex_t locks[LINE_CACHE_LOCKS];
+	atomic_long lookups;
+	atomic_long hits;
+	pthread_mutex_t keyLock;    /* Guards the key table */
+	KeyRecord * keys;           /* LINE_CACHE_KEY_SLOTS records, allocated on first use */
+	int keyCount;
+	int nextKey;
+};
+
+/*
+ * Mixes a line key and its known cells into a slot hash.
+ */
+static uint64_t hashState (int key, uint64_t maskBits, uint64_t partialBits)
+{
+	uint64_t hash = ((uint64_t)key * 0x9E3779B97F4A7C15ULL) ^ maskBits;
+
+	hash = (hash ^ (hash >> 31)) * 0xBF58476D1CE4E5B9ULL ^ partialBits;
+	hash = (hash ^ (hash >> 29)) * 0x94D049BB133111EBULL;
+
+	return hash ^ (hash >> 32);
+}
+
+/*
+ * Allocates an empty cache of at least slotCount slots (rounded up to a power of two).
+ * Returns NULL if memory runs out.
+ */
+LineCache * createLineCache (int slotCount)
+{
+	int i;
+	uint64_t slots = 64;
+	LineCache * cache = (LineCache *)malloc(sizeof(LineCache));
+
+	if (cache == NULL)
+		return NULL;
+
+	while (slots < (uint64_t)slotCount)
+		slots <<= 1;
+
+	cache->entries = (CacheEntry *)malloc(sizeof(CacheEntry) * slots);
+	if (cache->entries == NULL)
+	{
+		free(cache);
+		return NULL;
+	}
+
+	for (i = 0; i < (int)slots; ++i)
+		cache->entries[i].key = -1;
+
+	for (i = 0; i < LINE_CACHE_LOCKS; ++i)
+		pthread_mutex_init(&cache->locks[i], NULL);
+
+	cache->slotMask = slots - 1;
+	atomic_init(&cache->lookups, 0);
+	atomic_init(&cache->hits, 0);
+
+	pthread_mutex_init(&cache->keyLock, NULL);
+	cache->keys = NULL;
+	cache->keyCount = 0;
+	cache->nextKey = 0;
+
+	return cache;
+}
+
+void freeLineCache (LineCache * cache)
+{
+	int i;
+
+	if (cache == NULL) return;
+
+	for (i = 0; i < LINE_CACHE_LOCKS; ++i)
+		pthread_mutex_destroy(&cache->locks[i]);
+
+	pthread_mutex_destroy(&cache->keyLock);
+
+	free(cache->entries);
+	cache->entries = NULL;
+
+	free(cache->keys);
+	cache->keys = NULL;
+
+	free(cache);
+
+	return;
+}
+
+/*
+ * Returns the key of a line with the given clues and size, the same for every line (of any
+ * puzzle) with equal clues and size while it stays in the key table, or -1 if the table
+ * cannot be allocated. Safe to call from several threads.
+ */
+int lineCacheKey (LineCache * cache, const int * clues, int clueCount, int size)
+{
+	int i, key = -1;
+	uint64_t hash = (uint64_t)size;
+	KeyRecord * record = NULL;
+
+	for (i = 0; i < clueCount; ++i)
+		hash = (hash ^ (uint64_t)clues[i]) * 0x100000001B3ULL;
+
+	pthread_mutex_lock(&cache->keyLock);
+
+	if (cache->keys == NULL)
+	{
+		cache->keys = (KeyRecord *)malloc(sizeof(KeyRecord) * LINE_CACHE_KEY_SLOTS);
+
+		if (cache->keys == NULL)
+			goto key_Done;
+
+		cache->keyCount = LINE_CACHE_MAX_KEYS;
+	}
+
+	/* A full table is emptied (a new one is full), the keys it held are never handed out again */
+	if (cache->keyCount >= LINE_CACHE_MAX_KEYS)
+	{
+		for (i = 0; i < LINE_CACHE_KEY_SLOTS; ++i)
+			cache->keys[i].key = -1;
+
+		cache->keyCount = 0;
+	}
+
+	for (i = (int)(hash ^ (hash >> 32)) & (LINE_CACHE_KEY_SLOTS - 1); ; i = (i + 1) & (LINE_CACHE_KEY_SLOTS - 1))
+	{
+		record = cache->keys + i;
+
+		if (record->key == -1)
+			break;
+
+		if (record->size == size && record->clueCount == clueCount
+			&& (clueCount == 0 || memcmp(record->clues, clues, sizeof(int) * clueCount) == 0))
+		{
+			key = record->key;
+			goto key_Done;
+		}
+	}
+
+	record->key = key = cache->nextKey++;
+	record->size = size;
+	record->clueCount = clueCount;
+	if (clueCount > 0)
+		memcpy(record->clues, clues, sizeof(int) * clueCount);
+	++cache->keyCount;
+
+key_Done:
+	pthread_mutex_unlock(&cache->keyLock);
+
+	return key;
+}
+
+/*
+ * Looks up the solve of a line state: key identifies the clues and size (lines with equal
+ * clues and size share a key), maskBits/partialBits hold the known cells.
+ *
+ * Return:
+ * - 1 when the state is cached and has placements, maskBits and partialBits then gain the
+ *   cells every placement agrees on.
+ * - 0 when the state is cached as a contradiction.
+ * - -1 when the state is not cached, leaving the bits untouched.
+ */
+int lineCacheLookup (LineCache * cache, int key, uint64_t * maskBits, uint64_t * partialBits)
+{
+	int result = -1;
+	uint64_t slot = hashState(key, *maskBits, *partialBits) & cache->slotMask;
+	CacheEntry * entry = cache->entries + slot;
+	pthread_mutex_t * lock = &cache->locks[slot & (LINE_CACHE_LOCKS - 1)];
+
+	atomic_fetch_add_explicit(&cache->lookups, 1, memory_order_relaxed);
+
+	pthread_mutex_lock(lock);
+
+	if (entry->key == key && entry->maskBits == *maskBits && entry->partialBits == *partialBits)
+	{
+		result = entry->feasible;
+
+		if (result == 1)
+		{
+			*maskBits = entry->solvedMask;
+			*partialBits = entry->solvedPartial;
+		}
+	}
+
+	pthread_mutex_unlock(lock);
+
+	if (result != -1)
+		atomic_fetch_add_explicit(&cache->hits, 1, memory_order_relaxed);
+
+	return result;
+}
+
+/*
+ * Records the solve of a line state (keyed as for lineCacheLookup()), replacing whatever
+ * state held its slot. solvedMask/solvedPartial are only read when feasible is TRUE.
+ */
+void lineCacheStore (LineCache * cache, int key, uint64_t maskBits, uint64_t partialBits, bool feasible,
+	uint64_t solvedMask, uint64_t solvedPartial)
+{
+	uint64_t slot = hashState(key, maskBits, partialBits) & cache->slotMask;
+	CacheEntry * entry = cache->entries + slot;
+	pthread_mutex_t * lock = &cache->locks[slot & (LINE_CACHE_LOCKS - 1)];
+
+	pthread_mutex_lock(lock);
+
+	entry->key = key;
+	entry->maskBits = maskBits;
+	entry->partialBits = partialBits;
+	entry->feasible = feasible ? 1 : 0;
+	entry->solvedMask = feasible ? solvedMask : 0ULL;
+	entry->solvedPartial = feasible ? solvedPartial : 0ULL;
+
+	pthread_mutex_unlock(lock);
+
+	return;
+}
+
+/*
+ * Reports how many lookups the cache has served and how many of them were hits.
+ */
+void lineCacheStats (LineCache * cache, long * lookups, long * hits)
+{
+	*lookups = atomic_load(&cache->lookups);
+	*hits = atomic_load(&cache->hits);
+
+	return;
+}
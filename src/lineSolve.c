@@ -0,0 +1,421 @@
+#include "../include/lineSolve.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/puzzle.h"
+#include "../include/solver.h"
+
+/*
+ * Line solving on its own: one line's clues and known cells in, the cells they force (or a
+ * contradiction) out, with no puzzle around it. Real solves can capture every line they
+ * solve to a file, which replayLineCapture() runs again through either engine to measure
+ * and compare line throughput apart from the board orchestration.
+ *
+ * A capture holds one solve per text line, the line's size, its clues ('-' for none), its
+ * known and filled cells in hex and then the known and filled cells after solving, or 'x'
+ * for a contradiction:
+ *   20 3,1,4 f0 10 fffff 31
+ * Lines starting with '#' are comments.
+ */
+
+/* Longest capture line: 32 two digit clues and four 16 digit masks fit well within it */
+#define CAPTURE_LINE_LENGTH 512
+
+static FILE * captureStream = NULL;
+static atomic_bool capturing = FALSE;
+static pthread_mutex_t captureLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Line engines by name, in LineEngine order */
+static const char * const engineNames[] = { "placements", "permutations" };
+
+static uint64_t widthBits (int size)
+{
+	return (size == 64) ? ~0ULL : (1ULL << size) - 1ULL;
+}
+
+/*
+ * Checks a line for solveSingleLine(): a size the bit masks hold, clues of a length a line
+ * can have and filled cells that are known cells of the line.
+ */
+static bool validLine (const int * clues, int clueCount, int size, uint64_t maskBits, uint64_t partialBits)
+{
+	int i;
+
+	if (size < 1 || size > MAX_LINE_SIZE || clueCount < 0 || clueCount > MAX_CLUES || (clueCount > 0 && clues == NULL))
+		return FALSE;
+
+	if ((maskBits & ~widthBits(size)) != 0ULL || (partialBits & ~maskBits) != 0ULL)
+		return FALSE;
+
+	for (i = 0; i < clueCount; ++i)
+		if (clues[i] < 1 || clues[i] > MAX_LINE_SIZE)
+			return FALSE;
+
+	return TRUE;
+}
+
+/*
+ * The permutation engine, as the sweep solves a line on its first visit: the rule based
+ * deductions, then the consensus of every permutation that fits what they leave.
+ */
+static SolveStatus solveByPermutations (LineClue * clueSet, int size, uint64_t * maskBits, uint64_t * partialBits)
+{
+	SolveStatus status = SOLVE_IN_PROGRESS;
+	Line * line = createLine(clueSet, size, 0);
+
+	if (line == NULL)
+		return SOLVE_OUT_OF_MEMORY;
+
+	line->maskBits = *maskBits;
+	line->partialBits = *partialBits;
+
+	if (!applyLineRules(line))
+		status = SOLVE_UNSATISFIABLE;
+
+	else if (isLineSolved(line))
+		status = SOLVE_IN_PROGRESS;
+
+	else if (!enumeratePermutations(line))
+		status = SOLVE_OUT_OF_MEMORY;
+
+	else if (line->permutationCount == 0 || !generateConsistentPattern(line))
+		status = SOLVE_UNSATISFIABLE;
+
+	if (status == SOLVE_IN_PROGRESS)
+	{
+		*maskBits = line->maskBits;
+		*partialBits = line->partialBits & line->maskBits;
+	}
+
+	freeLine(line);
+
+	return status;
+}
+
+/*
+ * Solves one line from its clues and the cells already known, without a puzzle: maskBits
+ * holds the known cells and partialBits which of them are filled (bit i is cell i). Either
+ * engine finds every cell the clues force given the known ones.
+ *
+ * On success the forced cells are added to maskBits and partialBits, and the result is
+ * SOLVE_SOLVED once every cell is known, SOLVE_IN_PROGRESS otherwise. Returns
+ * SOLVE_UNSATISFIABLE, leaving the masks untouched, if no placement fits the known cells,
+ * SOLVE_INVALID_INPUT for a size or clues out of range (or filled cells outside the known
+ * ones) and SOLVE_OUT_OF_MEMORY if the permutations do not fit.
+ */
+SolveStatus solveSingleLine (LineEngine engine, const int * clues, int clueCount, int size, uint64_t * maskBits, uint64_t * partialBits)
+{
+	Line line;
+	LineClue clueSet = { (int *)clues, clueCount, NULL };
+	uint64_t mask = *maskBits, partial = *partialBits;
+	int i, required = -1;
+	SolveStatus status;
+
+	if (!validLine(clues, clueCount, size, mask, partial))
+		return SOLVE_INVALID_INPUT;
+
+	/* Clues longer than the line fit nowhere, the engines assume they fit somewhere */
+	for (i = 0; i < clueCount; ++i)
+		required += clues[i] + 1;
+
+	if (required > size)
+		return SOLVE_UNSATISFIABLE;
+
+	if (engine == LINE_ENGINE_PERMUTATIONS)
+		status = solveByPermutations(&clueSet, size, &mask, &partial);
+
+	else
+	{
+		memset(&line, 0, sizeof(line));
+		line.clueSet = &clueSet;
+		line.size = size;
+
+		status = solveLinePlacements(&line, &mask, &partial) ? SOLVE_IN_PROGRESS : SOLVE_UNSATISFIABLE;
+	}
+
+	if (status != SOLVE_IN_PROGRESS)
+		return status;
+
+	*maskBits = mask;
+	*partialBits = partial;
+
+	return (mask == widthBits(size)) ? SOLVE_SOLVED : SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Starts writing every line the solvers solve (see captureLineSolve()) to stream, from any
+ * thread, until stopLineCapture(). The stream stays the caller's.
+ *
+ * Returns FALSE if a capture is already running.
+ */
+bool startLineCapture (FILE * stream)
+{
+	bool started = FALSE;
+
+	pthread_mutex_lock(&captureLock);
+
+	if (captureStream == NULL)
+	{
+		captureStream = stream;
+		fprintf(stream, "# size clues known filled -> known filled | x\n");
+		atomic_store(&capturing, TRUE);
+		started = TRUE;
+	}
+
+	pthread_mutex_unlock(&captureLock);
+
+	return started;
+}
+
+/*
+ * Ends the running capture, if any, and flushes its stream.
+ */
+void stopLineCapture (void)
+{
+	pthread_mutex_lock(&captureLock);
+
+	atomic_store(&capturing, FALSE);
+
+	if (captureStream != NULL)
+		fflush(captureStream);
+
+	captureStream = NULL;
+
+	pthread_mutex_unlock(&captureLock);
+
+	return;
+}
+
+/*
+ * Records a line solve to the running capture: the line's clues, the known cells it was
+ * solved from and the known cells it was left with (solvedMask/solvedPartial are only read
+ * when feasible). Costs one relaxed load when no capture runs.
+ */
+void captureLineSolve (const Line * line, uint64_t maskBits, uint64_t partialBits, bool feasible,
+	uint64_t solvedMask, uint64_t solvedPartial)
+{
+	int i;
+
+	if (!atomic_load_explicit(&capturing, memory_order_relaxed))
+		return;
+
+	pthread_mutex_lock(&captureLock);
+
+	if (captureStream != NULL)
+	{
+		fprintf(captureStream, "%d ", line->size);
+
+		for (i = 0; i < line->clueSet->clueCount; ++i)
+			fprintf(captureStream, "%s%d", (i > 0) ? "," : "", line->clueSet->clues[i]);
+
+		fprintf(captureStream, "%s %llx %llx", (line->clueSet->clueCount == 0) ? "-" : "", (unsigned long long)maskBits,
+			(unsigned long long)(partialBits & maskBits));
+
+		if (feasible)
+			fprintf(captureStream, " %llx %llx\n", (unsigned long long)solvedMask, (unsigned long long)(solvedPartial & solvedMask));
+		else
+			fprintf(captureStream, " x\n");
+	}
+
+	pthread_mutex_unlock(&captureLock);
+
+	return;
+}
+
+/*
+ * Reads one hex mask at *text, moving past it. Returns FALSE if there is none.
+ */
+static bool readMask (char ** text, uint64_t * mask)
+{
+	char * end = NULL;
+
+	while (**text == ' ')
+		++(*text);
+
+	if (**text == '-' || **text == '\0')
+		return FALSE;
+
+	*mask = strtoull(*text, &end, 16);
+
+	if (end == *text)
+		return FALSE;
+
+	*text = end;
+
+	return TRUE;
+}
+
+/*
+ * Parses one capture line into record. Returns FALSE if it is malformed.
+ */
+static bool parseRecord (char * text, LineRecord * record)
+{
+	char * end = NULL;
+
+	record->size = (int)strtol(text, &end, 10);
+	record->clueCount = 0;
+
+	if (end == text || *end != ' ')
+		return FALSE;
+
+	text = end + 1;
+
+	if (*text == '-')
+		++text;
+
+	else
+		for (;;)
+		{
+			if (record->clueCount == MAX_CLUES)
+				return FALSE;
+
+			record->clues[record->clueCount++] = (int)strtol(text, &end, 10);
+
+			if (end == text)
+				return FALSE;
+
+			text = end;
+
+			if (*text != ',')
+				break;
+
+			++text;
+		}
+
+	if (!readMask(&text, &record->maskBits) || !readMask(&text, &record->partialBits))
+		return FALSE;
+
+	while (*text == ' ')
+		++text;
+
+	record->feasible = (*text != 'x');
+	record->solvedMask = record->solvedPartial = 0ULL;
+
+	if (!record->feasible)
+		++text;
+
+	else if (!readMask(&text, &record->solvedMask) || !readMask(&text, &record->solvedPartial))
+		return FALSE;
+
+	while (*text == ' ' || *text == '\n' || *text == '\r')
+		++text;
+
+	return *text == '\0'
+		&& validLine(record->clues, record->clueCount, record->size, record->maskBits, record->partialBits)
+		&& (!record->feasible || validLine(record->clues, record->clueCount, record->size, record->solvedMask, record->solvedPartial));
+}
+
+/*
+ * Reads a capture (see startLineCapture()) into memory, so a replay times the line solves
+ * alone. Sets count to the number of records.
+ *
+ * Returns the records (the caller frees them), or NULL with the reason in error if a line
+ * is malformed or memory runs out. An empty capture gives an empty allocation.
+ */
+LineRecord * readLineCapture (FILE * stream, int * count, char * error, size_t errorSize)
+{
+	char text[CAPTURE_LINE_LENGTH];
+	int capacity = 1024, lineNumber = 0;
+	LineRecord * records = (LineRecord *)malloc(sizeof(LineRecord) * capacity), * grown = NULL;
+
+	*count = 0;
+
+	if (records == NULL)
+		goto out_of_memory;
+
+	while (fgets(text, sizeof(text), stream) != NULL)
+	{
+		++lineNumber;
+
+		if (text[0] == '#' || text[0] == '\n')
+			continue;
+
+		if (*count == capacity)
+		{
+			capacity *= 2;
+			grown = (LineRecord *)realloc(records, sizeof(LineRecord) * capacity);
+
+			if (grown == NULL)
+				goto out_of_memory;
+
+			records = grown;
+		}
+
+		if (!parseRecord(text, &records[*count]))
+		{
+			if (error != NULL)
+				snprintf(error, errorSize, "Invalid line solve on line %d.", lineNumber);
+
+			free(records);
+			return NULL;
+		}
+
+		++(*count);
+	}
+
+	return records;
+
+out_of_memory:
+	if (error != NULL)
+		snprintf(error, errorSize, "Error allocating memory for the line solves.");
+
+	free(records);
+
+	return NULL;
+}
+
+/*
+ * Solves every record passes times through engine and times it. A record whose answer
+ * differs from the captured one counts as a mismatch, so two engines (or two builds) can
+ * be checked against each other on real lines. Mismatches and contradictions are counted
+ * on the first pass.
+ *
+ * Returns SOLVE_SOLVED, or the first status other than a solve or contradiction
+ * (SOLVE_OUT_OF_MEMORY from the permutation engine).
+ */
+SolveStatus replayLineCapture (const LineRecord * records, int count, LineEngine engine, int passes, LineReplay * replay)
+{
+	int i, pass;
+	uint64_t maskBits, partialBits;
+	long start = monotonicNanos();
+	SolveStatus status;
+
+	memset(replay, 0, sizeof(LineReplay));
+
+	for (pass = 0; pass < passes; ++pass)
+		for (i = 0; i < count; ++i)
+		{
+			maskBits = records[i].maskBits;
+			partialBits = records[i].partialBits;
+
+			status = solveSingleLine(engine, records[i].clues, records[i].clueCount, records[i].size, &maskBits, &partialBits);
+			++replay->solves;
+
+			if (status != SOLVE_SOLVED && status != SOLVE_IN_PROGRESS && status != SOLVE_UNSATISFIABLE)
+				return status;
+
+			if (pass > 0)
+				continue;
+
+			if (status == SOLVE_UNSATISFIABLE)
+				++replay->contradictions;
+
+			if ((status != SOLVE_UNSATISFIABLE) != records[i].feasible
+				|| (records[i].feasible && (maskBits != records[i].solvedMask || partialBits != records[i].solvedPartial)))
+				++replay->mismatches;
+		}
+
+	replay->elapsedNanos = monotonicNanos() - start;
+	replay->linesPerSecond = (replay->elapsedNanos > 0) ? replay->solves * 1e9 / replay->elapsedNanos : 0.0;
+
+	return SOLVE_SOLVED;
+}
+
+/*
+ * Returns the name of a line engine, as --line-engine= takes it.
+ */
+const char * lineEngineName (LineEngine engine)
+{
+	return engineNames[engine];
+}
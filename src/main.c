@@ -1,25 +1,528 @@
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include "../include/colour.h"
+#include "../include/daemon.h"
+#include "../include/estimate.h"
 #include "../include/fileIO.h"
+#include "../include/gameBoard.h"
+#include "../include/lineSolve.h"
+#include "../include/puzzle.h"
 #include "../include/solverAPI.h"
+#include "../include/verify.h"
 
 FILE * getFile (int, char *);
 
 LineClue ** readFile (FILE *, int *, int *);
 
+/* Raised by Ctrl-C, the solve stops and prints what it has solved so far */
+static atomic_bool interrupted = FALSE;
+
+static void interruptSolve (int signalNumber)
+{
+	(void)signalNumber;
+	atomic_store(&interrupted, TRUE);
+
+	return;
+}
+
+/*
+ * Parses an option of the form prefix followed by a non-negative number. Returns FALSE if
+ * arg is not that option or its number is malformed.
+ */
+static bool numberOption (const char * arg, const char * prefix, long * value)
+{
+	char * end = NULL;
+	size_t length = strlen(prefix);
+
+	if (strncmp(arg, prefix, length) != 0 || arg[length] == '\0')
+		return FALSE;
+
+	*value = strtol(arg + length, &end, 10);
+
+	return *end == '\0' && *value >= 0;
+}
+
+typedef struct SolutionPrinter {
+	long printed;
+	long printLimit;
+	int width;
+	BoardFormat format;
+} SolutionPrinter;
+
+/* Board formats by their --format= name, in BoardFormat order */
+static const char * const formatNames[] = { "grid", "rows", "pbm", "binary" };
+
+/*
+ * SolutionCallback for --unique and --count: prints solutions as they are found, up to
+ * the printer's limit (0 prints all), and notes the board width for reporting cells.
+ * Only the grid view gets a heading, the other formats stay machine readable.
+ */
+static void printSolution (const int * gameBoard, int width, int length, void * context)
+{
+	SolutionPrinter * printer = (SolutionPrinter *)context;
+
+	printer->width = width;
+
+	if (printer->printLimit > 0 && printer->printed >= printer->printLimit)
+		return;
+
+	++printer->printed;
+
+	if (printer->format == BOARD_GRID)
+		printf("Solution %ld:\n", printer->printed);
+
+	writeGameBoard(stdout, gameBoard, width, length, printer->format);
+
+	return;
+}
+
+/* Progress report stages by name, in ProgressStage order */
+static const char * const stageNames[] = { "rules", "sweep", "probe", "done" };
+
+/*
+ * ProgressCallback for --progress: writes each report to the stream as one line and
+ * flushes it, so a reader sees it at once:
+ *   stage=sweep iterations=3 solved=412/2500 micros=1234 cells=12#,13.,40#
+ * cells lists the newly solved cells (row major index, then '#' filled or '.' empty). The
+ * final report has stage=done and the solve's status="...".
+ */
+static void writeProgress (const SolveProgress * progress, void * context)
+{
+	int i, cell;
+	FILE * stream = (FILE *)context;
+
+	fprintf(stream, "stage=%s", stageNames[progress->stage]);
+
+	if (progress->stage == PROGRESS_DONE)
+		fprintf(stream, " status=\"%s\"", solveStatusName(progress->status));
+
+	fprintf(stream, " iterations=%d solved=%d/%d micros=%ld cells=", progress->iterations, progress->solvedCells,
+		progress->width * progress->length, progress->elapsedNanos / 1000);
+
+	for (i = 0; i < progress->newCellCount; ++i)
+	{
+		cell = progress->newCells[i];
+		fprintf(stream, "%s%d%c", (i > 0) ? "," : "", cell, (progress->gameBoard[cell] == 1) ? '#' : '.');
+	}
+
+	fputc('\n', stream);
+	fflush(stream);
+
+	return;
+}
+
+/*
+ * Opens the --progress file descriptor for writing, stdout and stderr through their
+ * streams. Returns NULL if fd is not an open descriptor.
+ */
+static FILE * openProgressStream (long fd)
+{
+	if (fd == STDOUT_FILENO)
+		return stdout;
+
+	if (fd == STDERR_FILENO)
+		return stderr;
+
+	/* Beyond an int it cannot be a descriptor, and the cast would alias an open one */
+	if (fd > INT_MAX || fcntl((int)fd, F_GETFD) == -1)
+		return NULL;
+
+	return fdopen((int)fd, "w");
+}
+
+/*
+ * Runs the solver as a daemon on stdin/stdout (socketPath NULL) or on a Unix domain
+ * socket. Ctrl-C cancels the solves in flight and stops it; the handler does not restart
+ * interrupted reads, so a daemon waiting on stdin notices.
+ */
+static int runDaemonMode (const char * socketPath, const SolveOptions * options, SearchEngine engine)
+{
+	int result;
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = interruptSolve;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+
+	/* A client hanging up must not end the daemon */
+	signal(SIGPIPE, SIG_IGN);
+
+	if (socketPath != NULL)
+		result = runSocketDaemon(socketPath, options, engine);
+	else
+		result = runDaemon(STDIN_FILENO, STDOUT_FILENO, options, engine);
+
+	if (result != 0)
+		fprintf(stderr, "Failed to start the daemon%s%s\n", (socketPath != NULL) ? " on " : "", (socketPath != NULL) ? socketPath : "");
+
+	return (result == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+ * Checks a board file (see readGameBoard()) against the puzzle's clues without solving: a
+ * complete board must match every clue, one with unknown cells must leave every line a
+ * placement. Returns the exit status.
+ */
+static int runVerifyMode (FILE * puzzleFile, const char * boardPath)
+{
+	int width = 0, length = 0, i, unknown = 0, line = -1;
+	int * gameBoard = NULL;
+	FILE * boardFile = NULL;
+	LineClue ** lineClues = readFile(puzzleFile, &width, &length);
+
+	if (lineClues == NULL)
+	{
+		fprintf(stderr, "Puzzle %s.\n", solveStatusName(SOLVE_INVALID_INPUT));
+		return EXIT_FAILURE;
+	}
+
+	boardFile = fopen(boardPath, "r");
+	if (boardFile == NULL)
+	{
+		fprintf(stderr, "Failed to open file: %s\n", boardPath);
+		goto cleanup;
+	}
+
+	gameBoard = readGameBoard(boardFile, width, length);
+	fclose(boardFile);
+
+	if (gameBoard == NULL)
+		goto cleanup;
+
+	for (i = 0; i < width * length; ++i)
+		unknown += (gameBoard[i] < 0);
+
+	line = (unknown == 0) ? verifyGameBoard(lineClues, width, length, gameBoard) : checkGameBoard(lineClues, width, length, gameBoard);
+
+	if (line >= 0)
+		printf("%s %d %s its clues\n", (line < length) ? "Row" : "Column", (line < length) ? line + 1 : line - length + 1,
+			(unknown == 0) ? "does not match" : "cannot match");
+
+	else if (unknown == 0)
+		printf("Solution valid\n");
+
+	else
+		printf("Board consistent, %d cells unknown\n", unknown);
+
+cleanup:
+	freeLineClues(lineClues, width + length);
+	free(gameBoard);
+
+	return (gameBoard != NULL && line < 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+ * Prints the dry-run estimate of the puzzle's cost (see estimateClues()) without solving
+ * it. Returns the exit status.
+ */
+static int runEstimateMode (FILE * puzzleFile)
+{
+	int width = 0, length = 0;
+	bool valid;
+	PuzzleEstimate estimate;
+	LineClue ** lineClues = readFile(puzzleFile, &width, &length);
+
+	if (lineClues == NULL)
+	{
+		fprintf(stderr, "Puzzle %s.\n", solveStatusName(SOLVE_INVALID_INPUT));
+		return EXIT_FAILURE;
+	}
+
+	valid = estimateClues(lineClues, width, length, &estimate, NULL);
+	freeLineClues(lineClues, width + length);
+
+	if (!valid)
+	{
+		fprintf(stderr, "Puzzle %s.\n", solveStatusName(SOLVE_UNSATISFIABLE));
+		return EXIT_FAILURE;
+	}
+
+	printf("Open lines: %d of %d\n", estimate.openLines, width + length);
+	printf("Placements: %.4g\n", estimate.totalPlacements);
+
+	if (estimate.largestLine >= 0)
+		printf("Largest line: %s %d, %.4g placements\n", (estimate.largestLine < length) ? "row" : "column",
+			(estimate.largestLine < length) ? estimate.largestLine + 1 : estimate.largestLine - length + 1, estimate.largestPlacements);
+
+	printf("Peak permutation memory: %.1f MB\n", estimate.peakBytes / (1024.0 * 1024.0));
+	printf("Risk: %s\n", riskClassName(estimate.risk));
+
+	return EXIT_SUCCESS;
+}
+
+/*
+ * Replays a line capture (see startLineCapture()) through a line engine passes times and
+ * prints the throughput. Returns the exit status, a failure if any line solved differently
+ * than captured.
+ */
+static int runReplayMode (const char * capturePath, LineEngine engine, long passes)
+{
+	int count = 0;
+	char error[256] = "";
+	LineRecord * records = NULL;
+	LineReplay replay;
+	SolveStatus status;
+	FILE * captureFile = fopen(capturePath, "r");
+
+	if (captureFile == NULL)
+	{
+		fprintf(stderr, "Failed to open file: %s\n", capturePath);
+		return EXIT_FAILURE;
+	}
+
+	records = readLineCapture(captureFile, &count, error, sizeof(error));
+	fclose(captureFile);
+
+	if (records == NULL)
+	{
+		fprintf(stderr, "%s\n", error);
+		return EXIT_FAILURE;
+	}
+
+	status = replayLineCapture(records, count, engine, (int)passes, &replay);
+	free(records);
+
+	if (status != SOLVE_SOLVED)
+	{
+		fprintf(stderr, "Replay %s.\n", solveStatusName(status));
+		return EXIT_FAILURE;
+	}
+
+	printf("Engine: %s\n", lineEngineName(engine));
+	printf("Lines: %d (%ld contradictions), %ld passes\n", count, replay.contradictions, passes);
+	printf("Mismatches: %ld\n", replay.mismatches);
+	printFormattedTime(replay.elapsedNanos);
+	printf("Lines per second: %.4g\n", replay.linesPerSecond);
+
+	return (replay.mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main (int argc, char ** argv)
 {
 	struct timespec endTime, startTime;
 	clock_gettime(CLOCK_MONOTONIC, &startTime);
-	int iterations = 0;
-	FILE * fPtr = NULL;
+	int iterations = 0, argIndex = 1, firstDifference = -1, verifyStatus, i, length = 0, colours = 0;
+	long countLimit = -1, solutionCount = 0, megabytes = 0, progressFd = -1, progressCells = 0, passes = 1;
+	SolutionPrinter printer = { 0, 0, 1, BOARD_GRID };
+	SolveOptions options = { 0, 0, &interrupted, NULL, NULL, 0, 0 };
+	SearchEngine engine = SEARCH_CDCL;
+	bool daemon = FALSE, estimate = FALSE;
+	LineEngine lineEngine = LINE_ENGINE_PLACEMENTS;
+	const char * socketPath = NULL, * boardPath = NULL, * capturePath = NULL, * replayPath = NULL;
+	FILE * fPtr = NULL, * report = stdout, * progressStream = NULL, * captureFile = NULL;
 	int * gameBoard = NULL;
+	SolveStatus status;
+
+	/* Options come before the filename */
+	for ( ; argIndex < argc && strncmp(argv[argIndex], "--", 2) == 0; ++argIndex)
+	{
+		if (strcmp(argv[argIndex], "--parallel-search") == 0)
+		{
+			engine = SEARCH_PARALLEL;
+			setSearchEngine(SEARCH_PARALLEL);
+		}
+
+		/* Puzzles as request lines on stdin, answers on stdout */
+		else if (strcmp(argv[argIndex], "--daemon") == 0)
+			daemon = TRUE;
+
+		else if (strncmp(argv[argIndex], "--socket=", 9) == 0 && argv[argIndex][9] != '\0')
+		{
+			daemon = TRUE;
+			socketPath = argv[argIndex] + 9;
+		}
+
+		/* Predict the solve's cost instead of solving */
+		else if (strcmp(argv[argIndex], "--estimate") == 0)
+			estimate = TRUE;
+
+		/* Check a board against the clues instead of solving */
+		else if (strncmp(argv[argIndex], "--verify=", 9) == 0 && argv[argIndex][9] != '\0')
+			boardPath = argv[argIndex] + 9;
+
+		/* Two solutions are enough to tell a unique puzzle apart, only the first is shown */
+		else if (strcmp(argv[argIndex], "--unique") == 0)
+		{
+			countLimit = 2;
+			printer.printLimit = 1;
+		}
+
+		else if (numberOption(argv[argIndex], "--count=", &countLimit))
+			printer.printLimit = 0;
+
+		else if (numberOption(argv[argIndex], "--time-limit=", &options.timeLimitMillis))
+			continue;
+
+		else if (strncmp(argv[argIndex], "--format=", 9) == 0)
+		{
+			for (i = 0; i <= BOARD_BINARY && strcmp(argv[argIndex] + 9, formatNames[i]) != 0; ++i);
+
+			if (i > BOARD_BINARY)
+			{
+				fprintf(stderr, "Unknown format: %s (grid, rows, pbm or binary)\n", argv[argIndex] + 9);
+				return EXIT_FAILURE;
+			}
+
+			printer.format = (BoardFormat)i;
+		}
+
+		/* Solve without rendering the board */
+		else if (strcmp(argv[argIndex], "--quiet") == 0)
+			printer.format = BOARD_QUIET;
+
+		/* Megabytes of stored permutations */
+		else if (numberOption(argv[argIndex], "--memory-limit=", &megabytes))
+			options.permutationBytes = (size_t)megabytes << 20;
+
+		/* Megabytes of spill file per line too big for memory */
+		else if (numberOption(argv[argIndex], "--spill-limit=", &megabytes))
+			options.spillBytes = (size_t)megabytes << 20;
+
+		/* Stream progress reports to a file descriptor, at most one per N new cells */
+		else if (numberOption(argv[argIndex], "--progress=", &progressFd))
+			continue;
+
+		else if (numberOption(argv[argIndex], "--progress-cells=", &progressCells))
+			options.progressCells = (progressCells > 1 << 20) ? 1 << 20 : (int)progressCells;
 
-	fPtr = getFile(argc, argv[1]);
+		/* Record every line solved to a file, or time a recording's lines instead of solving */
+		else if (strncmp(argv[argIndex], "--capture-lines=", 16) == 0 && argv[argIndex][16] != '\0')
+			capturePath = argv[argIndex] + 16;
 
-	gameBoard = solvePuzzle(fPtr, 0, &iterations);
+		else if (strncmp(argv[argIndex], "--replay-lines=", 15) == 0 && argv[argIndex][15] != '\0')
+			replayPath = argv[argIndex] + 15;
+
+		else if (numberOption(argv[argIndex], "--repeat=", &passes))
+			passes = (passes < 1) ? 1 : (passes > 1 << 20) ? 1 << 20 : passes;
+
+		else if (strncmp(argv[argIndex], "--line-engine=", 14) == 0)
+		{
+			for (i = 0; i <= LINE_ENGINE_PERMUTATIONS && strcmp(argv[argIndex] + 14, lineEngineName((LineEngine)i)) != 0; ++i);
+
+			if (i > LINE_ENGINE_PERMUTATIONS)
+			{
+				fprintf(stderr, "Unknown line engine: %s (placements or permutations)\n", argv[argIndex] + 14);
+				return EXIT_FAILURE;
+			}
+
+			lineEngine = (LineEngine)i;
+		}
+
+		else
+		{
+			fprintf(stderr, "Unknown option: %s\n", argv[argIndex]);
+			fprintf(stderr, "Usage: %s [--parallel-search] [--unique | --count=N] [--time-limit=MS] [--memory-limit=MB] [--spill-limit=MB] [--format=grid|rows|pbm|binary | --quiet] [--daemon | --socket=PATH] [--verify=BOARD | --estimate] [--progress=FD [--progress-cells=N]] [--capture-lines=FILE | --replay-lines=FILE [--line-engine=placements|permutations] [--repeat=N]] [puzzle file]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (daemon)
+		return runDaemonMode(socketPath, &options, engine);
+
+	if (replayPath != NULL)
+		return runReplayMode(replayPath, lineEngine, passes);
+
+	if (progressFd >= 0)
+	{
+		progressStream = openProgressStream(progressFd);
+
+		if (progressStream == NULL)
+		{
+			fprintf(stderr, "--progress: file descriptor %ld is not open\n", progressFd);
+			return EXIT_FAILURE;
+		}
+
+		options.progress = writeProgress;
+		options.progressContext = progressStream;
+	}
+
+	/* Keep stdout to the boards alone when they are meant for another program */
+	if (printer.format != BOARD_GRID && printer.format != BOARD_QUIET)
+		report = stderr;
+
+	setBoardFormat(printer.format);
+
+	fPtr = getFile((argIndex < argc) ? 2 : 1, argv[argIndex]);
+
+	if (boardPath != NULL || estimate)
+	{
+		verifyStatus = (boardPath != NULL) ? runVerifyMode(fPtr, boardPath) : runEstimateMode(fPtr);
+		fclose(fPtr);
+
+		return verifyStatus;
+	}
+
+	if (capturePath != NULL)
+	{
+		captureFile = fopen(capturePath, "w");
+
+		if (captureFile == NULL)
+		{
+			fprintf(stderr, "Failed to open file: %s\n", capturePath);
+			fclose(fPtr);
+			return EXIT_FAILURE;
+		}
+
+		startLineCapture(captureFile);
+	}
+
+	signal(SIGINT, interruptSolve);
+
+	/* Colour puzzles have their own solver and board */
+	if (isColourFile(fPtr))
+	{
+		if (countLimit >= 0)
+		{
+			fprintf(stderr, "--unique and --count do not support colour puzzles.\n");
+			fclose(fPtr);
+			return EXIT_FAILURE;
+		}
+
+		if (printer.format == BOARD_PBM || printer.format == BOARD_BINARY)
+		{
+			fprintf(stderr, "--format=%s does not support colour puzzles (grid or rows).\n", formatNames[printer.format]);
+			fclose(fPtr);
+			return EXIT_FAILURE;
+		}
+
+		gameBoard = solveColourFile(fPtr, &printer.width, &length, &colours, &iterations, &status, &options);
+
+		if (gameBoard != NULL && status == SOLVE_SOLVED)
+			writeColourBoard(stdout, gameBoard, printer.width, length, printer.format);
+	}
+
+	else if (countLimit >= 0)
+	{
+		status = countSolutions(fPtr, countLimit, printSolution, &printer, &solutionCount, &firstDifference, &options);
+
+		if (printer.printLimit == 1 && solutionCount == 1)
+			fprintf(report, "Unique solution\n");
+
+		else if (printer.printLimit == 1 && solutionCount > 1)
+			fprintf(report, "Multiple solutions, first difference at row %d, column %d\n", firstDifference / printer.width + 1, firstDifference % printer.width + 1);
+
+		else if (status == SOLVE_SOLVED)
+			fprintf(report, "Solutions: %ld\n", solutionCount);
+
+		/* A uniqueness check only succeeds on exactly one solution */
+		if (status == SOLVE_SOLVED && printer.printLimit == 1 && solutionCount != 1)
+			status = SOLVE_INCOMPLETE;
+	}
+
+	else
+		gameBoard = solvePuzzleWithOptions(fPtr, 0, &iterations, &status, &options);
+
+	if (status != SOLVE_SOLVED && !(countLimit >= 0 && solutionCount > 1))
+		fprintf(stderr, "Puzzle %s.\n", solveStatusName(status));
 
 	free(gameBoard);
 	gameBoard = NULL;
@@ -27,12 +530,25 @@ int main (int argc, char ** argv)
 	fclose(fPtr);
 	fPtr = NULL;
 
+	if (progressStream != NULL && progressStream != stdout && progressStream != stderr)
+		fclose(progressStream);
+
+	if (captureFile != NULL)
+	{
+		stopLineCapture();
+		fclose(captureFile);
+	}
+
 	clock_gettime(CLOCK_MONOTONIC, &endTime);
 
 	long nanos = (endTime.tv_sec - startTime.tv_sec) * 1000000000L + (endTime.tv_nsec - startTime.tv_nsec);
 
-	printFormattedTime(nanos);
-	printf("Iterations: %d\n", iterations);
+	/* Machine readable formats leave the summary out of their output */
+	if (report == stdout)
+	{
+		printFormattedTime(nanos);
+		printf("Iterations: %d\n", iterations);
+	}
 
-	return EXIT_SUCCESS;
+	return (status == SOLVE_SOLVED) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
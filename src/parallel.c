@@ -0,0 +1,280 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../include/parallel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MAX_WORKERS 64
+
+/* 0 means not yet resolved, getWorkerCount() fills it in from the online core count */
+static atomic_int workerCount = 0;
+
+/*
+ * A runParallel() call in progress, or a job queued with queueParallel(). Pool threads
+ * join it (up to helpers of them) while it is listed in the pool, helping counts those
+ * still running its tasks.
+ */
+struct ParallelJob {
+	ParallelTask task;
+	void * context;
+	int taskCount;
+	atomic_int nextTask;
+	int helpers;
+	int joined;
+	int helping;
+	struct ParallelJob * next;
+};
+
+/*
+ * The threads behind runParallel(), started the first time they are needed and kept for
+ * the life of the process. Idle threads wait on wake for a job to be listed, callers wait
+ * on finished for the threads helping them to return.
+ */
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t finished;
+	ParallelJob * jobs;
+	int threadCount;
+} pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0 };
+
+/*
+ * Returns the number of threads runParallel() may use, defaulting to the number of
+ * online cores the first time it is asked.
+ */
+int getWorkerCount (void)
+{
+	long cores;
+	int count = atomic_load(&workerCount);
+
+	if (count > 0) return count;
+
+	cores = sysconf(_SC_NPROCESSORS_ONLN);
+	count = (cores < 1) ? 1 : (cores > MAX_WORKERS) ? MAX_WORKERS : (int)cores;
+	atomic_store(&workerCount, count);
+
+	return count;
+}
+
+/*
+ * Overrides the number of threads runParallel() may use. A count below 1 restores
+ * the default of one thread per online core.
+ */
+void setWorkerCount (int count)
+{
+	if (count > MAX_WORKERS) count = MAX_WORKERS;
+
+	atomic_store(&workerCount, (count < 1) ? 0 : count);
+
+	return;
+}
+
+/*
+ * Keeps claiming the next unclaimed task index of the job until all are taken.
+ * Dynamic claiming balances tasks of uneven cost.
+ */
+static void runTasks (ParallelJob * job)
+{
+	int taskIndex;
+
+	while ((taskIndex = atomic_fetch_add(&job->nextTask, 1)) < job->taskCount)
+		job->task(job->context, taskIndex);
+
+	return;
+}
+
+/*
+ * Returns the first listed job that wants another helper and still has unclaimed tasks,
+ * or NULL. The pool lock must be held.
+ */
+static ParallelJob * findJob (void)
+{
+	ParallelJob * job;
+
+	for (job = pool.jobs; job != NULL; job = job->next)
+		if (job->joined < job->helpers && atomic_load(&job->nextTask) < job->taskCount)
+			return job;
+
+	return NULL;
+}
+
+/*
+ * Pool thread body: sleeps until a job wants help, runs its tasks alongside the caller,
+ * then tells the caller it is done with the job.
+ */
+static void * poolThread (void * arg)
+{
+	ParallelJob * job;
+
+	(void)arg;
+
+	pthread_mutex_lock(&pool.lock);
+
+	for (;;)
+	{
+		while ((job = findJob()) == NULL)
+			pthread_cond_wait(&pool.wake, &pool.lock);
+
+		++job->joined;
+		++job->helping;
+		pthread_mutex_unlock(&pool.lock);
+
+		runTasks(job);
+
+		pthread_mutex_lock(&pool.lock);
+		if (--job->helping == 0)
+			pthread_cond_broadcast(&pool.finished);
+	}
+
+	return NULL;
+}
+
+/*
+ * Runs task(context, i) for every i in [0, taskCount) across up to getWorkerCount()
+ * threads and returns once all have completed. The calling thread takes part, so with
+ * a single worker (or if no pool thread can be started) every task runs inline.
+ *
+ * The other threads come from a pool started on first use and reused by every later call.
+ * Calls may be made concurrently and from inside a task: each caller works through its
+ * own tasks, so it never waits on a pool thread that is busy elsewhere.
+ *
+ * Tasks must only write to disjoint memory.
+ */
+void runParallel (ParallelTask task, void * context, int taskCount)
+{
+	pthread_t thread;
+	ParallelJob job, ** link;
+	int threadCount = getWorkerCount();
+
+	if (threadCount > taskCount)
+		threadCount = taskCount;
+
+	job.task = task;
+	job.context = context;
+	job.taskCount = taskCount;
+	atomic_init(&job.nextTask, 0);
+	job.helpers = threadCount - 1;
+	job.joined = 0;
+	job.helping = 0;
+
+	if (job.helpers < 1)
+	{
+		runTasks(&job);
+		return;
+	}
+
+	pthread_mutex_lock(&pool.lock);
+
+	while (pool.threadCount < job.helpers && pthread_create(&thread, NULL, poolThread, NULL) == 0)
+	{
+		pthread_detach(thread);
+		++pool.threadCount;
+	}
+
+	job.next = pool.jobs;
+	pool.jobs = &job;
+	pthread_cond_broadcast(&pool.wake);
+	pthread_mutex_unlock(&pool.lock);
+
+	runTasks(&job);
+
+	/* Every task is claimed now: unlist the job, then wait out the helpers still running */
+	pthread_mutex_lock(&pool.lock);
+
+	for (link = &pool.jobs; *link != &job; link = &(*link)->next);
+	*link = job.next;
+
+	while (job.helping > 0)
+		pthread_cond_wait(&pool.finished, &pool.lock);
+
+	pthread_mutex_unlock(&pool.lock);
+
+	return;
+}
+
+/*
+ * Queues task(context, i) for every i in [0, taskCount) on the pool and returns at once:
+ * up to helpers pool threads (no more than getWorkerCount() - 1) run the tasks while the
+ * caller carries on, which makes the pool serve background work without threads of its
+ * own. finishParallel() ends the job.
+ *
+ * Returns NULL, with no task run, if the job cannot be allocated or no pool thread can be
+ * started for it.
+ */
+ParallelJob * queueParallel (ParallelTask task, void * context, int taskCount, int helpers)
+{
+	pthread_t thread;
+	ParallelJob * job;
+
+	if (helpers > getWorkerCount() - 1)
+		helpers = getWorkerCount() - 1;
+
+	if (helpers > taskCount)
+		helpers = taskCount;
+
+	if (helpers < 1)
+		return NULL;
+
+	job = (ParallelJob *)malloc(sizeof(ParallelJob));
+	if (job == NULL)
+		return NULL;
+
+	job->task = task;
+	job->context = context;
+	job->taskCount = taskCount;
+	atomic_init(&job->nextTask, 0);
+	job->helpers = helpers;
+	job->joined = 0;
+	job->helping = 0;
+
+	pthread_mutex_lock(&pool.lock);
+
+	while (pool.threadCount < helpers && pthread_create(&thread, NULL, poolThread, NULL) == 0)
+	{
+		pthread_detach(thread);
+		++pool.threadCount;
+	}
+
+	if (pool.threadCount == 0)
+	{
+		pthread_mutex_unlock(&pool.lock);
+		free(job);
+		return NULL;
+	}
+
+	job->next = pool.jobs;
+	pool.jobs = job;
+	pthread_cond_broadcast(&pool.wake);
+	pthread_mutex_unlock(&pool.lock);
+
+	return job;
+}
+
+/*
+ * Ends a job queued with queueParallel(): tasks not yet claimed are dropped, the tasks
+ * running are waited for (it is up to them to return promptly), then the job is freed.
+ * Safe to call with NULL.
+ */
+void finishParallel (ParallelJob * job)
+{
+	ParallelJob ** link;
+
+	if (job == NULL) return;
+
+	pthread_mutex_lock(&pool.lock);
+
+	atomic_store(&job->nextTask, job->taskCount);
+
+	for (link = &pool.jobs; *link != job; link = &(*link)->next);
+	*link = job->next;
+
+	while (job->helping > 0)
+		pthread_cond_wait(&pool.finished, &pool.lock);
+
+	pthread_mutex_unlock(&pool.lock);
+
+	free(job);
+
+	return;
+}
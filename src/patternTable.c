@@ -0,0 +1,178 @@
+#include "../include/patternTable.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/*
+ * Lines of up to PATTERN_TABLE_MAX_SIZE cells take their placements from a table of
+ * pattern slices indexed by clue signature (the line size and its packed clues). A
+ * signature's slice holds every placement of its clues, generated the first time any
+ * line asks for it and then kept, shared by every line and puzzle, for the life of the
+ * process: puzzles repeat the same short clue sequences on many lines, and a daemon sees
+ * them again on every puzzle.
+ *
+ * Slots only ever go from empty to holding a slice, so lookups read the table without
+ * the lock; only generating a missing slice takes it.
+ */
+
+/* Bits per clue in a packed clue sequence, enough for clues up to 31 */
+#define CLUE_BITS 5
+
+/* Slots per size: clue sequences fitting 20 cells number Fibonacci(22) = 17711 */
+#define PATTERN_TABLE_SLOTS (1 << 15)
+
+typedef struct PatternSlice {
+	uint64_t key;
+	int count;
+	uint64_t patterns[];
+} PatternSlice;
+
+static _Atomic(PatternSlice *) slices[PATTERN_TABLE_MAX_SIZE + 1][PATTERN_TABLE_SLOTS];
+static pthread_mutex_t buildLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Packs a clue sequence, first clue lowest, into a key.
+ */
+static uint64_t packClues (const int * clues, int clueCount)
+{
+	int i;
+	uint64_t key = 0;
+
+	for (i = 0; i < clueCount; ++i)
+		key |= (uint64_t)clues[i] << (i * CLUE_BITS);
+
+	return key;
+}
+
+/*
+ * Finds the slot of a key among a size's slots: the slot holding it or the first empty
+ * one of its probe chain. Returns the slot with its slice (NULL when empty) in *slice.
+ */
+static int findSlot (int size, uint64_t key, PatternSlice ** slice)
+{
+	int slot = (int)((key * 0x9E3779B97F4A7C15ULL) >> 49) & (PATTERN_TABLE_SLOTS - 1);
+
+	for (;;)
+	{
+		*slice = atomic_load_explicit(&slices[size][slot], memory_order_acquire);
+
+		if (*slice == NULL || (*slice)->key == key)
+			return slot;
+
+		slot = (slot + 1) & (PATTERN_TABLE_SLOTS - 1);
+	}
+}
+
+/*
+ * Places clues[clueIndex] and the clues after it at or past position, the earlier clues
+ * having made current, like generatePermutations() without a mask. remaining[i] is the
+ * cells clues[i] on need. With count set, only counts; otherwise appends to patterns.
+ */
+static void placeClues (const int * clues, const int * remaining, int clueCount, int clueIndex, int size,
+	uint64_t current, int position, bool count, uint64_t * patterns, int * total)
+{
+	int start;
+
+	if (clueIndex == clueCount)
+	{
+		if (!count)
+			patterns[*total] = current;
+
+		++*total;
+		return;
+	}
+
+	for (start = position; start <= size - remaining[clueIndex]; ++start)
+		placeClues(clues, remaining, clueCount, clueIndex + 1, size,
+			current | (((1ULL << clues[clueIndex]) - 1ULL) << start), start + clues[clueIndex] + 1,
+			count, patterns, total);
+
+	return;
+}
+
+/*
+ * Generates the slice of every placement of the clues on a size cell line. Returns NULL
+ * if memory runs out.
+ */
+static PatternSlice * buildSlice (const int * clues, int clueCount, int size, uint64_t key)
+{
+	int i, total = 0;
+	int remaining[PATTERN_TABLE_MAX_SIZE + 1];
+	PatternSlice * slice = NULL;
+
+	remaining[clueCount] = 0;
+	for (i = clueCount - 1; i >= 0; --i)
+		remaining[i] = remaining[i + 1] + clues[i] + ((i < clueCount - 1) ? 1 : 0);
+
+	placeClues(clues, remaining, clueCount, 0, size, 0ULL, 0, TRUE, NULL, &total);
+
+	slice = (PatternSlice *)malloc(sizeof(PatternSlice) + sizeof(uint64_t) * total);
+	if (slice == NULL)
+		return NULL;
+
+	slice->key = key;
+	slice->count = 0;
+	placeClues(clues, remaining, clueCount, 0, size, 0ULL, 0, FALSE, slice->patterns, &slice->count);
+
+	return slice;
+}
+
+/*
+ * Looks up every placement of a clue sequence on a line of size cells.
+ *
+ * Parameters:
+ * - clues, clueCount: the line's clues (none for an empty line)
+ * - size: the line length
+ * - patterns: set to the shared placements, owned by the table and never freed
+ * - count: set to the number of placements
+ *
+ * Returns TRUE on a hit. Returns FALSE for lines longer than PATTERN_TABLE_MAX_SIZE, clues
+ * that cannot fit the line, or if memory runs out, leaving the caller to generate.
+ */
+bool lookupPatterns (const int * clues, int clueCount, int size, const uint64_t ** patterns, int * count)
+{
+	int i, slot, required = clueCount - 1;
+	uint64_t key;
+	PatternSlice * slice = NULL;
+
+	if (size < 1 || size > PATTERN_TABLE_MAX_SIZE || clueCount < 0)
+		return FALSE;
+
+	for (i = 0; i < clueCount; ++i)
+	{
+		if (clues[i] < 1 || clues[i] > size)
+			return FALSE;
+
+		required += clues[i];
+	}
+
+	if (required > size)
+		return FALSE;
+
+	key = packClues(clues, clueCount);
+	slot = findSlot(size, key, &slice);
+
+	if (slice == NULL)
+	{
+		pthread_mutex_lock(&buildLock);
+
+		/* Another thread may have tabled it, or taken this slot for another key */
+		slot = findSlot(size, key, &slice);
+		if (slice == NULL)
+		{
+			slice = buildSlice(clues, clueCount, size, key);
+			if (slice != NULL)
+				atomic_store_explicit(&slices[size][slot], slice, memory_order_release);
+		}
+
+		pthread_mutex_unlock(&buildLock);
+
+		if (slice == NULL)
+			return FALSE;
+	}
+
+	*patterns = slice->patterns;
+	*count = slice->count;
+
+	return TRUE;
+}
@@ -0,0 +1,178 @@
+#include "../include/probe.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct ProbeCandidate {
+	int cell;
+	int score;
+} ProbeCandidate;
+
+/*
+ * qsort comparator: lower scores (more constrained lines) first, ties by cell index
+ * so the order is deterministic.
+ */
+static int compareCandidates (const void * a, const void * b)
+{
+	const ProbeCandidate * left = (const ProbeCandidate *)a;
+	const ProbeCandidate * right = (const ProbeCandidate *)b;
+
+	if (left->score != right->score)
+		return (left->score < right->score) ? -1 : 1;
+
+	return left->cell - right->cell;
+}
+
+/*
+ * Live permutations left on a line, 0 for lines that were solved without enumeration.
+ */
+static int liveCountOf (Line * line)
+{
+	return (line->bitSet == NULL) ? 0 : line->liveCount;
+}
+
+/*
+ * Assumes a value for one cell on a copy of the gameboard and propagates it.
+ *
+ * Returns FALSE if the assumption leads to a contradiction, otherwise board holds every
+ * cell implied by it.
+ */
+static bool probeValue (Puzzle * puzzle, int cell, int value, int * board, int * pending)
+{
+	memcpy(board, puzzle->gameBoard, sizeof(int) * puzzle->width * puzzle->length);
+	board[cell] = value;
+
+	pending[cell / puzzle->width] = 1;
+	pending[puzzle->length + (cell % puzzle->width)] = 1;
+
+	return propagateBoard(puzzle, board, pending);
+}
+
+/*
+ * Breaks a line logic stall by probing unsolved cells.
+ *
+ * Candidates are ordered by the live permutation counts of their row and column, so
+ * cells on the most constrained lines (which tend to propagate furthest) go first. For
+ * each candidate the cell is assumed filled and then empty, each assumption propagated
+ * with propagateBoard(), and:
+ * - If both assumptions contradict, the puzzle has no solution
+ * - If one contradicts, every cell implied by the other is adopted
+ * - Otherwise the cells both assumptions agree on are adopted
+ *
+ * A probe that yields nothing is remembered in puzzle->probeStamps together with the
+ * number of solved cells at the time, so the cell is skipped until the gameboard gains
+ * new information.
+ *
+ * Stops at the first probe that solves cells so line propagation can resume with them.
+ *
+ * Return:
+ * - SOLVE_IN_PROGRESS when cells were solved (their lines are flagged dirty).
+ * - SOLVE_INCOMPLETE when no probe yields anything.
+ * - SOLVE_UNSATISFIABLE when a cell can be neither filled nor empty.
+ * - SOLVE_OUT_OF_MEMORY when the probing buffers cannot be allocated.
+ * - SOLVE_TIMED_OUT or SOLVE_CANCELLED when the puzzle's limits stop it.
+ */
+SolveStatus probePuzzle (Puzzle * puzzle)
+{
+	int i, cell, solvedCount = 0, candidateCount = 0;
+	const int cellCount = puzzle->width * puzzle->length;
+	const int lineCount = puzzle->width + puzzle->length;
+	bool filledOk, emptyOk;
+	int * filledBoard = NULL, * emptyBoard = NULL, * pending = NULL;
+	ProbeCandidate * candidates = NULL;
+	SolveStatus status = SOLVE_INCOMPLETE, limit;
+
+	if (puzzle->probeStamps == NULL)
+	{
+		puzzle->probeStamps = (int *)malloc(sizeof(int) * cellCount);
+		if (puzzle->probeStamps == NULL)
+			return SOLVE_OUT_OF_MEMORY;
+
+		memset(puzzle->probeStamps, 0xFF, sizeof(int) * cellCount);
+	}
+
+	filledBoard = (int *)malloc(sizeof(int) * cellCount);
+	emptyBoard = (int *)malloc(sizeof(int) * cellCount);
+	pending = (int *)calloc(lineCount, sizeof(int));
+	candidates = (ProbeCandidate *)malloc(sizeof(ProbeCandidate) * cellCount);
+
+	if (filledBoard == NULL || emptyBoard == NULL || pending == NULL || candidates == NULL)
+	{
+		status = SOLVE_OUT_OF_MEMORY;
+		goto probe_Free;
+	}
+
+	for (i = 0; i < cellCount; ++i)
+	{
+		if (puzzle->gameBoard[i] != -1)
+		{
+			++solvedCount;
+			continue;
+		}
+
+		candidates[candidateCount].cell = i;
+		candidates[candidateCount].score = liveCountOf(puzzle->lines[i / puzzle->width])
+			+ liveCountOf(puzzle->lines[puzzle->length + (i % puzzle->width)]);
+		++candidateCount;
+	}
+
+	qsort(candidates, candidateCount, sizeof(ProbeCandidate), compareCandidates);
+
+	for (i = 0; i < candidateCount && status == SOLVE_INCOMPLETE; ++i)
+	{
+		cell = candidates[i].cell;
+
+		/* Already probed without result and nothing has been solved since */
+		if (puzzle->probeStamps[cell] == solvedCount)
+			continue;
+
+		limit = checkLimits(puzzle);
+		if (limit != SOLVE_IN_PROGRESS)
+		{
+			status = limit;
+			break;
+		}
+
+		filledOk = probeValue(puzzle, cell, 1, filledBoard, pending);
+		emptyOk = probeValue(puzzle, cell, 0, emptyBoard, pending);
+
+		if (!filledOk && !emptyOk)
+			status = SOLVE_UNSATISFIABLE;
+
+		else if (!filledOk)
+			status = (adoptBoard(puzzle, emptyBoard) > 0) ? SOLVE_IN_PROGRESS : SOLVE_INCOMPLETE;
+
+		else if (!emptyOk)
+			status = (adoptBoard(puzzle, filledBoard) > 0) ? SOLVE_IN_PROGRESS : SOLVE_INCOMPLETE;
+
+		else
+		{
+			/* Keep only what both branches agree on */
+			for (cell = 0; cell < cellCount; ++cell)
+				if (filledBoard[cell] != emptyBoard[cell])
+					filledBoard[cell] = -1;
+
+			if (adoptBoard(puzzle, filledBoard) > 0)
+				status = SOLVE_IN_PROGRESS;
+			else
+				puzzle->probeStamps[candidates[i].cell] = solvedCount;
+		}
+	}
+
+	if (status == SOLVE_IN_PROGRESS)
+		reportProgress(puzzle, PROGRESS_PROBE, SOLVE_IN_PROGRESS);
+
+probe_Free:
+	free(filledBoard);
+	filledBoard = NULL;
+
+	free(emptyBoard);
+	emptyBoard = NULL;
+
+	free(pending);
+	pending = NULL;
+
+	free(candidates);
+	candidates = NULL;
+
+	return status;
+}
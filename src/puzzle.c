@@ -0,0 +1,924 @@
+#define _POSIX_C_SOURCE 199309L
+#include "../include/puzzle.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/gameBoard.h"
+#include "../include/lineSolve.h"
+#include "../include/solver.h"
+#include "../include/spill.h"
+
+/* Line cache slots per line of the puzzle, the cache holds at most LINE_CACHE_MAX_SLOTS */
+#define LINE_CACHE_SLOTS_PER_LINE 512
+#define LINE_CACHE_MAX_SLOTS 65536
+
+/*
+ * Cheap pre-solve validation of a puzzle's clues.
+ *
+ * Checks that:
+ * - Every row's clues fit in width cells and every column's clues fit in length cells
+ * - The filled cells demanded by the rows equal those demanded by the columns
+ *
+ * Returns TRUE if the clues pass both checks. A FALSE return means the puzzle has no
+ * solution and can be rejected without allocating any solver state.
+ */
+bool validateClues (LineClue ** lineClues, int width, int length)
+{
+	int i, j, size, required;
+	long rowTotal = 0, columnTotal = 0;
+
+	for (i = 0; i < width + length; ++i)
+	{
+		size = (i < length) ? width : length;
+		required = (lineClues[i]->clueCount > 0) ? lineClues[i]->clueCount - 1 : 0;
+
+		for (j = 0; j < lineClues[i]->clueCount; ++j)
+		{
+			required += lineClues[i]->clues[j];
+
+			if (i < length)
+				rowTotal += lineClues[i]->clues[j];
+			else
+				columnTotal += lineClues[i]->clues[j];
+		}
+
+		if (required > size)
+			return FALSE;
+	}
+
+	return rowTotal == columnTotal;
+}
+
+/*
+ * Returns TRUE if two lines have the same size and clues, and so the same solve for any
+ * known cells.
+ */
+static bool sameClues (Line * a, Line * b)
+{
+	int i;
+
+	if (a->size != b->size || a->clueSet->clueCount != b->clueSet->clueCount)
+		return FALSE;
+
+	for (i = 0; i < a->clueSet->clueCount; ++i)
+		if (a->clueSet->clues[i] != b->clueSet->clues[i])
+			return FALSE;
+
+	return TRUE;
+}
+
+/*
+ * Allocates the solver state for a puzzle: the gameboard, one Line per row and column
+ * (rows first, then columns), the dirty flags that drive the sweeps and the line solve
+ * cache. Lines with the same size and clues share a cache key (the first such line's
+ * index), so they reuse each other's solves.
+ *
+ * The Puzzle takes ownership of lineClues on success, freePuzzle() releases them.
+ * On failure everything allocated here is released, lineClues stay with the caller,
+ * and NULL is returned.
+ */
+Puzzle * createPuzzle (LineClue ** lineClues, int width, int length)
+{
+	return createPuzzleWithCache(lineClues, width, length, NULL);
+}
+
+/*
+ * createPuzzle() solving lines through a line cache shared with other puzzles, for
+ * callers that solve many (see lineCacheKey()). The cache stays the caller's and must
+ * outlive the puzzle; with a NULL cache the puzzle gets its own, as createPuzzle().
+ */
+Puzzle * createPuzzleWithCache (LineClue ** lineClues, int width, int length, LineCache * sharedCache)
+{
+	int i, j;
+	Puzzle * puzzle = (Puzzle *)calloc(1, sizeof(Puzzle));
+	const int lineCount = width + length;
+
+	if (puzzle == NULL) return NULL;
+
+	puzzle->width = width;
+	puzzle->length = length;
+
+	puzzle->rowsToUpdate = (int *)calloc(length, sizeof(int));
+	puzzle->columnsToUpdate = (int *)calloc(width, sizeof(int));
+	puzzle->columnPartialSolution = (int *)calloc(length, sizeof(int));
+	puzzle->lines = (Line **)calloc(width + length, sizeof(Line *));
+	puzzle->gameBoard = createGameBoard(width, length);
+	puzzle->lineKeys = (int *)malloc(sizeof(int) * lineCount);
+	puzzle->sharedLineCache = (sharedCache != NULL);
+	puzzle->lineCache = (sharedCache != NULL) ? sharedCache : createLineCache((lineCount * LINE_CACHE_SLOTS_PER_LINE < LINE_CACHE_MAX_SLOTS)
+		? lineCount * LINE_CACHE_SLOTS_PER_LINE : LINE_CACHE_MAX_SLOTS);
+
+	if (puzzle->rowsToUpdate == NULL || puzzle->columnsToUpdate == NULL || puzzle->columnPartialSolution == NULL
+		|| puzzle->lines == NULL || puzzle->gameBoard == NULL || puzzle->lineKeys == NULL || puzzle->lineCache == NULL)
+		goto create_Fail;
+
+	for (i = 0; i < lineCount; ++i)
+	{
+		puzzle->lines[i] = createLine(lineClues[i], (i < length) ? width : length, i);
+
+		if (puzzle->lines[i] == NULL)
+			goto create_Fail;
+
+		if (sharedCache != NULL)
+		{
+			puzzle->lineKeys[i] = lineCacheKey(sharedCache, lineClues[i]->clues, lineClues[i]->clueCount, puzzle->lines[i]->size);
+
+			if (puzzle->lineKeys[i] < 0)
+				goto create_Fail;
+
+			continue;
+		}
+
+		for (j = 0; j < i && !sameClues(puzzle->lines[j], puzzle->lines[i]); ++j);
+
+		puzzle->lineKeys[i] = j;
+	}
+
+	puzzle->lineClues = lineClues;
+
+	return puzzle;
+
+create_Fail:
+	freePuzzle(puzzle);
+
+	return NULL;
+}
+
+/*
+ * Frees an array of count LineClue structs along with their clue arrays.
+ */
+void freeLineClues (LineClue ** lineClues, int count)
+{
+	int i;
+
+	if (lineClues == NULL) return;
+
+	for (i = 0; i < count; ++i)
+	{
+		if (lineClues[i] == NULL) continue;
+
+		free(lineClues[i]->clues);
+		lineClues[i]->clues = NULL;
+
+		free(lineClues[i]->colours);
+		lineClues[i]->colours = NULL;
+
+		free(lineClues[i]);
+		lineClues[i] = NULL;
+	}
+
+	free(lineClues);
+
+	return;
+}
+
+/*
+ * Releases a Puzzle and everything it owns, including the gameboard. Callers that want
+ * to keep the gameboard take it and set puzzle->gameBoard to NULL first.
+ */
+void freePuzzle (Puzzle * puzzle)
+{
+	int i;
+
+	if (puzzle == NULL) return;
+
+	/* The helpers read the clues */
+	stopSpeculation(puzzle->speculation);
+	puzzle->speculation = NULL;
+
+	if (puzzle->lines != NULL)
+		for (i = 0; i < puzzle->width + puzzle->length; ++i)
+			freeLine(puzzle->lines[i]);
+
+	free(puzzle->lines);
+	puzzle->lines = NULL;
+
+	freeLineClues(puzzle->lineClues, puzzle->width + puzzle->length);
+	puzzle->lineClues = NULL;
+
+	free(puzzle->gameBoard);
+	puzzle->gameBoard = NULL;
+
+	free(puzzle->rowsToUpdate);
+	puzzle->rowsToUpdate = NULL;
+
+	free(puzzle->columnsToUpdate);
+	puzzle->columnsToUpdate = NULL;
+
+	free(puzzle->columnPartialSolution);
+	puzzle->columnPartialSolution = NULL;
+
+	free(puzzle->probeStamps);
+	puzzle->probeStamps = NULL;
+
+	free(puzzle->lineKeys);
+	puzzle->lineKeys = NULL;
+
+	free(puzzle->reportedCells);
+	puzzle->reportedCells = NULL;
+
+	free(puzzle->newCells);
+	puzzle->newCells = NULL;
+
+	if (!puzzle->sharedLineCache)
+		freeLineCache(puzzle->lineCache);
+	puzzle->lineCache = NULL;
+
+	free(puzzle);
+
+	return;
+}
+
+/*
+ * Returns the current CLOCK_MONOTONIC time in nanoseconds.
+ */
+long monotonicNanos (void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/*
+ * Applies a solve's bounds to a puzzle (see SolveOptions), NULL options remove them. The
+ * time limit starts counting now.
+ */
+void setSolveOptions (Puzzle * puzzle, const SolveOptions * options)
+{
+	puzzle->deadline = 0;
+	puzzle->permutationBudget = 0;
+	puzzle->spillLimit = 0;
+	puzzle->cancel = NULL;
+	puzzle->progress = NULL;
+	puzzle->startNanos = monotonicNanos();
+
+	if (options == NULL)
+		return;
+
+	if (options->timeLimitMillis > 0)
+		puzzle->deadline = puzzle->startNanos + options->timeLimitMillis * 1000000L;
+
+	puzzle->permutationBudget = options->permutationBytes;
+	puzzle->spillLimit = options->spillBytes;
+	puzzle->cancel = options->cancel;
+	puzzle->progress = options->progress;
+	puzzle->progressContext = options->progressContext;
+	puzzle->progressCells = options->progressCells;
+
+	return;
+}
+
+/*
+ * Starts a step of a step-wise solve: checkLimits() allows units units of work (0 for no
+ * count) and, once one unit is done, stops the step micros microseconds from now (0 for
+ * no time). Every step so advances by at least one unit.
+ */
+void setStepBudget (Puzzle * puzzle, long units, long micros)
+{
+	puzzle->stepUnits = (units > 0) ? units : LONG_MAX;
+	puzzle->stepDone = 0;
+	puzzle->stepDeadline = (micros > 0) ? monotonicNanos() + micros * 1000L : 0;
+
+	return;
+}
+
+/*
+ * Checks only the puzzle's cancel flag and deadline, for long running work within one
+ * unit (a spilled line's passes) that cannot stop at a step boundary and resume.
+ *
+ * Returns SOLVE_CANCELLED, SOLVE_TIMED_OUT or SOLVE_IN_PROGRESS to carry on.
+ */
+SolveStatus checkDeadline (Puzzle * puzzle)
+{
+	if (puzzle->cancel != NULL && atomic_load(puzzle->cancel))
+		return SOLVE_CANCELLED;
+
+	if (puzzle->deadline > 0 && monotonicNanos() >= puzzle->deadline)
+		return SOLVE_TIMED_OUT;
+
+	return SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Checks the puzzle's cancel flag and deadline, which every stage polls between units of
+ * work (a line, a probe, a search node or decision), and counts the unit against the
+ * budget of a step-wise solve's current step (see setStepBudget()).
+ *
+ * Returns SOLVE_CANCELLED, SOLVE_TIMED_OUT, SOLVE_PAUSED when the step's budget is spent,
+ * or SOLVE_IN_PROGRESS to carry on.
+ */
+SolveStatus checkLimits (Puzzle * puzzle)
+{
+	SolveStatus status = checkDeadline(puzzle);
+
+	if (status != SOLVE_IN_PROGRESS)
+		return status;
+
+	if (puzzle->stepUnits > 0)
+	{
+		if (puzzle->stepDone >= puzzle->stepUnits
+			|| (puzzle->stepDone > 0 && puzzle->stepDeadline > 0 && monotonicNanos() >= puzzle->stepDeadline))
+			return SOLVE_PAUSED;
+
+		++puzzle->stepDone;
+	}
+
+	return SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Reports the solve's progress to the puzzle's progress callback, if any (see
+ * setSolveOptions()): the cells solved since the last report and the counters. Interim
+ * reports (status SOLVE_IN_PROGRESS) are held back until progressCells cells are new,
+ * the PROGRESS_DONE report always goes out.
+ *
+ * Reporting stops, silently, if the bookkeeping cannot be allocated.
+ */
+void reportProgress (Puzzle * puzzle, ProgressStage stage, SolveStatus status)
+{
+	int i, newCount = 0;
+	const int cellCount = puzzle->width * puzzle->length;
+	SolveProgress report;
+
+	if (puzzle->progress == NULL || puzzle->gameBoard == NULL)
+		return;
+
+	if (puzzle->reportedCells == NULL)
+	{
+		puzzle->reportedCells = (unsigned char *)calloc(cellCount, 1);
+		puzzle->newCells = (int *)malloc(sizeof(int) * cellCount);
+
+		if (puzzle->reportedCells == NULL || puzzle->newCells == NULL)
+		{
+			free(puzzle->reportedCells);
+			puzzle->reportedCells = NULL;
+
+			free(puzzle->newCells);
+			puzzle->newCells = NULL;
+
+			puzzle->progress = NULL;
+			return;
+		}
+	}
+
+	/* Solved cells stay solved, so a scan for unreported ones gives the difference */
+	for (i = 0; i < cellCount; ++i)
+		if (puzzle->gameBoard[i] != -1 && !puzzle->reportedCells[i])
+			puzzle->newCells[newCount++] = i;
+
+	if (stage != PROGRESS_DONE && newCount < puzzle->progressCells)
+		return;
+
+	for (i = 0; i < newCount; ++i)
+		puzzle->reportedCells[puzzle->newCells[i]] = 1;
+
+	puzzle->reportedCount += newCount;
+
+	report.stage = stage;
+	report.status = status;
+	report.width = puzzle->width;
+	report.length = puzzle->length;
+	report.iterations = puzzle->iterations;
+	report.solvedCells = puzzle->reportedCount;
+	report.newCellCount = newCount;
+	report.newCells = puzzle->newCells;
+	report.gameBoard = puzzle->gameBoard;
+	report.elapsedNanos = monotonicNanos() - puzzle->startNanos;
+
+	puzzle->progress(&report, puzzle->progressContext);
+
+	return;
+}
+
+/*
+ * Returns the dirty flag of a line: rows use rowsToUpdate, columns columnsToUpdate.
+ */
+static int * dirtyFlag (Puzzle * puzzle, int index)
+{
+	if (index < puzzle->length)
+		return puzzle->rowsToUpdate + index;
+
+	return puzzle->columnsToUpdate + (index - puzzle->length);
+}
+
+/*
+ * Marks every row and column as needing a visit.
+ */
+void markAllDirty (Puzzle * puzzle)
+{
+	int i;
+
+	for (i = 0; i < puzzle->length; ++i)
+		puzzle->rowsToUpdate[i] = 1;
+
+	for (i = 0; i < puzzle->width; ++i)
+		puzzle->columnsToUpdate[i] = 1;
+
+	return;
+}
+
+/*
+ * Loads the gameboard's solved cells for a line into its bit masks.
+ */
+static void loadLine (Puzzle * puzzle, int index)
+{
+	if (index < puzzle->length)
+		updateBitMasks(puzzle->lines[index], puzzle->gameBoard + (index * puzzle->width));
+
+	else
+	{
+		getGameBoardColumn(puzzle->gameBoard, puzzle->columnPartialSolution, puzzle->width, puzzle->length,
+			index - puzzle->length);
+		updateBitMasks(puzzle->lines[index], puzzle->columnPartialSolution);
+	}
+
+	return;
+}
+
+/*
+ * Writes a line's solved cells to the gameboard, flagging the crossing lines of each
+ * newly solved cell. Returns FALSE if the line contradicts the gameboard.
+ */
+static bool storeLine (Puzzle * puzzle, int index)
+{
+	if (index < puzzle->length)
+		return setGameBoardRow(puzzle->gameBoard, puzzle->lines[index], puzzle->columnsToUpdate);
+
+	return setGameBoardColumn(puzzle->gameBoard, puzzle->lines[index], puzzle->width, puzzle->rowsToUpdate);
+}
+
+/*
+ * Moves a line that cannot be enumerated in memory to disk (see spillPermutations()), if
+ * its file would stay within the puzzle's spillLimit. Larger lines, and lines whose spill
+ * file fails, are solved with solveLinePlacements(), which needs no permutations, and try
+ * again on their next visit.
+ *
+ * Returns SOLVE_IN_PROGRESS, SOLVE_UNSATISFIABLE, or the checkDeadline() status that
+ * stopped the spill.
+ */
+static SolveStatus spillLinePermutations (Puzzle * puzzle, Line * line, double placements)
+{
+	SolveStatus status = SOLVE_OUT_OF_MEMORY;
+	double limit = (puzzle->spillLimit > 0) ? (double)puzzle->spillLimit : SPILL_DEFAULT_BYTES;
+
+	if (placements * sizeof(uint64_t) <= limit)
+		status = spillPermutations(line, puzzle);
+
+	if (status != SOLVE_OUT_OF_MEMORY)
+		return status;
+
+	return solveLinePlacements(line, &line->maskBits, &line->partialBits) ? SOLVE_IN_PROGRESS : SOLVE_UNSATISFIABLE;
+}
+
+/*
+ * Filters a spilled line against its newly solved cells (see filterSpilledPermutations()).
+ * A pass that fails or is stopped part way leaves the file of no use: the line drops it
+ * and is enumerated afresh on its next visit, after solveLinePlacements() has solved it
+ * this time round if the file failed.
+ */
+static SolveStatus filterSpill (Puzzle * puzzle, Line * line)
+{
+	SolveStatus status = filterSpilledPermutations(line, puzzle);
+
+	if (status == SOLVE_IN_PROGRESS || status == SOLVE_UNSATISFIABLE)
+		return status;
+
+	clearLinePermutations(line);
+
+	if (status != SOLVE_OUT_OF_MEMORY)
+		return status;
+
+	return solveLinePlacements(line, &line->maskBits, &line->partialBits) ? SOLVE_IN_PROGRESS : SOLVE_UNSATISFIABLE;
+}
+
+/*
+ * Brings one line up to date with the solved cells already loaded into its bit masks.
+ *
+ * A line whose permutations have not been generated yet first gets the rule based
+ * deductions, and is only enumerated if those leave unsolved cells. An enumerated line
+ * is filtered against the newly solved cells. Either way the consensus of the remaining
+ * permutations is then folded into the bit masks.
+ *
+ * A line a helper enumerated ahead of the sweep (see startSpeculation()) adopts that
+ * enumeration and filters it against the cells solved since, instead of enumerating.
+ *
+ * A line whose permutations would not fit in what is left of the puzzle's
+ * permutationBudget is solved with solveLinePlacements() instead, and tries again on its
+ * next visit.
+ *
+ * A line the budget lets through with more permutations than an int counts, or than the
+ * free memory holds (see needsSpill()), may keep them on disk instead (see
+ * spillLinePermutations()), as may a line whose enumeration fails for want of memory.
+ *
+ * Returns SOLVE_IN_PROGRESS, SOLVE_UNSATISFIABLE if the line has no placement left, or the
+ * checkDeadline() status that stopped a spilled line.
+ */
+static SolveStatus solveLinePermutations (Puzzle * puzzle, Line * line)
+{
+	double placements, bytes;
+	Line * speculated = NULL;
+
+	if (line->spill != NULL)
+		return filterSpill(puzzle, line);
+
+	if (line->bitSet == NULL)
+	{
+		if (!applyLineRules(line))
+			return SOLVE_UNSATISFIABLE;
+
+		if (isLineSolved(line))
+			return SOLVE_IN_PROGRESS;
+
+		placements = countPlacements(line);
+
+		/* Each permutation costs its word, its BitSet bit and a bit per cell of index */
+		if (puzzle->permutationBudget > 0)
+		{
+			bytes = placements * (sizeof(uint64_t) + (line->size + 1) / 8.0);
+
+			if (puzzle->permutationBytes + bytes > (double)puzzle->permutationBudget)
+				return solveLinePlacements(line, &line->maskBits, &line->partialBits) ? SOLVE_IN_PROGRESS : SOLVE_UNSATISFIABLE;
+
+			puzzle->permutationBytes += (size_t)bytes;
+		}
+
+		if (needsSpill(placements, line->size))
+			return spillLinePermutations(puzzle, line, placements);
+
+		speculated = (puzzle->speculation != NULL) ? takeSpeculation(puzzle->speculation, line->lineId) : NULL;
+
+		if (speculated != NULL)
+		{
+			moveLinePermutations(line, speculated);
+			freeLine(speculated);
+
+			if (line->permutationCount == 0 || !filterPermutations(line))
+				return SOLVE_UNSATISFIABLE;
+		}
+
+		else if (!enumeratePermutations(line))
+		{
+			clearLinePermutations(line);
+			return spillLinePermutations(puzzle, line, placements);
+		}
+
+		if (line->permutationCount == 0)
+			return SOLVE_UNSATISFIABLE;
+	}
+
+	else if (!filterPermutations(line))
+		return SOLVE_UNSATISFIABLE;
+
+	if (!generateConsistentPattern(line))
+		return SOLVE_UNSATISFIABLE;
+
+	return SOLVE_IN_PROGRESS;
+}
+
+/*
+ * solveLinePermutations() for line index, answered from the line cache when the line's
+ * known cells were solved before (by this line or one with the same clues).
+ *
+ * A cache hit leaves the permutations unfiltered, the next filter catches up on every
+ * cell solved since the last one (see filterPermutations()).
+ */
+static SolveStatus solveLine (Puzzle * puzzle, int index)
+{
+	Line * line = puzzle->lines[index];
+	const uint64_t maskBits = line->maskBits;
+	const uint64_t partialBits = line->partialBits;
+	SolveStatus status;
+
+	switch (lineCacheLookup(puzzle->lineCache, puzzle->lineKeys[index], &line->maskBits, &line->partialBits))
+	{
+		case 1:
+			return SOLVE_IN_PROGRESS;
+
+		case 0:
+			return SOLVE_UNSATISFIABLE;
+	}
+
+	status = solveLinePermutations(puzzle, line);
+
+	if (status == SOLVE_IN_PROGRESS || status == SOLVE_UNSATISFIABLE)
+	{
+		lineCacheStore(puzzle->lineCache, puzzle->lineKeys[index], maskBits, partialBits, status == SOLVE_IN_PROGRESS,
+			line->maskBits, line->partialBits);
+		captureLineSolve(line, maskBits, partialBits, status == SOLVE_IN_PROGRESS, line->maskBits, line->partialBits);
+	}
+
+	return status;
+}
+
+/*
+ * Visits every dirty line once, rows first then columns, clearing each line's flag as it
+ * is visited. rulesOnly limits the visit to applyLineRules(), otherwise solveLine() runs.
+ *
+ * Sets progress to TRUE if any line was flagged again by a newly solved cell.
+ *
+ * Returns SOLVE_IN_PROGRESS, the status of the first line that fails, or the
+ * checkLimits() status that stopped the pass (lines not yet visited stay flagged).
+ */
+static SolveStatus linePass (Puzzle * puzzle, bool rulesOnly, bool * progress)
+{
+	int i, * flag;
+	SolveStatus status;
+	const int lineCount = puzzle->width + puzzle->length;
+
+	for (i = 0; i < lineCount; ++i)
+	{
+		flag = dirtyFlag(puzzle, i);
+		if (*flag == 0)
+			continue;
+
+		status = checkLimits(puzzle);
+		if (status != SOLVE_IN_PROGRESS)
+			return status;
+
+		*flag = 0;
+		loadLine(puzzle, i);
+
+		if (rulesOnly)
+			status = applyLineRules(puzzle->lines[i]) ? SOLVE_IN_PROGRESS : SOLVE_UNSATISFIABLE;
+		else
+			status = solveLine(puzzle, i);
+
+		/* A spilled line stopped part way is visited again should the solve go on */
+		if (status == SOLVE_TIMED_OUT || status == SOLVE_CANCELLED)
+			*flag = 1;
+
+		if (status != SOLVE_IN_PROGRESS)
+			return status;
+
+		if (!storeLine(puzzle, i))
+			return SOLVE_UNSATISFIABLE;
+	}
+
+	*progress = FALSE;
+
+	for (i = 0; i < lineCount && !(*progress); ++i)
+		*progress = *dirtyFlag(puzzle, i) == 1;
+
+	return SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Sweeps the dirty lines until the puzzle is solved, a sweep solves nothing new or a
+ * line fails. Each sweep is counted in puzzle->iterations.
+ *
+ * Used both after the rule pre-pass and to resume propagation once other stages (such
+ * as probing) have solved cells and flagged their lines. The first sweep starts the
+ * speculative enumeration of the lines the sweeps are about to enumerate, which runs
+ * until endSpeculation().
+ *
+ * Return values are as for propagatePuzzle().
+ */
+SolveStatus resumePropagation (Puzzle * puzzle)
+{
+	bool progress = TRUE;
+	SolveStatus status;
+
+	while (!isSolved(puzzle->gameBoard, puzzle->width, puzzle->length))
+	{
+		if (!progress)
+			return SOLVE_INCOMPLETE;
+
+		/* The first sweeps enumerate every line the rules left open, start on them now */
+		if (!puzzle->speculated)
+		{
+			puzzle->speculated = TRUE;
+			puzzle->speculation = startSpeculation(puzzle);
+		}
+
+		++(puzzle->iterations);
+
+		status = linePass(puzzle, FALSE, &progress);
+		if (status != SOLVE_IN_PROGRESS)
+			return status;
+
+		reportProgress(puzzle, PROGRESS_SWEEP, SOLVE_IN_PROGRESS);
+	}
+
+	return SOLVE_SOLVED;
+}
+
+/*
+ * Stops the speculative enumeration once the sweeps it serves are over, so its lines do
+ * not hold the pool and memory through the later stages. It is not started again.
+ */
+void endSpeculation (Puzzle * puzzle)
+{
+	stopSpeculation(puzzle->speculation);
+	puzzle->speculation = NULL;
+	puzzle->speculated = TRUE;
+
+	return;
+}
+
+/*
+ * Repeats the rule based line deductions over the dirty lines until they stop solving
+ * cells. Lines a stop leaves unvisited stay flagged, so calling again carries on.
+ *
+ * Returns SOLVE_IN_PROGRESS once the rules are exhausted, otherwise as for linePass().
+ */
+SolveStatus propagateRules (Puzzle * puzzle)
+{
+	bool progress = TRUE;
+	SolveStatus status;
+
+	while (progress)
+	{
+		status = linePass(puzzle, TRUE, &progress);
+		if (status != SOLVE_IN_PROGRESS)
+			return status;
+
+		reportProgress(puzzle, PROGRESS_RULES, SOLVE_IN_PROGRESS);
+	}
+
+	return SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Runs line propagation on a puzzle until it is solved, stalls or is shown to have no
+ * solution.
+ *
+ * Workflow:
+ * - Repeats the rule based line deductions over all lines until they stop solving cells.
+ * - Alternates sweeping rows and columns with resumePropagation().
+ * - Lines are only enumerated when the rules leave them unsolved (see solveLine()).
+ *
+ * Return:
+ * - SOLVE_SOLVED when every cell is solved.
+ * - SOLVE_INCOMPLETE when a sweep solves nothing new, the gameboard holds what line
+ *   logic could deduce.
+ * - SOLVE_UNSATISFIABLE when a line runs out of placements or contradicts the gameboard.
+ * - SOLVE_TIMED_OUT or SOLVE_CANCELLED when the puzzle's limits stop it (see
+ *   checkLimits()), the gameboard holds what was deduced until then.
+ */
+SolveStatus propagatePuzzle (Puzzle * puzzle)
+{
+	SolveStatus status;
+
+	markAllDirty(puzzle);
+
+	status = propagateRules(puzzle);
+	if (status != SOLVE_IN_PROGRESS)
+		return status;
+
+	markAllDirty(puzzle);
+
+	return resumePropagation(puzzle);
+}
+
+/*
+ * Reads a line's solved cells from any gameboard (such as a probing or search copy)
+ * into mask and partial bits.
+ */
+void readBoardLine (Puzzle * puzzle, const int * board, int index, uint64_t * maskBits, uint64_t * partialBits)
+{
+	int i, cell, step, size = puzzle->lines[index]->size;
+
+	*maskBits = 0ULL;
+	*partialBits = 0ULL;
+
+	cell = (index < puzzle->length) ? index * puzzle->width : index - puzzle->length;
+	step = (index < puzzle->length) ? 1 : puzzle->width;
+
+	for (i = 0; i < size; ++i, cell += step)
+		if (board[cell] != -1)
+		{
+			*maskBits |= 1ULL << i;
+
+			if (board[cell] == 1)
+				*partialBits |= 1ULL << i;
+		}
+
+	return;
+}
+
+/*
+ * Writes a line's solved cells to any gameboard, flagging the crossing line of each
+ * newly solved cell in pending (indexed like puzzle->lines).
+ *
+ * Returns FALSE if a solved cell contradicts the gameboard.
+ */
+bool writeBoardLine (Puzzle * puzzle, int * board, int index, uint64_t maskBits, uint64_t partialBits, int * pending)
+{
+	int i, cell, step, value, size = puzzle->lines[index]->size;
+	bool isRow = index < puzzle->length;
+
+	cell = isRow ? index * puzzle->width : index - puzzle->length;
+	step = isRow ? 1 : puzzle->width;
+
+	for (i = 0; i < size; ++i, cell += step)
+	{
+		if (((maskBits >> i) & 1ULL) == 0)
+			continue;
+
+		value = (int)((partialBits >> i) & 1ULL);
+
+		if (board[cell] == -1)
+		{
+			board[cell] = value;
+			pending[isRow ? puzzle->length + i : i] = 1;
+		}
+
+		else if (board[cell] != value)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Solves line index for a hypothetical set of solved cells with solveLineState(),
+ * answered from the line cache when that state was solved before.
+ *
+ * Returns FALSE if no placement fits the given solved cells.
+ */
+bool solveBoardLine (Puzzle * puzzle, int index, uint64_t * maskBits, uint64_t * partialBits)
+{
+	const uint64_t mask = *maskBits;
+	const uint64_t partial = *partialBits;
+	int cached = lineCacheLookup(puzzle->lineCache, puzzle->lineKeys[index], maskBits, partialBits);
+	bool feasible;
+
+	if (cached >= 0)
+		return cached == 1;
+
+	feasible = solveLineState(puzzle->lines[index], maskBits, partialBits);
+
+	lineCacheStore(puzzle->lineCache, puzzle->lineKeys[index], mask, partial, feasible, *maskBits, *partialBits);
+	captureLineSolve(puzzle->lines[index], mask, partial, feasible, *maskBits, *partialBits);
+
+	return feasible;
+}
+
+/*
+ * Runs line propagation on a copy of the gameboard without touching the puzzle's own
+ * lines, as used by probing and search to explore hypothetical cell values.
+ *
+ * pending flags (indexed like puzzle->lines) the lines to check, it is cleared as lines
+ * are visited and filled in again for the crossing lines of every cell solved. Each line
+ * is solved with solveBoardLine() against the puzzle's live permutations.
+ *
+ * Returns FALSE as soon as any line has no placement left, leaving the board partially
+ * propagated and pending cleared.
+ */
+bool propagateBoard (Puzzle * puzzle, int * board, int * pending)
+{
+	int i;
+	bool progress = TRUE;
+	uint64_t maskBits, partialBits;
+	const int lineCount = puzzle->width + puzzle->length;
+
+	while (progress)
+	{
+		progress = FALSE;
+
+		for (i = 0; i < lineCount; ++i)
+		{
+			if (pending[i] == 0)
+				continue;
+
+			pending[i] = 0;
+			progress = TRUE;
+
+			readBoardLine(puzzle, board, i, &maskBits, &partialBits);
+
+			if (!solveBoardLine(puzzle, i, &maskBits, &partialBits)
+				|| !writeBoardLine(puzzle, board, i, maskBits, partialBits, pending))
+			{
+				memset(pending, 0x00, sizeof(int) * lineCount);
+				return FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+/*
+ * Copies solved cells from a gameboard copy back into the puzzle's gameboard, flagging
+ * the row and column of every cell that changes for the next sweep.
+ *
+ * Returns the number of cells solved.
+ */
+int adoptBoard (Puzzle * puzzle, const int * board)
+{
+	int i, solved = 0;
+
+	for (i = 0; i < puzzle->width * puzzle->length; ++i)
+		if (puzzle->gameBoard[i] == -1 && board[i] != -1)
+		{
+			puzzle->gameBoard[i] = board[i];
+			puzzle->rowsToUpdate[i / puzzle->width] = 1;
+			puzzle->columnsToUpdate[i % puzzle->width] = 1;
+			++solved;
+		}
+
+	return solved;
+}
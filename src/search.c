@@ -0,0 +1,911 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../include/search.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/parallel.h"
+
+/*
+ * Parallel depth first search over cell guesses.
+ *
+ * Every node of the guess tree is a propagated copy of the gameboard, followed by the
+ * number of unsolved cells on each line. Each worker owns a deque of nodes: it expands its
+ * newest node (depth first, keeping its memory use at about one sibling per level) while
+ * idle workers steal the oldest node of another worker, which is the largest subtree that
+ * worker has not started on.
+ *
+ * Before a node branches it is probed: the cells of its most constrained lines (fewest
+ * unsolved cells, kept up to date as cells are solved rather than recounted) are assumed
+ * filled and empty in turn. A value that contradicts is a failed literal, the other value
+ * is forced, as are the cells both values solve alike, and the node is probed again until
+ * nothing more is forced. The node then branches on the probed cell whose two values
+ * solved the most cells, its children being the boards the probe already propagated.
+ *
+ * Each failed literal is explained, as clause learning would, by walking the contradiction
+ * back through the lines that implied its cells to the cells the node already had. Those
+ * cells and the literal make a nogood, kept in a store every worker shares, so the same
+ * failure is recognised without propagating in every other node that holds those cells,
+ * stolen subtrees and the root's children included.
+ */
+
+/* Cells probed at most per pass over a node, taken from its most constrained lines */
+#define SEARCH_PROBE_CELLS 1024
+
+/* Largest nogood kept, longer ones rarely hold again */
+#define NOGOOD_MAX_LITERALS 64
+
+/* Nogoods kept in all, the store stops growing past it */
+#define NOGOOD_MAX_COUNT 65536
+
+/* A set of cell values (cell * 2 + value) no solution holds together with the literal
+	whose list it is on */
+typedef struct Nogood {
+	struct Nogood * next;
+	int count;
+	int literals[];
+} Nogood;
+
+typedef struct WorkQueue {
+	pthread_mutex_t lock;
+	int ** nodes;
+	int first;
+	int count;
+	int capacity;
+} WorkQueue;
+
+typedef struct SearchContext {
+	Puzzle * puzzle;
+	const int * lines;         /* The lines holding the region's cells (all lines without one) */
+	int lineTotal;
+	WorkQueue * queues;
+	int queueCount;
+	int cellCount;
+	int nodeSize;              /* The board's cells, then every line's unsolved count */
+	long solutionLimit;
+	int * firstSolution;
+	_Atomic(Nogood *) * nogoods;   /* Per literal, cell * 2 + value */
+	atomic_int nogoodCount;
+	pthread_mutex_t resultLock;
+	atomic_long pendingNodes;
+	atomic_long solutionCount;
+	atomic_bool stop;
+	atomic_bool outOfMemory;
+	atomic_int limitStatus;
+} SearchContext;
+
+/* A worker's probing state: the boards it propagates and why each cell got its value */
+typedef struct SearchScratch {
+	int * pending;
+	int * probes[2];           /* The node with the probed cell empty and filled */
+	int * best[2];             /* The probes of the best cell to branch on so far */
+	int gains[2];
+	int * assignedAt;          /* The probe that solved each cell, see stamp */
+	int * reasonLine;          /* The line that solved it, -1 for the probed cell */
+	uint64_t * reasonMask;     /* That line's solved cells it was deduced from */
+	int stamp;
+	int * seen;
+	int seenStamp;
+	int * worklist;
+	int * literals;
+	int * lineOrder;
+	int * bucketStart;
+	int * candidates;
+} SearchScratch;
+
+static int * copyBoard (int cellCount, const int * board)
+{
+	int * copy = (int *)malloc(sizeof(int) * cellCount);
+
+	if (copy != NULL)
+		memcpy(copy, board, sizeof(int) * cellCount);
+
+	return copy;
+}
+
+/*
+ * Appends a node to the owner's end of a queue. Returns FALSE if the queue cannot grow.
+ */
+static bool pushNode (WorkQueue * queue, int * node)
+{
+	int ** grown;
+	bool pushed = TRUE;
+
+	pthread_mutex_lock(&queue->lock);
+
+	/* Reuse the room left by stolen nodes before growing */
+	if (queue->first > 0 && queue->first + queue->count == queue->capacity)
+	{
+		memmove(queue->nodes, queue->nodes + queue->first, sizeof(int *) * queue->count);
+		queue->first = 0;
+	}
+
+	if (queue->first + queue->count == queue->capacity)
+	{
+		grown = (int **)realloc(queue->nodes, sizeof(int *) * (queue->capacity * 2 + 16));
+
+		if (grown == NULL)
+			pushed = FALSE;
+
+		else
+		{
+			queue->nodes = grown;
+			queue->capacity = queue->capacity * 2 + 16;
+		}
+	}
+
+	if (pushed)
+		queue->nodes[queue->first + queue->count++] = node;
+
+	pthread_mutex_unlock(&queue->lock);
+
+	return pushed;
+}
+
+/*
+ * Takes the newest node (owner) or the oldest node (thief) from a queue, NULL if empty.
+ */
+static int * takeNode (WorkQueue * queue, bool newest)
+{
+	int * node = NULL;
+
+	pthread_mutex_lock(&queue->lock);
+
+	if (queue->count > 0)
+	{
+		--queue->count;
+
+		if (newest)
+			node = queue->nodes[queue->first + queue->count];
+		else
+			node = queue->nodes[queue->first++];
+
+		if (queue->count == 0)
+			queue->first = 0;
+	}
+
+	pthread_mutex_unlock(&queue->lock);
+
+	return node;
+}
+
+/*
+ * Frees a worker's scratch, safe to call on a partially allocated one.
+ */
+static void freeScratch (SearchScratch * scratch)
+{
+	int value;
+
+	free(scratch->pending);
+
+	for (value = 0; value <= 1; ++value)
+	{
+		free(scratch->probes[value]);
+		free(scratch->best[value]);
+	}
+
+	free(scratch->assignedAt);
+	free(scratch->reasonLine);
+	free(scratch->reasonMask);
+	free(scratch->seen);
+	free(scratch->worklist);
+	free(scratch->literals);
+	free(scratch->lineOrder);
+	free(scratch->bucketStart);
+	free(scratch->candidates);
+
+	memset(scratch, 0x00, sizeof(SearchScratch));
+
+	return;
+}
+
+/*
+ * Allocates a worker's scratch. Returns FALSE (with nothing left allocated) if memory
+ * runs out.
+ */
+static bool createScratch (SearchContext * context, SearchScratch * scratch)
+{
+	int value;
+	const int lineCount = context->puzzle->width + context->puzzle->length;
+	bool allocated = TRUE;
+
+	memset(scratch, 0x00, sizeof(SearchScratch));
+
+	scratch->pending = (int *)calloc(lineCount, sizeof(int));
+
+	for (value = 0; value <= 1; ++value)
+	{
+		scratch->probes[value] = (int *)malloc(sizeof(int) * context->nodeSize);
+		scratch->best[value] = (int *)malloc(sizeof(int) * context->nodeSize);
+		allocated = allocated && scratch->probes[value] != NULL && scratch->best[value] != NULL;
+	}
+
+	scratch->assignedAt = (int *)calloc(context->cellCount, sizeof(int));
+	scratch->reasonLine = (int *)malloc(sizeof(int) * context->cellCount);
+	scratch->reasonMask = (uint64_t *)malloc(sizeof(uint64_t) * context->cellCount);
+	scratch->seen = (int *)calloc(context->cellCount, sizeof(int));
+	scratch->worklist = (int *)malloc(sizeof(int) * context->cellCount);
+	scratch->literals = (int *)malloc(sizeof(int) * NOGOOD_MAX_LITERALS);
+	scratch->lineOrder = (int *)malloc(sizeof(int) * lineCount);
+	scratch->bucketStart = (int *)malloc(sizeof(int) * (MAX_LINE_SIZE + 2));
+	scratch->candidates = (int *)malloc(sizeof(int) * SEARCH_PROBE_CELLS);
+
+	if (!allocated || scratch->pending == NULL || scratch->assignedAt == NULL || scratch->reasonLine == NULL
+		|| scratch->reasonMask == NULL || scratch->seen == NULL || scratch->worklist == NULL
+		|| scratch->literals == NULL || scratch->lineOrder == NULL || scratch->bucketStart == NULL
+		|| scratch->candidates == NULL)
+	{
+		freeScratch(scratch);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * The cell at position of line index.
+ */
+static int lineCell (Puzzle * puzzle, int index, int position)
+{
+	return (index < puzzle->length) ? index * puzzle->width + position : (index - puzzle->length) + position * puzzle->width;
+}
+
+/*
+ * Solves a cell of a node, counting it off its row and column and recording why.
+ */
+static void assignCell (SearchContext * context, SearchScratch * scratch, int * node, int cell, int value, int line, uint64_t reason)
+{
+	Puzzle * puzzle = context->puzzle;
+
+	node[cell] = value;
+	--node[context->cellCount + cell / puzzle->width];
+	--node[context->cellCount + puzzle->length + cell % puzzle->width];
+
+	scratch->assignedAt[cell] = scratch->stamp;
+	scratch->reasonLine[cell] = line;
+	scratch->reasonMask[cell] = reason;
+
+	return;
+}
+
+/*
+ * propagateBoard() on a node, keeping its unsolved counts and recording for every cell it
+ * solves the line and the cells of that line it followed from (see assignCell()).
+ *
+ * Returns the number of cells solved, or -1 on a contradiction with conflictLine set to
+ * the line that has no placement left and pending cleared.
+ */
+static int propagateNode (SearchContext * context, SearchScratch * scratch, int * node, int * conflictLine)
+{
+	int i, position, solvedCells = 0;
+	bool progress = TRUE;
+	uint64_t known, partial, maskBits, partialBits, solved;
+	Puzzle * puzzle = context->puzzle;
+	const int lineCount = puzzle->width + puzzle->length;
+
+	while (progress)
+	{
+		progress = FALSE;
+
+		for (i = 0; i < lineCount; ++i)
+		{
+			if (scratch->pending[i] == 0)
+				continue;
+
+			scratch->pending[i] = 0;
+			progress = TRUE;
+
+			readBoardLine(puzzle, node, i, &known, &partial);
+			maskBits = known;
+			partialBits = partial;
+
+			if (!solveBoardLine(puzzle, i, &maskBits, &partialBits))
+			{
+				memset(scratch->pending, 0x00, sizeof(int) * lineCount);
+				*conflictLine = i;
+				return -1;
+			}
+
+			for (solved = maskBits & ~known; solved != 0ULL; solved &= solved - 1ULL)
+			{
+				position = __builtin_ctzll(solved);
+
+				assignCell(context, scratch, node, lineCell(puzzle, i, position), (int)((partialBits >> position) & 1ULL), i, known);
+				scratch->pending[(i < puzzle->length) ? puzzle->length + position : position] = 1;
+				++solvedCells;
+			}
+		}
+	}
+
+	return solvedCells;
+}
+
+/*
+ * Adds the known cells of line index (its bits in mask) to the analysis worklist, each
+ * cell once.
+ */
+static void queueLineCells (SearchContext * context, SearchScratch * scratch, int index, uint64_t mask, int * queued)
+{
+	int cell;
+
+	for (; mask != 0ULL; mask &= mask - 1ULL)
+	{
+		cell = lineCell(context->puzzle, index, __builtin_ctzll(mask));
+
+		if (scratch->seen[cell] != scratch->seenStamp)
+		{
+			scratch->seen[cell] = scratch->seenStamp;
+			scratch->worklist[(*queued)++] = cell;
+		}
+	}
+
+	return;
+}
+
+/*
+ * Explains a failed probe of literal (cell * 2 + value) on node: the conflicting line's
+ * cells are traced back through the lines that solved them during the probe, down to the
+ * cells the node already had. Those are stored as a nogood of the literal, unless there
+ * are more than NOGOOD_MAX_LITERALS of them or the store is full.
+ *
+ * Returns FALSE when the trace never reaches the probed cell, the node's own cells then
+ * contradict and it holds no solution.
+ */
+static bool learnNogood (SearchContext * context, SearchScratch * scratch, const int * node, int literal, int conflictLine)
+{
+	int cell, queued = 0, next, count = 0;
+	bool reached = FALSE, fits = TRUE;
+	uint64_t known, partial;
+	Nogood * nogood;
+	Nogood * head;
+
+	++scratch->seenStamp;
+
+	readBoardLine(context->puzzle, scratch->probes[literal & 1], conflictLine, &known, &partial);
+	queueLineCells(context, scratch, conflictLine, known, &queued);
+
+	for (next = 0; next < queued; ++next)
+	{
+		cell = scratch->worklist[next];
+
+		if (scratch->assignedAt[cell] != scratch->stamp)
+		{
+			if (count < NOGOOD_MAX_LITERALS)
+				scratch->literals[count++] = cell * 2 + node[cell];
+			else
+				fits = FALSE;
+		}
+
+		else if (scratch->reasonLine[cell] < 0)
+			reached = TRUE;
+
+		else
+			queueLineCells(context, scratch, scratch->reasonLine[cell], scratch->reasonMask[cell], &queued);
+	}
+
+	if (!reached || !fits || atomic_load(&context->nogoodCount) >= NOGOOD_MAX_COUNT
+		|| atomic_fetch_add(&context->nogoodCount, 1) >= NOGOOD_MAX_COUNT)
+		return reached;
+
+	nogood = (Nogood *)malloc(sizeof(Nogood) + sizeof(int) * count);
+
+	/* The store is only a shortcut, a nogood it misses is found again by propagation */
+	if (nogood == NULL)
+		return TRUE;
+
+	nogood->count = count;
+	memcpy(nogood->literals, scratch->literals, sizeof(int) * count);
+
+	head = atomic_load(&context->nogoods[literal]);
+	do
+		nogood->next = head;
+	while (!atomic_compare_exchange_weak(&context->nogoods[literal], &head, nogood));
+
+	return TRUE;
+}
+
+/*
+ * Returns TRUE if a stored nogood of literal (cell * 2 + value) holds on the node, so the
+ * literal fails there without propagating it.
+ */
+static bool nogoodHolds (SearchContext * context, const int * node, int literal)
+{
+	int i;
+	const Nogood * nogood;
+
+	for (nogood = atomic_load(&context->nogoods[literal]); nogood != NULL; nogood = nogood->next)
+	{
+		for (i = 0; i < nogood->count && node[nogood->literals[i] >> 1] == (nogood->literals[i] & 1); ++i);
+
+		if (i == nogood->count)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+ * Propagates the node with cell set to value into scratch->probes[value], counting the
+ * cells solved in scratch->gains[value]. A literal that fails is learnt as a nogood.
+ *
+ * Returns FALSE if the value contradicts, with dead set when the node itself does.
+ */
+static bool probeCell (SearchContext * context, SearchScratch * scratch, const int * node, int cell, int value, bool * dead)
+{
+	int conflictLine;
+	Puzzle * puzzle = context->puzzle;
+	int * probe = scratch->probes[value];
+
+	if (nogoodHolds(context, node, cell * 2 + value))
+		return FALSE;
+
+	memcpy(probe, node, sizeof(int) * context->nodeSize);
+
+	++scratch->stamp;
+	assignCell(context, scratch, probe, cell, value, -1, 0ULL);
+
+	scratch->pending[cell / puzzle->width] = 1;
+	scratch->pending[puzzle->length + cell % puzzle->width] = 1;
+
+	scratch->gains[value] = propagateNode(context, scratch, probe, &conflictLine);
+
+	if (scratch->gains[value] >= 0)
+		return TRUE;
+
+	*dead = !learnNogood(context, scratch, node, cell * 2 + value, conflictLine);
+
+	return FALSE;
+}
+
+/*
+ * Gathers up to SEARCH_PROBE_CELLS unsolved cells of the node into scratch->candidates,
+ * from the region's lines with the fewest unsolved cells first. The lines are ordered by
+ * a counting sort of the unsolved counts the node carries, no cell is scanned.
+ *
+ * Returns the number of cells gathered, 0 once the region is solved.
+ */
+static int gatherCandidates (SearchContext * context, SearchScratch * scratch, const int * node)
+{
+	int i, line, unsolved, position, cell, gathered = 0;
+	const int * counts = node + context->cellCount;
+	int * bucketStart = scratch->bucketStart;
+
+	memset(bucketStart, 0x00, sizeof(int) * (MAX_LINE_SIZE + 2));
+
+	for (i = 0; i < context->lineTotal; ++i)
+		++bucketStart[counts[context->lines[i]] + 1];
+
+	for (i = 1; i < MAX_LINE_SIZE + 2; ++i)
+		bucketStart[i] += bucketStart[i - 1];
+
+	for (i = 0; i < context->lineTotal; ++i)
+	{
+		line = context->lines[i];
+		scratch->lineOrder[bucketStart[counts[line]]++] = line;
+	}
+
+	++scratch->seenStamp;
+
+	for (i = 0; i < context->lineTotal && gathered < SEARCH_PROBE_CELLS; ++i)
+	{
+		line = scratch->lineOrder[i];
+		unsolved = counts[line];
+
+		for (position = 0; unsolved > 0 && gathered < SEARCH_PROBE_CELLS; ++position)
+		{
+			cell = lineCell(context->puzzle, line, position);
+
+			if (node[cell] != -1)
+				continue;
+
+			--unsolved;
+
+			if (scratch->seen[cell] != scratch->seenStamp)
+			{
+				scratch->seen[cell] = scratch->seenStamp;
+				scratch->candidates[gathered++] = cell;
+			}
+		}
+	}
+
+	return gathered;
+}
+
+/*
+ * Adopts the cells both probes of a cell solved the same way, which hold whatever the
+ * cell's value, and propagates them through the node.
+ *
+ * Returns the number of cells adopted, or -1 if they contradict and the node holds no
+ * solution.
+ */
+static int adoptAgreement (SearchContext * context, SearchScratch * scratch, int * node)
+{
+	int cell, conflictLine, adopted = 0;
+	Puzzle * puzzle = context->puzzle;
+	const int * empty = scratch->probes[0];
+	const int * filled = scratch->probes[1];
+
+	++scratch->stamp;
+
+	for (cell = 0; cell < context->cellCount; ++cell)
+		if (node[cell] == -1 && empty[cell] != -1 && empty[cell] == filled[cell])
+		{
+			assignCell(context, scratch, node, cell, empty[cell], -1, 0ULL);
+			scratch->pending[cell / puzzle->width] = 1;
+			scratch->pending[puzzle->length + cell % puzzle->width] = 1;
+			++adopted;
+		}
+
+	if (adopted > 0 && propagateNode(context, scratch, node, &conflictLine) < 0)
+		return -1;
+
+	return adopted;
+}
+
+/*
+ * Counts a complete board as a solution, keeping the first one, and raises the stop flag
+ * once the solution limit is reached.
+ */
+static void recordSolution (SearchContext * context, const int * board)
+{
+	long count = atomic_fetch_add(&context->solutionCount, 1) + 1;
+
+	if (count == 1)
+	{
+		pthread_mutex_lock(&context->resultLock);
+		memcpy(context->firstSolution, board, sizeof(int) * context->cellCount);
+		pthread_mutex_unlock(&context->resultLock);
+	}
+
+	if (context->solutionLimit > 0 && count >= context->solutionLimit)
+		atomic_store(&context->stop, TRUE);
+
+	return;
+}
+
+/*
+ * Stops the search on the puzzle's limits. Returns FALSE once the search is stopped.
+ */
+static bool keepSearching (SearchContext * context)
+{
+	SolveStatus limit = checkLimits(context->puzzle);
+
+	if (limit != SOLVE_IN_PROGRESS)
+	{
+		atomic_store(&context->limitStatus, limit);
+		atomic_store(&context->stop, TRUE);
+	}
+
+	return !atomic_load(&context->stop);
+}
+
+/*
+ * Probes a node (see probeCell()), adopting every value the other one's failure forces
+ * until a pass over the candidates forces nothing, then replaces the node by its children:
+ * the probes of the candidate whose values both solved the most cells (the filled one
+ * queued last, so the owner explores it first). A node whose region is solved is a
+ * solution, a node with a cell neither value fits is dropped.
+ */
+
+static void expandNode (SearchContext * context, WorkQueue * queue, int * node, SearchScratch * scratch)
+{
+	int i, value, cell, candidates, best, agreed;
+	long score, bestScore;
+	bool forced = TRUE, dead = FALSE, fits[2];
+	int * child;
+	int * swap;
+
+	while (forced)
+	{
+		forced = FALSE;
+		best = -1;
+		bestScore = -1;
+
+		candidates = gatherCandidates(context, scratch, node);
+
+		if (candidates == 0)
+		{
+			recordSolution(context, node);
+			return;
+		}
+
+		for (i = 0; i < candidates; ++i)
+		{
+			cell = scratch->candidates[i];
+
+			if (node[cell] != -1)
+				continue;
+
+			if (!keepSearching(context))
+				return;
+
+			for (value = 0; value <= 1; ++value)
+			{
+				fits[value] = probeCell(context, scratch, node, cell, value, &dead);
+
+				if (dead)
+					return;
+			}
+
+			if (!fits[0] && !fits[1])
+				return;
+
+			/* A failed literal, the node takes the other value and all it implies */
+			if (fits[0] != fits[1])
+			{
+				memcpy(node, scratch->probes[fits[1] ? 1 : 0], sizeof(int) * context->nodeSize);
+				forced = TRUE;
+				continue;
+			}
+
+			agreed = adoptAgreement(context, scratch, node);
+
+			if (agreed < 0)
+				return;
+
+			if (agreed > 0)
+				forced = TRUE;
+
+			if (forced)
+				continue;
+
+			score = (long)(scratch->gains[0] + 1) * (scratch->gains[1] + 1);
+
+			if (score > bestScore)
+			{
+				best = cell;
+				bestScore = score;
+
+				for (value = 0; value <= 1; ++value)
+				{
+					swap = scratch->best[value];
+					scratch->best[value] = scratch->probes[value];
+					scratch->probes[value] = swap;
+				}
+			}
+		}
+	}
+
+	if (best < 0)
+		return;
+
+	for (value = 0; value <= 1; ++value)
+	{
+		child = copyBoard(context->nodeSize, scratch->best[value]);
+
+		if (child == NULL)
+		{
+			atomic_store(&context->outOfMemory, TRUE);
+			atomic_store(&context->stop, TRUE);
+			return;
+		}
+
+		atomic_fetch_add(&context->pendingNodes, 1);
+
+		if (!pushNode(queue, child))
+		{
+			free(child);
+			atomic_fetch_sub(&context->pendingNodes, 1);
+			atomic_store(&context->outOfMemory, TRUE);
+			atomic_store(&context->stop, TRUE);
+			return;
+		}
+	}
+
+	return;
+}
+
+/*
+ * Worker body (one task per worker): expands its own newest node, otherwise steals the
+ * oldest node of the next non-empty queue, and leaves once no node is queued or being
+ * expanded anywhere, or the search is stopped (by a worker, or by the puzzle's limits
+ * checked before every node and every probe).
+ */
+static void searchWorker (void * arg, int worker)
+{
+	int i;
+	SearchContext * context = (SearchContext *)arg;
+	Puzzle * puzzle = context->puzzle;
+	WorkQueue * own = &context->queues[worker];
+	int * node;
+	SearchScratch scratch;
+	SolveStatus limit;
+
+	if (!createScratch(context, &scratch))
+	{
+		atomic_store(&context->outOfMemory, TRUE);
+		atomic_store(&context->stop, TRUE);
+		return;
+	}
+
+	while (!atomic_load(&context->stop))
+	{
+		limit = checkLimits(puzzle);
+		if (limit != SOLVE_IN_PROGRESS)
+		{
+			atomic_store(&context->limitStatus, limit);
+			atomic_store(&context->stop, TRUE);
+			break;
+		}
+
+		node = takeNode(own, TRUE);
+
+		for (i = 1; node == NULL && i < context->queueCount; ++i)
+			node = takeNode(&context->queues[(worker + i) % context->queueCount], FALSE);
+
+		if (node == NULL)
+		{
+			if (atomic_load(&context->pendingNodes) == 0)
+				break;
+
+			sched_yield();
+			continue;
+		}
+
+		expandNode(context, own, node, &scratch);
+		free(node);
+
+		atomic_fetch_sub(&context->pendingNodes, 1);
+	}
+
+	freeScratch(&scratch);
+
+	return;
+}
+
+/*
+ * Finds solutions of a stalled puzzle by guessing cells on top of line propagation,
+ * across getWorkerCount() threads.
+ *
+ * Parameters:
+ * - puzzle        : A puzzle whose gameboard line propagation has taken as far as it can.
+ * - cells         : Optional (may be NULL), only guess these cells, a region whose rows and
+ *                   columns hold no other unsolved cell (see findComponents()).
+ * - cellCount     : Number of cells in the region.
+ * - solutionLimit : Stop after this many solutions, 1 to find any solution, 0 to count all.
+ * - solutionCount : Optional (may be NULL), receives the number of solutions found.
+ *
+ * The puzzle's lines are only read, so workers share them and keep private boards, the
+ * nogoods their probes learn are shared for the length of the search.
+ *
+ * Return:
+ * - SOLVE_SOLVED with the first solution found written to puzzle->gameBoard (only the
+ *   region's cells when searching a region).
+ * - SOLVE_UNSATISFIABLE when the whole tree holds no solution.
+ * - SOLVE_OUT_OF_MEMORY when a board or queue cannot be allocated.
+ * - SOLVE_TIMED_OUT or SOLVE_CANCELLED when the puzzle's limits stop the search first,
+ *   solutionCount then holds the solutions found so far.
+ */
+SolveStatus searchPuzzle (Puzzle * puzzle, const int * cells, int cellCount, long solutionLimit, long * solutionCount)
+{
+	int i, cell, initialised = 0;
+	SearchContext context;
+	int * node;
+	int * lines = NULL;
+	Nogood * nogood;
+	const int lineCount = puzzle->width + puzzle->length;
+	SolveStatus status = SOLVE_OUT_OF_MEMORY;
+
+	memset(&context, 0x00, sizeof(SearchContext));
+	context.puzzle = puzzle;
+	context.cellCount = puzzle->width * puzzle->length;
+	context.nodeSize = context.cellCount + lineCount;
+	context.solutionLimit = solutionLimit;
+	context.queueCount = getWorkerCount();
+	atomic_init(&context.pendingNodes, 0);
+	atomic_init(&context.solutionCount, 0);
+	atomic_init(&context.stop, FALSE);
+	atomic_init(&context.outOfMemory, FALSE);
+	atomic_init(&context.limitStatus, SOLVE_IN_PROGRESS);
+	atomic_init(&context.nogoodCount, 0);
+	pthread_mutex_init(&context.resultLock, NULL);
+
+	context.firstSolution = (int *)malloc(sizeof(int) * context.cellCount);
+	context.queues = (WorkQueue *)calloc(context.queueCount, sizeof(WorkQueue));
+	context.nogoods = (_Atomic(Nogood *) *)calloc(context.cellCount * 2, sizeof(Nogood *));
+	lines = (int *)calloc(lineCount, sizeof(int));
+	node = (int *)malloc(sizeof(int) * context.nodeSize);
+
+	if (context.firstSolution == NULL || context.queues == NULL || context.nogoods == NULL || lines == NULL || node == NULL)
+	{
+		free(node);
+		goto search_Free;
+	}
+
+	for (initialised = 0; initialised < context.queueCount; ++initialised)
+		pthread_mutex_init(&context.queues[initialised].lock, NULL);
+
+	/* The root: the gameboard and its lines' unsolved counts, then the lines to probe */
+	memcpy(node, puzzle->gameBoard, sizeof(int) * context.cellCount);
+	memset(node + context.cellCount, 0x00, sizeof(int) * lineCount);
+
+	for (cell = 0; cell < context.cellCount; ++cell)
+		if (node[cell] == -1)
+		{
+			++node[context.cellCount + cell / puzzle->width];
+			++node[context.cellCount + puzzle->length + cell % puzzle->width];
+		}
+
+	for (i = 0; cells != NULL && i < cellCount; ++i)
+	{
+		lines[cells[i] / puzzle->width] = 1;
+		lines[puzzle->length + cells[i] % puzzle->width] = 1;
+	}
+
+	for (i = 0; i < lineCount; ++i)
+		if (cells == NULL || lines[i] != 0)
+			lines[context.lineTotal++] = i;
+
+	context.lines = lines;
+
+	if (!pushNode(&context.queues[0], node))
+	{
+		free(node);
+		goto search_Free;
+	}
+
+	atomic_store(&context.pendingNodes, 1);
+
+	runParallel(searchWorker, &context, context.queueCount);
+
+	if (atomic_load(&context.outOfMemory))
+		goto search_Free;
+
+	/* Limits only count when they cut the search short of its solution limit */
+	if (atomic_load(&context.limitStatus) != SOLVE_IN_PROGRESS
+		&& (solutionLimit == 0 || atomic_load(&context.solutionCount) < solutionLimit))
+		status = (SolveStatus)atomic_load(&context.limitStatus);
+
+	else if (atomic_load(&context.solutionCount) == 0)
+		status = SOLVE_UNSATISFIABLE;
+
+	else
+	{
+		if (cells == NULL)
+			memcpy(puzzle->gameBoard, context.firstSolution, sizeof(int) * context.cellCount);
+
+		else
+			for (i = 0; i < cellCount; ++i)
+				puzzle->gameBoard[cells[i]] = context.firstSolution[cells[i]];
+
+		status = SOLVE_SOLVED;
+	}
+
+search_Free:
+	if (solutionCount != NULL)
+		*solutionCount = atomic_load(&context.solutionCount);
+
+	/* Nodes left behind by a stopped search */
+	for (i = 0; i < initialised; ++i)
+	{
+		while ((node = takeNode(&context.queues[i], TRUE)) != NULL)
+			free(node);
+
+		free(context.queues[i].nodes);
+		pthread_mutex_destroy(&context.queues[i].lock);
+	}
+
+	free(context.queues);
+	context.queues = NULL;
+
+	free(context.firstSolution);
+	context.firstSolution = NULL;
+
+	for (i = 0; context.nogoods != NULL && i < context.cellCount * 2; ++i)
+		while ((nogood = atomic_load(&context.nogoods[i])) != NULL)
+		{
+			atomic_store(&context.nogoods[i], nogood->next);
+			free(nogood);
+		}
+
+	free((void *)context.nogoods);
+	context.nogoods = NULL;
+
+	free(lines);
+	lines = NULL;
+
+	pthread_mutex_destroy(&context.resultLock);
+
+	return status;
+}
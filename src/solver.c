@@ -1,8 +1,28 @@
 #include "../include/solver.h"
 #include "../include/utility.h"
+#include "../include/parallel.h"
+#include "../include/puzzle.h"
+#include "../include/patternTable.h"
+#include "../include/spill.h"
 #include <stdlib.h>
 #include <stdio.h>
 
+/* Lines with fewer unconstrained placements than this are enumerated on one thread */
+#define PARALLEL_PERMUTATION_THRESHOLD 65536
+
+/* Minimum number of BitSet words handed to each thread when splitting by word range */
+#define PARALLEL_MIN_WORDS 1024
+
+/* Shared state for the parallel per-line passes. Each task only writes its own
+	slot of counts/offsets or its own word range of the line's arrays. */
+typedef struct LineJob {
+	Line * line;
+	int * counts;
+	int * offsets;
+	int wordsPerTask;
+	uint64_t newBits;
+} LineJob;
+
 /*
  * Creates and initializes a new Line struct.
  *
@@ -12,8 +32,10 @@
  * - lineId: The line’s unique identifier (row or column index)
  *
  * Returns a pointer to the initialized Line. The following fields are set:
- * - maskBits, partialBits, permutationCount, storeCount → all start at 0
- * - bitSet and permutations → NULL (to be set during generation)
+ * - maskBits, partialBits, appliedMaskBits, permutationCount, storeCount, liveCount → all start at 0
+ * - bitSet, permutations, cellWords, cellCounts and spill → NULL (to be set during generation)
+ * - guard → NULL (enumeration runs to completion)
+ * - sharedPermutations → FALSE (TRUE once permutations point into the pattern table)
  *
  * The caller is responsible for allocating permutations and bitSet later.
  */
@@ -28,14 +50,49 @@ Line * createLine (LineClue * clues, int size, int lineId)
 	line->clueSet 			= clues;
 	line->permutationCount 	= 0;
 	line->storeCount		= 0;
+	line->liveCount			= 0;
 	line->maskBits 			= 0ULL;
 	line->partialBits 		= 0ULL;
+	line->appliedMaskBits 	= 0ULL;
 	line->bitSet 			= NULL;
 	line->permutations 		= NULL;
+	line->sharedPermutations = FALSE;
+	line->cellWords 		= NULL;
+	line->cellCounts 		= NULL;
+	line->spill 			= NULL;
+	line->guard 			= NULL;
 
 	return line;
 }
 
+/* Stored or counted permutations between two looks at a guard's cancel flag and deadline */
+#define GUARD_POLL_MASK 0x3FFF
+
+/*
+ * Returns TRUE once the guard has stopped enumeration: its stop flag is raised, or the
+ * cancel flag or deadline it watches has fired, which raises the flag.
+ */
+bool checkEnumerationGuard (EnumerationGuard * guard)
+{
+	if (atomic_load(&guard->stop))
+		return TRUE;
+
+	if ((guard->cancel != NULL && atomic_load(guard->cancel))
+		|| (guard->deadline > 0 && monotonicNanos() >= guard->deadline))
+	{
+		atomic_store(&guard->stop, TRUE);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* TRUE when the line's guard has stopped its enumeration */
+static bool enumerationStopped (Line * line)
+{
+	return line->guard != NULL && atomic_load_explicit(&line->guard->stop, memory_order_relaxed);
+}
+
 /*
  * Recursively generates all valid permutations of a line that are consistent with
  * the current maskBits and partialBits.
@@ -49,6 +106,8 @@ Line * createLine (LineClue * clues, int size, int lineId)
  * - permCount: Pointer to either count or index for storing
  *
  * Early-prunes branches that conflict with known solved cells using bitmask checks.
+ * A line with a guard polls it and abandons the generation once it is stopped, leaving
+ * the count or store short.
  */
 void generatePermutations (Line * line, int clueIndex, uint64_t current, int position, bool countOnly, int * permCount)
 {
@@ -66,11 +125,17 @@ void generatePermutations (Line * line, int clueIndex, uint64_t current, int pos
 
 			else
 				line->permutations[(*permCount)++] = current;
+
+			if (line->guard != NULL && (*permCount & GUARD_POLL_MASK) == 0)
+				checkEnumerationGuard(line->guard);
 		}
 
 		return;
 	}
-	
+
+	if (enumerationStopped(line))
+		return;
+
 	groupSize = line->clueSet->clues[clueIndex];
 	maxStart = line->size - totalRemainingLength(line, clueIndex);
 
@@ -82,7 +147,7 @@ void generatePermutations (Line * line, int clueIndex, uint64_t current, int pos
 
 		newPosition = start + groupSize + 1;
 
-		writtenBitsMask = (1ULL << newPosition) - 1ULL;
+		writtenBitsMask = (newPosition >= 64) ? ~0ULL : (1ULL << newPosition) - 1ULL;
 
 		/* Setting the bits within the range of the current partial permutation that are also solved
 			on the gameboard. */
@@ -144,71 +209,581 @@ void updateBitMasks (Line * line, const int * partialSolution)
 	return;
 }
 
+/*
+ * Places the first clue at the given start and applies the same early pruning test as
+ * generatePermutations(). Returns FALSE if that placement conflicts with solved cells.
+ */
+static bool placeFirstBlock (Line * line, int start, uint64_t * bits)
+{
+	int groupSize = line->clueSet->clues[0];
+	uint64_t writtenBitsMask = (start + groupSize + 1 >= 64) ? ~0ULL : (1ULL << (start + groupSize + 1)) - 1ULL;
+	uint64_t compareMask = writtenBitsMask & line->maskBits;
+
+	*bits = ((1ULL << groupSize) - 1ULL) << start;
+
+	return ((*bits & compareMask) ^ (line->partialBits & compareMask)) == 0;
+}
+
+/* Task: counts the permutations whose first block starts at the task index */
+static void countFromStart (void * context, int start)
+{
+	LineJob * job = (LineJob *)context;
+	uint64_t bits;
+
+	if (placeFirstBlock(job->line, start, &bits))
+		generatePermutations(job->line, 1, bits, start + job->line->clueSet->clues[0] + 1, TRUE, &(job->counts[start]));
+
+	return;
+}
+
+/* Task: stores the permutations whose first block starts at the task index into the
+	range reserved for that start by the prefix sum of the counts */
+static void storeFromStart (void * context, int start)
+{
+	LineJob * job = (LineJob *)context;
+	int index = job->offsets[start];
+	uint64_t bits;
+
+	if (job->counts[start] > 0 && placeFirstBlock(job->line, start, &bits))
+		generatePermutations(job->line, 1, bits, start + job->line->clueSet->clues[0] + 1, FALSE, &index);
+
+	return;
+}
+
+/*
+ * Upper bound on the number of placements of a line ignoring solved cells,
+ * C(free + clueCount, clueCount). Only used to decide whether a line is worth splitting
+ * across threads, so a double is precise enough.
+ */
+static double estimatePlacements (Line * line)
+{
+	int i, clueCount = line->clueSet->clueCount;
+	int freeCells = line->size - minRequiredLength(line);
+	double estimate = 1.0;
+
+	for (i = 1; i <= clueCount; ++i)
+		estimate = estimate * (freeCells + i) / i;
+
+	return estimate;
+}
+
+/*
+ * Generates a line's permutations across threads, one task per start position of the
+ * first block. A counting pass sizes each start's share, a prefix sum turns the shares
+ * into disjoint ranges of the permutation array, and a storing pass fills them, so the
+ * result is in the same order as the single threaded generation.
+ *
+ * Returns FALSE if any allocation fails or the line's guard stopped the generation.
+ */
+static bool enumerateParallel (Line * line)
+{
+	int start, total = 0;
+	int startCount = line->size - totalRemainingLength(line, 0) + 1;
+	LineJob job;
+
+	job.line = line;
+	job.counts = (int *)calloc(startCount, sizeof(int));
+	job.offsets = (int *)malloc(sizeof(int) * startCount);
+
+	if (job.counts == NULL || job.offsets == NULL)
+	{
+		free(job.counts);
+		free(job.offsets);
+		return FALSE;
+	}
+
+	runParallel(countFromStart, &job, startCount);
+
+	if (enumerationStopped(line))
+	{
+		free(job.counts);
+		free(job.offsets);
+		return FALSE;
+	}
+
+	for (start = 0; start < startCount; ++start)
+	{
+		job.offsets[start] = total;
+		total += job.counts[start];
+	}
+
+	line->permutationCount = total;
+	line->permutations = (total == 0) ? NULL : (uint64_t *)malloc(sizeof(uint64_t) * total);
+
+	if (line->permutations != NULL)
+	{
+		runParallel(storeFromStart, &job, startCount);
+		line->storeCount = total;
+	}
+
+	free(job.counts);
+	free(job.offsets);
+
+	if (enumerationStopped(line))
+		return FALSE;
+
+	return total == 0 || line->permutations != NULL;
+}
+
+/*
+ * Counts, allocates and stores every permutation of the line that is consistent with
+ * the current maskBits and partialBits, then builds the per-cell index over them.
+ *
+ * Lines of up to PATTERN_TABLE_MAX_SIZE cells take their placements from the shared
+ * pattern table (see lookupPatterns()) instead of generating them: a line with no solved
+ * cell points at the table's placements, any other copies the consistent ones.
+ *
+ * Lines with a large number of possible placements are generated across threads (see
+ * enumerateParallel()) so that one giant line does not serialise the solve.
+ *
+ * The solved state used during generation is recorded in appliedMaskBits since every
+ * stored permutation already agrees with it.
+ *
+ * Returns FALSE if any allocation fails or the line's guard (see checkEnumerationGuard())
+ * stopped the enumeration. Partially allocated members are left on the Line for
+ * freeLine() to release. A line with no consistent permutation returns TRUE
+ * with permutationCount 0 and nothing allocated.
+ */
+bool enumeratePermutations (Line * line)
+{
+	int i, patternCount = 0;
+	const uint64_t * patterns = NULL;
+
+	if (lookupPatterns(line->clueSet->clues, line->clueSet->clueCount, line->size, &patterns, &patternCount))
+	{
+		/* With no cell solved every placement is consistent: share the table's */
+		if (line->maskBits == 0ULL)
+		{
+			line->permutations = (uint64_t *)patterns;
+			line->sharedPermutations = TRUE;
+			line->permutationCount = line->storeCount = patternCount;
+		}
+
+		else
+		{
+			for (i = 0; i < patternCount; ++i)
+				if (((patterns[i] ^ line->partialBits) & line->maskBits) == 0ULL)
+					++line->permutationCount;
+
+			if (line->permutationCount == 0)
+				return TRUE;
+
+			line->permutations = (uint64_t *)malloc(sizeof(uint64_t) * line->permutationCount);
+			if (line->permutations == NULL)
+				return FALSE;
+
+			for (i = 0; i < patternCount; ++i)
+				if (((patterns[i] ^ line->partialBits) & line->maskBits) == 0ULL)
+					line->permutations[line->storeCount++] = patterns[i];
+		}
+	}
+
+	else if (getWorkerCount() > 1 && line->clueSet->clueCount > 0
+		&& estimatePlacements(line) >= PARALLEL_PERMUTATION_THRESHOLD)
+	{
+		if (!enumerateParallel(line))
+			return FALSE;
+	}
+
+	else
+	{
+		generatePermutations(line, 0, 0ULL, 0, TRUE, &(line->permutationCount));
+
+		if (enumerationStopped(line))
+			return FALSE;
+
+		if (line->permutationCount == 0)
+			return TRUE;
+
+		line->permutations = (uint64_t *)malloc(sizeof(uint64_t) * line->permutationCount);
+		if (line->permutations == NULL)
+			return FALSE;
+
+		generatePermutations(line, 0, 0ULL, 0, FALSE, &(line->storeCount));
+
+		if (enumerationStopped(line))
+			return FALSE;
+	}
+
+	/* No permutation fits the solved cells, the caller treats this as a contradiction */
+	if (line->permutationCount == 0)
+		return TRUE;
+
+	line->bitSet = newBitSet(line->permutationCount);
+	if (line->bitSet == NULL)
+		return FALSE;
+
+	line->appliedMaskBits = line->maskBits;
+
+	return buildCellIndex(line);
+}
+
+/*
+ * Number of tasks to split a pass over wordCount BitSet words into, 1 when the line is
+ * too small for threads to pay off.
+ */
+static int wordRangeTasks (int wordCount)
+{
+	int tasks = wordCount / PARALLEL_MIN_WORDS;
+	int maxTasks = getWorkerCount() * 4;
+
+	if (getWorkerCount() == 1 || tasks < 2)
+		return 1;
+
+	return (tasks > maxTasks) ? maxTasks : tasks;
+}
+
+/*
+ * Transposes a 64x64 bit matrix in place so that bit i of block[j] ends up as
+ * bit j of block[i]. Swaps progressively smaller sub-blocks (32, 16, ..., 1).
+ */
+static void transposeBlock (uint64_t * block)
+{
+	int j, k;
+	uint64_t m, t;
+
+	for (j = 32, m = 0x00000000FFFFFFFFULL; j != 0; j >>= 1, m ^= m << j)
+		for (k = 0; k < 64; k = ((k | j) + 1) & ~j)
+		{
+			t = (block[k] ^ (block[k | j] << j)) & ~m;
+			block[k] ^= t;
+			block[k | j] ^= t >> j;
+		}
+
+	return;
+}
+
+/*
+ * Indexes the permutations in BitSet words [begin, end), adding each cell's fill
+ * count for that range to counts.
+ *
+ * Each group of 64 permutations is one 64x64 bit matrix, transposing it yields one
+ * index word per cell. Padding past storeCount stays 0.
+ */
+static void indexWordRange (Line * line, int begin, int end, int * counts)
+{
+	int i, word, cell, last;
+	const int wordCount = line->bitSet->wordCount;
+	const int size = line->size;
+	uint64_t * const perms = line->permutations;
+	uint64_t * const cellWords = line->cellWords;
+	uint64_t block[64];
+
+	for (word = begin; word < end; ++word)
+	{
+		last = line->storeCount - (word << 6);
+		if (last > 64)
+			last = 64;
+
+		for (i = 0; i < last; ++i)
+			block[i] = perms[(word << 6) + i];
+
+		for ( ; i < 64; ++i)
+			block[i] = 0ULL;
+
+		transposeBlock(block);
+
+		for (cell = 0; cell < size; ++cell)
+		{
+			cellWords[(size_t)cell * wordCount + word] = block[cell];
+			counts[cell] += __builtin_popcountll(block[cell]);
+		}
+	}
+
+	return;
+}
+
+/* Task: indexes one word range into that task's own row of counts */
+static void indexTask (void * context, int task)
+{
+	LineJob * job = (LineJob *)context;
+	int begin = task * job->wordsPerTask;
+	int end = begin + job->wordsPerTask;
+
+	if (end > job->line->bitSet->wordCount)
+		end = job->line->bitSet->wordCount;
+
+	indexWordRange(job->line, begin, end, job->counts + task * job->line->size);
+
+	return;
+}
+
+/*
+ * Builds the per-cell permutation index for a line.
+ *
+ * For every cell j, a run of bitSet->wordCount words starting at cellWords + j * wordCount
+ * holds a 1 at bit i when permutation i has cell j filled. Learning that a cell is filled
+ * or empty then becomes a single word-wise AND or ANDNOT of that run into the live BitSet.
+ *
+ * Also seeds cellCounts (live permutations with each cell filled) and liveCount, which
+ * filterPermutations() keeps current as permutations are removed. Large lines are indexed
+ * across threads by word range.
+ *
+ * Returns FALSE if the index could not be allocated.
+ */
+bool buildCellIndex (Line * line)
+{
+	int task, cell;
+	const int wordCount = line->bitSet->wordCount;
+	const int size = line->size;
+	const int tasks = wordRangeTasks(wordCount);
+	LineJob job;
+
+	line->cellWords = (uint64_t *)malloc(sizeof(uint64_t) * (size_t)wordCount * size);
+	if (line->cellWords == NULL)
+		return FALSE;
+
+	line->cellCounts = (int *)calloc(size, sizeof(int));
+	if (line->cellCounts == NULL)
+		return FALSE;
+
+	line->liveCount = line->storeCount;
+
+	if (tasks == 1)
+	{
+		indexWordRange(line, 0, wordCount, line->cellCounts);
+		return TRUE;
+	}
+
+	job.line = line;
+	job.wordsPerTask = (wordCount + tasks - 1) / tasks;
+	job.counts = (int *)calloc((size_t)tasks * size, sizeof(int));
+
+	if (job.counts == NULL)
+	{
+		indexWordRange(line, 0, wordCount, line->cellCounts);
+		return TRUE;
+	}
+
+	runParallel(indexTask, &job, tasks);
+
+	for (task = 0; task < tasks; ++task)
+		for (cell = 0; cell < size; ++cell)
+			line->cellCounts[cell] += job.counts[task * size + cell];
+
+	free(job.counts);
+
+	return TRUE;
+}
+
+/*
+ * Applies the cells in newBits to BitSet words [begin, end) and subtracts the removed
+ * permutations from counts. Returns the number of permutations removed.
+ */
+static int filterWordRange (Line * line, int begin, int end, uint64_t newBits, int * counts)
+{
+	int word, cell, removedCount = 0;
+	const int size 			= line->size;
+	const int wordCount		= line->bitSet->wordCount;
+	const uint64_t partial 	= line->partialBits;
+	uint64_t * const words 	= line->bitSet->words;
+	const uint64_t * const cellWords = line->cellWords;
+	uint64_t live, removed, bits;
+
+	for (word = begin; word < end; ++word)
+	{
+		live = words[word];
+
+		for (bits = newBits; bits != 0 && live != 0; bits &= bits - 1)
+		{
+			cell = __builtin_ctzll(bits);
+
+			if ((partial >> cell) & 1ULL)
+				live &= cellWords[(size_t)cell * wordCount + word];
+			else
+				live &= ~cellWords[(size_t)cell * wordCount + word];
+		}
+
+		removed = words[word] & ~live;
+		if (removed == 0)
+			continue;
+
+		words[word] = live;
+		removedCount += __builtin_popcountll(removed);
+
+		for (cell = 0; cell < size; ++cell)
+			counts[cell] -= __builtin_popcountll(removed & cellWords[(size_t)cell * wordCount + word]);
+	}
+
+	return removedCount;
+}
+
+/* Task: filters one word range, collecting count changes in that task's own row of
+	counts and the removed total in its last slot */
+static void filterTask (void * context, int task)
+{
+	LineJob * job = (LineJob *)context;
+	int * counts = job->counts + task * (job->line->size + 1);
+	int begin = task * job->wordsPerTask;
+	int end = begin + job->wordsPerTask;
+
+	if (end > job->line->bitSet->wordCount)
+		end = job->line->bitSet->wordCount;
+
+	counts[job->line->size] = filterWordRange(job->line, begin, end, job->newBits, counts);
+
+	return;
+}
+
 /*
  * Filters out any stored permutations that are inconsistent with the current
  * maskBits and partialBits.
  *
- * For each valid (set) permutation:
- * - If its bits don’t match the solved state (mask & partial), the corresponding
- *   bit is cleared in the BitSet.
+ * Only cells solved since the last visit (maskBits not yet in appliedMaskBits) are
+ * applied, each one as a word-wise AND (filled) or ANDNOT (empty) of that cell's
+ * index into the BitSet, so the cost follows the new information rather than the
+ * number of live permutations.
+ *
+ * Every word that loses permutations also has the removed ones taken off cellCounts
+ * and liveCount through a popcount against each cell's index word. Large lines are
+ * filtered across threads by word range, each thread keeping its own count changes.
+ *
+ * Returns FALSE if no permutation survives, i.e. the solved cells contradict the line.
  */
-void filterPermutations (Line * line)
+bool filterPermutations (Line * line)
 {
-	int i;
-	uint64_t * const perms 	= line->permutations;
-	const uint64_t 	mask 	= line->maskBits;
-	const uint64_t 	partial = line->partialBits;
-	BitSet * const 	bSet 	= line->bitSet;
+	int task, cell;
+	const int size 			= line->size;
+	const int wordCount		= line->bitSet->wordCount;
+	const int tasks 		= wordRangeTasks(wordCount);
+	const uint64_t newBits 	= line->maskBits & ~(line->appliedMaskBits);
+	LineJob job;
+
+	if (newBits == 0)
+		return line->liveCount > 0;
+
+	line->appliedMaskBits = line->maskBits;
+
+	job.counts = (tasks == 1) ? NULL : (int *)calloc((size_t)tasks * (size + 1), sizeof(int));
 
-	if (mask != 0)
+	if (job.counts == NULL)
 	{
-		for (i = nextSetBit(bSet, 0); i >= 0; i = nextSetBit(bSet, i + 1))
-			if (((perms[i] & mask) ^ partial) != 0)
-				clearBit(bSet, i);
+		line->liveCount -= filterWordRange(line, 0, wordCount, newBits, line->cellCounts);
+		return line->liveCount > 0;
 	}
+
+	job.line = line;
+	job.newBits = newBits;
+	job.wordsPerTask = (wordCount + tasks - 1) / tasks;
+
+	runParallel(filterTask, &job, tasks);
+
+	for (task = 0; task < tasks; ++task)
+	{
+		for (cell = 0; cell < size; ++cell)
+			line->cellCounts[cell] += job.counts[task * (size + 1) + cell];
+
+		line->liveCount -= job.counts[task * (size + 1) + size];
+	}
+
+	free(job.counts);
 					
-	return;
+	return line->liveCount > 0;
 }
 
 /*
- * Identifies bits that are consistent across all remaining valid permutations.
+ * Identifies cells that are consistent across all remaining valid permutations.
+ *
+ * For any unsolved cell:
+ * - If its fill count equals liveCount → every permutation has it filled
+ * - If its fill count is 0 → every permutation has it empty
  *
- * For any bit position:
- * - If all permutations agree on 1 → mark it as a solved filled cell
- * - If all permutations agree on 0 → mark it as a solved empty cell
+ * Updates the Line’s maskBits and partialBits with this information. Runs in O(size)
+ * since the counts are maintained by filterPermutations().
  *
- * Updates the Line’s maskBits and partialBits with this information.
+ * Returns FALSE, leaving the masks untouched, if no permutation is left.
  */
-void generateConsistentPattern (Line * line)
+bool generateConsistentPattern (Line * line)
 {
-	int i;
-	BitSet * const bSet		= line->bitSet;
-	uint64_t * const perms 	= line->permutations;
-	uint64_t widthMask 		= (1ULL << line->size) - 1ULL;
-	uint64_t andMask 		= widthMask;
-	uint64_t orMask 		= 0ULL;
+	int cell;
+	const int liveCount		= line->liveCount;
+	const int * const counts = line->cellCounts;
+	uint64_t widthMask 		= (line->size == 64) ? ~0ULL : (1ULL << line->size) - 1ULL;
 	uint64_t unsolved 		= ~(line->maskBits) & widthMask;
-	uint64_t solved1s, solved0s;
+	uint64_t solved1s = 0ULL, solved0s = 0ULL;
 
-	/* Looping through all valid permutations using the andMask to track which bits are always 1s
-		in every permutation and the orMask for 0s. Breaks early if there are no bits that are always
-		1 or 0 through all permutations */
-	for (i = nextSetBit(bSet, 0); i >= 0; i = nextSetBit(bSet, i + 1))
+	if (liveCount == 0)
+		return FALSE;
+
+	for ( ; unsolved != 0; unsolved &= unsolved - 1)
 	{
-		andMask &= perms[i];
-		orMask |= perms[i];
+		cell = __builtin_ctzll(unsolved);
 
-		if (((andMask & unsolved) | (~orMask & unsolved)) == 0)
-			break;
-	}
+		if (counts[cell] == 0)
+			solved0s |= 1ULL << cell;
 
-	solved1s = andMask & unsolved;
-	solved0s = ~orMask & unsolved;
+		else if (counts[cell] == liveCount)
+			solved1s |= 1ULL << cell;
+	}
 
 	line->maskBits |= (solved1s | solved0s);
 	line->partialBits |= solved1s;
 	
-	return;
+	return TRUE;
+}
+
+/*
+ * Computes the consensus of a line for a hypothetical set of solved cells without
+ * modifying the line, as needed when probing or searching on a copy of the gameboard.
+ *
+ * maskBits/partialBits must include the line's own applied solved cells. Enumerated
+ * lines narrow their live permutations through the per-cell index one BitSet word at
+ * a time and fold the survivors into AND/OR masks, stopping early once no cell can be
+ * agreed on. Lines that were never enumerated fall back to solveLinePlacements().
+ *
+ * On success the cells all remaining permutations agree on are added to maskBits and
+ * partialBits. Returns FALSE if no permutation fits the given solved cells.
+ */
+bool solveLineState (Line * line, uint64_t * maskBits, uint64_t * partialBits)
+{
+	int word, cell, i;
+	const uint64_t mask 	= *maskBits;
+	const uint64_t partial 	= *partialBits;
+	const uint64_t newBits 	= mask & ~(line->appliedMaskBits);
+	uint64_t widthMask 		= (line->size == 64) ? ~0ULL : (1ULL << line->size) - 1ULL;
+	uint64_t unsolved 		= ~mask & widthMask;
+	uint64_t andMask = widthMask, orMask = 0ULL, live, bits;
+	bool found = FALSE;
+	int wordCount;
+
+	if (line->bitSet == NULL)
+		return solveLinePlacements(line, maskBits, partialBits);
+
+	wordCount = line->bitSet->wordCount;
+
+	for (word = 0; word < wordCount; ++word)
+	{
+		live = line->bitSet->words[word];
+
+		for (bits = newBits; bits != 0 && live != 0; bits &= bits - 1)
+		{
+			cell = __builtin_ctzll(bits);
+
+			if ((partial >> cell) & 1ULL)
+				live &= line->cellWords[(size_t)cell * wordCount + word];
+			else
+				live &= ~line->cellWords[(size_t)cell * wordCount + word];
+		}
+
+		for ( ; live != 0; live &= live - 1)
+		{
+			i = (word << 6) + __builtin_ctzll(live);
+			andMask &= line->permutations[i];
+			orMask |= line->permutations[i];
+			found = TRUE;
+		}
+
+		if (found && ((andMask & unsolved) | (~orMask & unsolved)) == 0)
+			return TRUE;
+	}
+
+	if (!found)
+		return FALSE;
+
+	*maskBits |= (andMask | ~orMask) & unsolved;
+	*partialBits |= andMask & unsolved;
+
+	return TRUE;
 }
 
 /*
@@ -237,8 +812,7 @@ int minRequiredLength (Line * line)
  * - Determines the guaranteed overlap between all possible placements
  * - Updates maskBits and partialBits for cells that are always filled
  *
- * TODO: Currently uses minRequiredLength; future improvements may consider
- *       clue gaps or solved cells for more advanced deductions.
+ * Ignores solved cells, see applyLineRules() for the deduction that accounts for them.
  */
 void overlap (Line * line)
 {
@@ -266,3 +840,484 @@ void overlap (Line * line)
 	}
 	return;
 }
+
+/*
+ * Returns a mask of cells [from, to), safe for ranges that reach bit 63.
+ */
+static uint64_t cellRange (int from, int to)
+{
+	uint64_t upper = (to >= 64) ? ~0ULL : (1ULL << to) - 1ULL;
+	uint64_t lower = (from >= 64) ? ~0ULL : (1ULL << from) - 1ULL;
+
+	return (from >= to) ? 0ULL : upper & ~lower;
+}
+
+/*
+ * Fills fits[i][p], which records whether clues i.. can still be placed in cells p..
+ * without covering a known blank or leaving a known filled cell uncovered.
+ *
+ * The table is built right to left, a clue either starts at p or p is left blank, which
+ * keeps it at O(clues * size). Column size + 1 stands for "past the end of the line".
+ */
+static void buildFitTable (int size, const int * clues, int clueCount, uint64_t filled, uint64_t blank, bool fits[][MAX_LINE_SIZE + 2])
+{
+	int i, p, end, next;
+
+	for (p = size + 1; p >= 0; --p)
+		fits[clueCount][p] = (cellRange(p, size) & filled) == 0;
+
+	for (i = clueCount - 1; i >= 0; --i)
+	{
+		fits[i][size + 1] = FALSE;
+
+		for (p = size; p >= 0; --p)
+		{
+			end = p + clues[i];
+			next = (end + 1 > size + 1) ? size + 1 : end + 1;
+
+			/* Clue i starts at p: inside the line, over no blank and not directly followed
+				by a filled cell */
+			fits[i][p] = end <= size && (cellRange(p, end) & blank) == 0
+				&& (end == size || ((filled >> end) & 1ULL) == 0) && fits[i + 1][next];
+
+			/* Or cell p stays empty and clue i starts further right */
+			if (!fits[i][p] && p < size && ((filled >> p) & 1ULL) == 0)
+				fits[i][p] = fits[i][p + 1];
+		}
+	}
+
+	return;
+}
+
+/*
+ * Finds the leftmost placement of every clue that agrees with the known filled and
+ * blank cells, writing each clue's start to starts[].
+ *
+ * Placements are taken greedily from the left over buildFitTable(), only accepting a
+ * start whose remainder fits.
+ *
+ * Returns FALSE if no placement exists.
+ */
+static bool leftmostStarts (int size, const int * clues, int clueCount, uint64_t filled, uint64_t blank, int * starts)
+{
+	bool fits[MAX_CLUES + 1][MAX_LINE_SIZE + 2];
+	int i, p, end, next;
+
+	buildFitTable(size, clues, clueCount, filled, blank, fits);
+
+	if (!fits[0][0])
+		return FALSE;
+
+	for (i = 0, p = 0; i < clueCount; ++i)
+	{
+		for ( ; ; ++p)
+		{
+			end = p + clues[i];
+			next = (end + 1 > size + 1) ? size + 1 : end + 1;
+
+			if (end <= size && (cellRange(p, end) & blank) == 0
+				&& (end == size || ((filled >> end) & 1ULL) == 0) && fits[i + 1][next])
+				break;
+		}
+
+		starts[i] = p;
+		p = end + 1;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Reverses the order of the lowest size bits.
+ */
+static uint64_t reverseCells (uint64_t bits, int size)
+{
+	uint64_t reversed = 0ULL;
+	int i;
+
+	for (i = 0; i < size; ++i, bits >>= 1)
+		reversed = (reversed << 1) | (bits & 1ULL);
+
+	return reversed;
+}
+
+/*
+ * Rule based line deduction that accounts for the line's solved cells, cheap enough to
+ * run on every line before its permutations are first generated.
+ *
+ * Computes the leftmost and rightmost placement of every clue that respects the known
+ * filled and blank cells (so known cells force clues away from or onto the edges and
+ * known blanks split the line), then:
+ * - Cells covered by a clue in both its leftmost and rightmost placement are filled
+ *   (this is overlap() generalised, and fills full lines entirely)
+ * - Cells outside the reach of every clue are blank (this also clears empty lines)
+ *
+ * Updates the Line’s maskBits and partialBits.
+ *
+ * Returns FALSE if no placement agrees with the solved cells.
+ */
+bool applyLineRules (Line * line)
+{
+	int i, end;
+	int leftStarts[MAX_CLUES], rightStarts[MAX_CLUES], reversedClues[MAX_CLUES] = {0};
+	const int size = line->size;
+	const int clueCount = line->clueSet->clueCount;
+	const int * clues = line->clueSet->clues;
+	uint64_t filled = line->partialBits & line->maskBits;
+	uint64_t blank = line->maskBits & ~line->partialBits;
+	uint64_t reach = 0ULL, solved1s = 0ULL;
+
+	if (!leftmostStarts(size, clues, clueCount, filled, blank, leftStarts))
+		return FALSE;
+
+	/* The rightmost placement is the leftmost placement of the mirrored line */
+	for (i = 0; i < clueCount; ++i)
+		reversedClues[i] = clues[clueCount - 1 - i];
+
+	leftmostStarts(size, reversedClues, clueCount, reverseCells(filled, size), reverseCells(blank, size), rightStarts);
+
+	for (i = 0; i < clueCount; ++i)
+	{
+		end = size - rightStarts[clueCount - 1 - i];
+
+		solved1s |= cellRange(end - clues[i], leftStarts[i] + clues[i]);
+		reach |= cellRange(leftStarts[i], end);
+	}
+
+	line->maskBits |= solved1s | (~reach & cellRange(0, size));
+	line->partialBits |= solved1s;
+
+	return TRUE;
+}
+
+/*
+ * buildFitTable() with one row of the table packed into a word, bit p standing for cell
+ * p, for lines of up to 62 cells (so p = size + 1 still fits).
+ *
+ * A clue can start at the positions whose next clues[i] cells hold no blank, whose
+ * following cell is not filled and where the rest fits after the gap. Row i is then
+ * those starts spread towards the start of the line across cells that may stay empty,
+ * done in log steps over runs of such cells.
+ *
+ * Writes row i to rows[i] and returns fits[0][0]. Stops early (leaving the lower rows
+ * unset) once a row is empty.
+ */
+static bool fitsPacked (int size, const int * clues, int clueCount, uint64_t filled, uint64_t blank, uint64_t * rows)
+{
+	int i, j, shift;
+	const uint64_t open = ~filled & cellRange(0, size);
+	const uint64_t unblocked = ~blank & cellRange(0, size);
+	uint64_t fits, starts, run;
+
+	/* No clues left: the rest of the line must hold no filled cell */
+	fits = (filled == 0) ? cellRange(0, size + 2) : cellRange(64 - __builtin_clzll(filled), size + 2);
+	rows[clueCount] = fits;
+
+	for (i = clueCount - 1; i >= 0; --i)
+	{
+		starts = unblocked;
+		for (j = 1; j < clues[i] && starts != 0; ++j)
+			starts &= unblocked >> j;
+
+		starts &= ~(filled >> clues[i]) & (fits >> (clues[i] + 1));
+
+		fits = starts;
+		for (shift = 1, run = open; shift < 64 && run != 0; shift <<= 1)
+		{
+			fits |= (fits >> shift) & run;
+			run &= run >> shift;
+		}
+
+		rows[i] = fits;
+
+		if (fits == 0)
+			return FALSE;
+	}
+
+	return fits & 1ULL;
+}
+
+/*
+ * Returns TRUE if some placement of the line's clues agrees with the given solved cells,
+ * a single pass over the fits table and the cheapest complete check this file offers.
+ */
+bool isLineFeasible (Line * line, uint64_t maskBits, uint64_t partialBits)
+{
+	bool fits[MAX_CLUES + 1][MAX_LINE_SIZE + 2];
+	uint64_t rows[MAX_CLUES + 1];
+	const uint64_t filled = partialBits & maskBits;
+	const uint64_t blank = maskBits & ~partialBits;
+
+	if (line->size <= 62)
+		return fitsPacked(line->size, line->clueSet->clues, line->clueSet->clueCount, filled, blank, rows);
+
+	buildFitTable(line->size, line->clueSet->clues, line->clueSet->clueCount, filled, blank, fits);
+
+	return fits[0][0];
+}
+
+/*
+ * solveLinePlacements() over packed fits rows for lines of up to 62 cells, the same
+ * rules evaluated for every cell of a row at once.
+ */
+static bool placementsPacked (Line * line, uint64_t * maskBits, uint64_t * partialBits)
+{
+	uint64_t suffix[MAX_CLUES + 1], mirrored[MAX_CLUES + 1];
+	int i, j, reversedClues[MAX_CLUES] = {0};
+	const int size = line->size;
+	const int clueCount = line->clueSet->clueCount;
+	const int * clues = line->clueSet->clues;
+	const uint64_t widthMask = cellRange(0, size);
+	const uint64_t filled = *partialBits & *maskBits;
+	const uint64_t blank = *maskBits & ~*partialBits;
+	const uint64_t unblocked = ~blank & widthMask;
+	uint64_t canFill = 0ULL, canBlank = 0ULL, prefix, starts;
+
+	if (!fitsPacked(size, clues, clueCount, filled, blank, suffix))
+		return FALSE;
+
+	for (i = 0; i < clueCount; ++i)
+		reversedClues[i] = clues[clueCount - 1 - i];
+
+	fitsPacked(size, reversedClues, clueCount, reverseCells(filled, size), reverseCells(blank, size), mirrored);
+
+	for (i = 0; i <= clueCount; ++i)
+	{
+		/* Bit q: clues ..i-1 fit in cells ..q-1 */
+		prefix = reverseCells(mirrored[clueCount - i], size + 1);
+
+		canBlank |= prefix & (suffix[i] >> 1) & ~filled & widthMask;
+
+		if (i == clueCount)
+			break;
+
+		starts = unblocked;
+		for (j = 1; j < clues[i]; ++j)
+			starts &= unblocked >> j;
+
+		starts &= ~(filled >> clues[i]) & (suffix[i + 1] >> (clues[i] + 1))
+			& (((prefix & ~filled) << 1) | ((i == 0) ? 1ULL : 0ULL));
+
+		for (j = 0; j < clues[i]; ++j)
+			canFill |= starts << j;
+	}
+
+	*maskBits |= (~canBlank | ~canFill) & widthMask;
+	*partialBits |= ~canBlank & widthMask;
+
+	return TRUE;
+}
+
+/*
+ * Complete line deduction from the clues and the given solved cells, without touching
+ * the line's permutations or masks.
+ *
+ * With suffix[i][p] (clues i.. fit in cells p..) from buildFitTable() and prefix[i][q]
+ * (clues ..i-1 fit in cells ..q-1) from the same table over the mirrored line:
+ * - Cell c can be blank when it is not known filled and prefix[i][c] and suffix[i][c + 1]
+ *   hold for some i
+ * - Clue i can start at s when its cells hold no blank, its neighbours are not filled,
+ *   and the clues before and after it fit around it
+ * Cells that cannot be blank are filled, cells no placement covers are blank. This is
+ * O(clues * size) and, unlike applyLineRules(), finds every cell the line forces.
+ *
+ * On success ORs the newly solved cells into maskBits and partialBits.
+ *
+ * Returns FALSE if no placement agrees with the solved cells.
+ */
+bool solveLinePlacements (Line * line, uint64_t * maskBits, uint64_t * partialBits)
+{
+	bool suffix[MAX_CLUES + 1][MAX_LINE_SIZE + 2], prefix[MAX_CLUES + 1][MAX_LINE_SIZE + 2];
+	int i, c, start, end, reversedClues[MAX_CLUES] = {0};
+	const int size = line->size;
+	const int clueCount = line->clueSet->clueCount;
+	const int * clues = line->clueSet->clues;
+	const uint64_t widthMask = cellRange(0, size);
+	uint64_t filled = *partialBits & *maskBits;
+	uint64_t blank = *maskBits & ~*partialBits;
+	uint64_t canFill = 0ULL, canBlank = 0ULL;
+
+	if (size <= 62)
+		return placementsPacked(line, maskBits, partialBits);
+
+	buildFitTable(size, clues, clueCount, filled, blank, suffix);
+
+	if (!suffix[0][0])
+		return FALSE;
+
+	for (i = 0; i < clueCount; ++i)
+		reversedClues[i] = clues[clueCount - 1 - i];
+
+	/* prefix[i][q] is mirrored[clueCount - i][size - q] */
+	buildFitTable(size, reversedClues, clueCount, reverseCells(filled, size), reverseCells(blank, size), prefix);
+
+	for (c = 0; c < size; ++c)
+	{
+		if ((filled >> c) & 1ULL)
+			continue;
+
+		for (i = 0; i <= clueCount; ++i)
+			if (prefix[clueCount - i][size - c] && suffix[i][c + 1])
+			{
+				canBlank |= 1ULL << c;
+				break;
+			}
+	}
+
+	for (i = 0; i < clueCount; ++i)
+		for (start = 0; start + clues[i] <= size; ++start)
+		{
+			end = start + clues[i];
+
+			if ((cellRange(start, end) & blank) != 0
+				|| (start > 0 && ((filled >> (start - 1)) & 1ULL))
+				|| (end < size && ((filled >> end) & 1ULL)))
+				continue;
+
+			/* Clues before fit in cells ..start-2, clues after in cells end+1.. */
+			if ((start == 0) ? (i != 0) : !prefix[clueCount - i][size - start + 1])
+				continue;
+
+			if (!suffix[i + 1][(end + 1 > size + 1) ? size + 1 : end + 1])
+				continue;
+
+			canFill |= cellRange(start, end);
+		}
+
+	*maskBits |= (~canBlank | ~canFill) & widthMask;
+	*partialBits |= ~canBlank & widthMask;
+
+	return TRUE;
+}
+
+/*
+ * Counts the placements of a line that agree with its solved cells (maskBits and
+ * partialBits) without generating any, so the cost of enumerating a line can be known
+ * up front.
+ *
+ * Same right to left recurrence as buildFitTable(), with counts in place of flags:
+ * ways[i][p] is the number of placements of clues i.. in cells p.. A double keeps the
+ * count meaningful far beyond anything that could be stored.
+ */
+double countPlacements (Line * line)
+{
+	double ways[MAX_CLUES + 1][MAX_LINE_SIZE + 2];
+	int i, p, end, next;
+	const int size = line->size;
+	const int clueCount = line->clueSet->clueCount;
+	const int * clues = line->clueSet->clues;
+	const uint64_t filled = line->partialBits & line->maskBits;
+	const uint64_t blank = line->maskBits & ~line->partialBits;
+
+	for (p = size + 1; p >= 0; --p)
+		ways[clueCount][p] = ((cellRange(p, size) & filled) == 0) ? 1.0 : 0.0;
+
+	for (i = clueCount - 1; i >= 0; --i)
+	{
+		ways[i][size + 1] = 0.0;
+
+		for (p = size; p >= 0; --p)
+		{
+			end = p + clues[i];
+			next = (end + 1 > size + 1) ? size + 1 : end + 1;
+			ways[i][p] = 0.0;
+
+			if (end <= size && (cellRange(p, end) & blank) == 0 && (end == size || ((filled >> end) & 1ULL) == 0))
+				ways[i][p] = ways[i + 1][next];
+
+			if (p < size && ((filled >> p) & 1ULL) == 0)
+				ways[i][p] += ways[i][p + 1];
+		}
+	}
+
+	return ways[0][0];
+}
+
+/*
+ * Returns TRUE if every cell of the line is solved.
+ */
+bool isLineSolved (Line * line)
+{
+	return line->maskBits == cellRange(0, line->size);
+}
+
+/*
+ * Moves an enumerated line's permutations, BitSet and cell index to another line with the
+ * same clues, leaving source with none. Used to adopt a copy enumerated elsewhere; the
+ * permutations were filtered against source's solved cells, filterPermutations() catches
+ * target up on the rest.
+ */
+void moveLinePermutations (Line * target, Line * source)
+{
+	target->permutations = source->permutations;
+	target->sharedPermutations = source->sharedPermutations;
+	target->bitSet = source->bitSet;
+	target->cellWords = source->cellWords;
+	target->cellCounts = source->cellCounts;
+	target->permutationCount = source->permutationCount;
+	target->storeCount = source->storeCount;
+	target->liveCount = source->liveCount;
+	target->appliedMaskBits = source->appliedMaskBits;
+
+	source->permutations = NULL;
+	source->bitSet = NULL;
+	source->cellWords = NULL;
+	source->cellCounts = NULL;
+	source->permutationCount = source->storeCount = source->liveCount = 0;
+
+	return;
+}
+
+/*
+ * Releases a line's permutations, BitSet, per-cell index, counts and spill file, leaving
+ * it as it was before enumeration (its solved cells are kept). Safe to call on lines that
+ * were never enumerated or only partially allocated.
+ */
+void clearLinePermutations (Line * line)
+{
+	if (line->bitSet != NULL)
+	{
+		free(line->bitSet->words);
+		line->bitSet->words = NULL;
+
+		free(line->bitSet);
+		line->bitSet = NULL;
+	}
+
+	/* Permutations taken from the pattern table belong to the table */
+	if (!line->sharedPermutations)
+		free(line->permutations);
+
+	line->permutations = NULL;
+	line->sharedPermutations = FALSE;
+
+	free(line->cellWords);
+	line->cellWords = NULL;
+
+	free(line->cellCounts);
+	line->cellCounts = NULL;
+
+	freeSpill(line->spill);
+	line->spill = NULL;
+
+	line->permutationCount = line->storeCount = line->liveCount = 0;
+	line->appliedMaskBits = 0ULL;
+
+	return;
+}
+
+/*
+ * Releases a Line along with its permutations, BitSet, per-cell index and counts.
+ *
+ * The clueSet is not owned by the Line and is left untouched. Safe to call on lines
+ * that were never enumerated or only partially allocated.
+ */
+void freeLine (Line * line)
+{
+	if (line == NULL) return;
+
+	clearLinePermutations(line);
+	free(line);
+
+	return;
+}
@@ -1,234 +1,723 @@
 #include "../include/solverAPI.h"
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "../include/fileIO.h"
 #include "../include/gameBoard.h"
-#include "../include/solver.h"
+#include "../include/puzzle.h"
+#include "../include/probe.h"
+#include "../include/cdcl.h"
+#include "../include/components.h"
+#include "../include/search.h"
+
+static atomic_int searchEngine = SEARCH_CDCL;
+static atomic_int boardFormat = BOARD_GRID;
+
+/* Where a step-wise solve (see stepSolve()) carries on */
+typedef enum SolveStage {
+	STAGE_RULES = 0,
+	STAGE_SWEEPS,
+	STAGE_PROBE,
+	STAGE_SEARCH
+} SolveStage;
+
+struct SolverContext {
+	SolveOptions options;
+	SearchEngine engine;
+	SolveResult result;
+	Puzzle * puzzle;      /* The step-wise solve in flight, NULL when none */
+	Cdcl * search;
+	SolveStage stage;
+	LineCache * lineCache; /* Shared with other contexts, see shareLineCache(); NULL for a cache per puzzle */
+};
 
 /*
- * Solves a Nonogram puzzle from a file input stream and returns the completed game board.
+ * Selects the search solvePuzzle() falls back to when line logic and probing stall:
+ * clause learning on one thread (the default) or the parallel guess tree search across
+ * getWorkerCount() threads.
+ */
+void setSearchEngine (SearchEngine engine)
+{
+	atomic_store(&searchEngine, engine);
+
+	return;
+}
+
+/*
+ * Selects how solvePuzzle() prints the board in mode 0 (see renderGameBoard()), the grid
+ * view by default.
+ */
+void setBoardFormat (BoardFormat format)
+{
+	atomic_store(&boardFormat, format);
+
+	return;
+}
+
+/*
+ * Validates a puzzle's clues and builds its solver state, taking ownership of lineClues.
+ * Lines are solved through lineCache when one is given (see createPuzzleWithCache()).
+ *
+ * Returns the puzzle, or NULL with status set to SOLVE_UNSATISFIABLE (clues that cannot
+ * fit or whose totals differ) or SOLVE_OUT_OF_MEMORY.
+ */
+static Puzzle * buildPuzzle (LineClue ** lineClues, int width, int length, LineCache * lineCache, SolveStatus * status)
+{
+	Puzzle * puzzle = NULL;
+
+	if (!validateClues(lineClues, width, length))
+	{
+		freeLineClues(lineClues, width + length);
+		*status = SOLVE_UNSATISFIABLE;
+		return NULL;
+	}
+
+	puzzle = createPuzzleWithCache(lineClues, width, length, lineCache);
+	if (puzzle == NULL)
+	{
+		freeLineClues(lineClues, width + length);
+		*status = SOLVE_OUT_OF_MEMORY;
+		return NULL;
+	}
+
+	*status = SOLVE_IN_PROGRESS;
+
+	return puzzle;
+}
+
+/*
+ * Reads and validates a puzzle file and builds its solver state.
+ *
+ * Returns the puzzle, or NULL with status set to SOLVE_INVALID_INPUT (unreadable file)
+ * or as for buildPuzzle().
+ */
+static Puzzle * loadPuzzle (FILE * filePtr, SolveStatus * status)
+{
+	int width = 0, length = 0;
+	LineClue ** lineClues = NULL;
+
+	*status = SOLVE_INVALID_INPUT;
+
+	lineClues = readFile(filePtr, &width, &length);
+	if (lineClues == NULL)
+		return NULL;
+
+	return buildPuzzle(lineClues, width, length, NULL, status);
+}
+
+/*
+ * Solves every cell that follows from the clues: line propagation with propagatePuzzle(),
+ * and while it stalls, probing (probePuzzle()) followed by resumed propagation.
+ *
+ * Returns SOLVE_INCOMPLETE when search is needed for the remaining cells.
+ */
+static SolveStatus deducePuzzle (Puzzle * puzzle)
+{
+	SolveStatus result = propagatePuzzle(puzzle);
+
+	/* The lines left to probing and search are enumerated already, or on demand */
+	endSpeculation(puzzle);
+
+	while (result == SOLVE_INCOMPLETE)
+	{
+		result = probePuzzle(puzzle);
+
+		if (result != SOLVE_IN_PROGRESS)
+			break;
+
+		result = resumePropagation(puzzle);
+	}
+
+	return result;
+}
+
+/*
+ * RegionSolver for the parallel search engine: the first solution of one region.
+ */
+static SolveStatus searchRegion (Puzzle * puzzle, const int * cells, int cellCount)
+{
+	return searchPuzzle(puzzle, cells, cellCount, 1, NULL);
+}
+
+/*
+ * Runs the whole solve on a built puzzle: deducePuzzle(), then, if cells remain, a search
+ * of each independent region with the given engine. The final progress report goes out
+ * here, with the search's solution on the board.
+ */
+static SolveStatus finishPuzzle (Puzzle * puzzle, SearchEngine engine)
+{
+	SolveStatus result = deducePuzzle(puzzle);
+
+	/* Nothing left to deduce: search the remaining cells, one independent region at a time */
+	if (result == SOLVE_INCOMPLETE && engine == SEARCH_PARALLEL)
+		result = solveComponents(puzzle, searchRegion, FALSE);
+
+	else if (result == SOLVE_INCOMPLETE)
+		result = solveComponents(puzzle, cdclSolve, TRUE);
+
+	reportProgress(puzzle, PROGRESS_DONE, result);
+
+	return result;
+}
+
+/*
+ * Whether a solve that ended with status hands back a game board: a solution, or the
+ * cells solved before a search gave up or the solve's bounds stopped it.
+ */
+static bool hasGameBoard (SolveStatus status)
+{
+	return status == SOLVE_SOLVED || status == SOLVE_INCOMPLETE || status == SOLVE_TIMED_OUT || status == SOLVE_CANCELLED;
+}
+
+/*
+ * Solves a Nonogram puzzle from a file input stream and returns the game board.
  *
  * Parameters:
  * - filePtr     : FILE pointer to a valid puzzle input file.
- * - mode        : 0 for printing and returning the solution, 1 for benchmarking only (no printing).
+ * - mode        : 0 for printing (in the format set with setBoardFormat()) and returning the
+ *                 solution, 1 for benchmarking only (no printing).
  * - iterations  : Pointer to an integer that will be updated with the number of iterations required.
+ * - status      : Optional (may be NULL), receives the outcome of the solve.
  *
  * Workflow:
  * - Reads the puzzle dimensions and clues using readFile().
- * - Allocates and initializes tracking arrays and the game board.
- * - Creates Line structures for each row and column and applies initial overlap deduction.
- * - Alternates solving rows and columns until the board is fully solved.
- * - For each line, generates permutations only when needed and uses bitmasks to track filtered permutations.
- * - Tracks and reuses consistent patterns to deduce newly solvable cells.
+ * - Rejects clue sets that cannot fit their lines or whose row and column totals differ.
+ * - Builds the solver state with createPuzzle() and runs line propagation with propagatePuzzle().
+ * - When line propagation stalls, alternates probing (probePuzzle()) with resumed propagation.
+ * - When probing stalls too, splits the remaining cells into independent regions with
+ *   solveComponents() and searches each with cdclSolve() (regions in parallel) or, if
+ *   selected with setSearchEngine(), searchPuzzle() (one region after another).
+ *
+ * Return:
+ * - The dynamically allocated game board for SOLVE_SOLVED (one of the solutions when the
+ *   clues allow several).
+ * - NULL for SOLVE_INVALID_INPUT (unreadable file), SOLVE_UNSATISFIABLE (the clues contradict
+ *   each other) and SOLVE_OUT_OF_MEMORY.
+ */
+int * solvePuzzle (FILE * filePtr, char mode, int * iterations, SolveStatus * status)
+{
+	return solvePuzzleWithOptions(filePtr, mode, iterations, status, NULL);
+}
+
+/*
+ * solvePuzzle() within the bounds of options (see SolveOptions), NULL for none.
+ *
+ * Every stage polls the bounds between units of work. A solve they stop returns
+ * SOLVE_TIMED_OUT or SOLVE_CANCELLED together with the partially solved game board
+ * (-1 for unsolved cells), printed in mode 0 like a solution.
+ */
+int * solvePuzzleWithOptions (FILE * filePtr, char mode, int * iterations, SolveStatus * status, const SolveOptions * options)
+{
+	int * gameBoard = NULL;
+	Puzzle * puzzle = NULL;
+	SolveStatus result = SOLVE_INVALID_INPUT;
+
+	if (mode != 0 && mode != 1)
+		goto solve_Done;
+
+	puzzle = loadPuzzle(filePtr, &result);
+	if (puzzle == NULL)
+		goto solve_Done;
+
+	setSolveOptions(puzzle, options);
+	result = finishPuzzle(puzzle, (SearchEngine)atomic_load(&searchEngine));
+
+	*iterations += puzzle->iterations;
+
+	if (hasGameBoard(result))
+	{
+		gameBoard = puzzle->gameBoard;
+		puzzle->gameBoard = NULL;
+
+		if (mode == 0)
+			writeGameBoard(stdout, gameBoard, puzzle->width, puzzle->length, (BoardFormat)atomic_load(&boardFormat));
+	}
+
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
+solve_Done:
+	if (status != NULL)
+		*status = result;
+
+	return gameBoard;
+}
+
+typedef struct CountContext {
+	Puzzle * puzzle;
+	SolutionCallback callback;
+	void * context;
+	long count;
+	int firstDifference;
+} CountContext;
+
+/*
+ * SolutionHandler for countSolutions(): finds where the second solution departs from
+ * the first (which cdclEnumerate() keeps in the puzzle's gameboard) and forwards each
+ * solution to the caller's callback.
+ */
+static bool countSolution (const int * board, void * arg)
+{
+	int i;
+	CountContext * counter = (CountContext *)arg;
+	Puzzle * puzzle = counter->puzzle;
+
+	if (++counter->count == 2)
+		for (i = 0; i < puzzle->width * puzzle->length && counter->firstDifference < 0; ++i)
+			if (board[i] != puzzle->gameBoard[i])
+				counter->firstDifference = i;
+
+	if (counter->callback != NULL)
+		counter->callback(board, puzzle->width, puzzle->length, counter->context);
+
+	return TRUE;
+}
+
+/*
+ * Counts the solutions of a Nonogram puzzle from a file input stream, up to a limit.
+ *
+ * Parameters:
+ * - filePtr         : FILE pointer to a valid puzzle input file.
+ * - limit           : Stop counting at this many solutions (2 answers "is it unique?"),
+ *                     0 to count every solution.
+ * - callback        : Optional (may be NULL), called with each solution as it is found.
+ * - context         : Passed through to callback.
+ * - solutionCount   : Receives the number of solutions found (at most limit).
+ * - firstDifference : Optional (may be NULL), receives the first cell (row major) where the
+ *                     first two solutions differ, -1 with fewer than two solutions.
+ * - options         : Optional (may be NULL), bounds on the count (see SolveOptions).
+ *
+ * Cells that follow from the clues are solved first (deducePuzzle()), every solution
+ * shares them, then cdclEnumerate() walks the remaining ones, excluding each solution
+ * it finds.
+ *
+ * Return:
+ * - SOLVE_SOLVED when at least one solution exists.
+ * - SOLVE_UNSATISFIABLE when there is none.
+ * - SOLVE_INVALID_INPUT or SOLVE_OUT_OF_MEMORY as for solvePuzzle().
+ * - SOLVE_TIMED_OUT or SOLVE_CANCELLED when options stop the count, solutionCount then
+ *   holds the solutions found so far.
+ */
+SolveStatus countSolutions (FILE * filePtr, long limit, SolutionCallback callback, void * context, long * solutionCount,
+	int * firstDifference, const SolveOptions * options)
+{
+	CountContext counter;
+	Puzzle * puzzle = NULL;
+	SolveStatus result;
+
+	counter.puzzle = NULL;
+	counter.callback = callback;
+	counter.context = context;
+	counter.count = 0;
+	counter.firstDifference = -1;
+
+	puzzle = loadPuzzle(filePtr, &result);
+	if (puzzle == NULL)
+		goto count_Done;
+
+	counter.puzzle = puzzle;
+	setSolveOptions(puzzle, options);
+	result = deducePuzzle(puzzle);
+
+	if (result == SOLVE_SOLVED)
+		countSolution(puzzle->gameBoard, &counter);
+
+	else if (result == SOLVE_INCOMPLETE)
+		result = cdclEnumerate(puzzle, NULL, 0, limit, countSolution, &counter, NULL);
+
+	reportProgress(puzzle, PROGRESS_DONE, result);
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
+count_Done:
+	*solutionCount = counter.count;
+
+	if (firstDifference != NULL)
+		*firstDifference = counter.firstDifference;
+
+	return result;
+}
+
+/*
+ * Creates a solver context, the reentrant form of solvePuzzleWithOptions(): each context
+ * holds its own bounds, search engine and last result, reads puzzles from memory and
+ * never writes to stdout, so separate threads can solve with separate contexts.
+ *
+ * Parameters:
+ * - options : Optional (may be NULL), bounds applied to every solve (see SolveOptions).
+ *             The cancel flag, if any, stays owned by the caller.
+ * - engine  : The search used once line logic and probing stall (see setSearchEngine()).
+ *
+ * Return:
+ * - The context, or NULL if memory runs out.
+ */
+SolverContext * createSolverContext (const SolveOptions * options, SearchEngine engine)
+{
+	SolverContext * context = (SolverContext *)calloc(1, sizeof(SolverContext));
+
+	if (context == NULL)
+		return NULL;
+
+	if (options != NULL)
+		context->options = *options;
+
+	context->engine = engine;
+	context->result.status = SOLVE_INVALID_INPUT;
+
+	return context;
+}
+
+void freeSolverContext (SolverContext * context)
+{
+	if (context == NULL) return;
+
+	freeCdcl(context->search);
+	context->search = NULL;
+
+	freePuzzle(context->puzzle);
+	context->puzzle = NULL;
+
+	free(context->result.gameBoard);
+	context->result.gameBoard = NULL;
+
+	free(context);
+
+	return;
+}
+
+/*
+ * Makes every later solve of the context go through lineCache instead of a cache of its
+ * own, so line solves are reused from puzzle to puzzle and across the contexts sharing
+ * it. The cache stays owned by the caller and must outlive the context's solves; NULL
+ * goes back to a cache per puzzle. The result's cache statistics are then the shared
+ * cache's running totals.
+ */
+void shareLineCache (SolverContext * context, LineCache * lineCache)
+{
+	context->lineCache = lineCache;
+
+	return;
+}
+
+/*
+ * Discards a context's previous result, and its step-wise solve if one is in flight.
+ */
+static void resetResult (SolverContext * context)
+{
+	freeCdcl(context->search);
+	context->search = NULL;
+
+	freePuzzle(context->puzzle);
+	context->puzzle = NULL;
+
+	free(context->result.gameBoard);
+
+	memset(&context->result, 0, sizeof(SolveResult));
+	context->result.status = SOLVE_INVALID_INPUT;
+
+	return;
+}
+
+/*
+ * Fills a context's result from a finished solve of puzzle.
+ */
+static void collectResult (SolverContext * context, Puzzle * puzzle, SolveStatus status)
+{
+	SolveResult * result = &context->result;
+
+	result->status = status;
+	result->iterations = puzzle->iterations;
+
+	if (puzzle->lineCache != NULL)
+		lineCacheStats(puzzle->lineCache, &result->cacheLookups, &result->cacheHits);
+
+	if (hasGameBoard(status))
+	{
+		result->gameBoard = puzzle->gameBoard;
+		puzzle->gameBoard = NULL;
+	}
+
+	return;
+}
+
+/*
+ * Solves parsed clues (ownership taken) within the context's bounds and fills its result,
+ * timed from start.
+ */
+static const SolveResult * solveContext (SolverContext * context, LineClue ** lineClues, int width, int length, long start)
+{
+	SolveResult * result = &context->result;
+	Puzzle * puzzle = buildPuzzle(lineClues, width, length, context->lineCache, &result->status);
+
+	if (puzzle == NULL)
+		goto context_Done;
+
+	result->width = width;
+	result->length = length;
+
+	setSolveOptions(puzzle, &context->options);
+	collectResult(context, puzzle, finishPuzzle(puzzle, context->engine));
+
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
+context_Done:
+	result->elapsedNanos = monotonicNanos() - start;
+
+	return result;
+}
+
+/*
+ * Solves a puzzle held in memory, in the puzzle file format (see readBuffer()).
  *
- * Memory Handling:
- * - Allocates memory progressively based on solving needs.
- * - Includes multi-stage cleanup using `goto` and reverse deallocation for safe unwinding.
- * - Frees all intermediate allocations and LineClue structures before returning the final game board.
+ * Parameters:
+ * - context : The solver context, which receives the result.
+ * - buffer  : The puzzle text.
+ * - size    : Length of buffer in bytes.
  *
  * Return:
- * - A pointer to a dynamically allocated, fully solved game board array (int *), or NULL on error.
+ * - The context's result: the status as for solvePuzzleWithOptions(), the game board when
+ *   the solve produced one, statistics, and for SOLVE_INVALID_INPUT the parse error.
+ */
+const SolveResult * solveBuffer (SolverContext * context, const char * buffer, size_t size)
+{
+	int width = 0, length = 0;
+	long start = monotonicNanos();
+	LineClue ** lineClues = NULL;
+
+	resetResult(context);
+
+	lineClues = readBuffer(buffer, size, &width, &length, context->result.error, sizeof(context->result.error));
+	if (lineClues == NULL)
+	{
+		context->result.elapsedNanos = monotonicNanos() - start;
+		return &context->result;
+	}
+
+	return solveContext(context, lineClues, width, length, start);
+}
+
+/*
+ * Solves a puzzle given as clue arrays.
+ *
+ * Parameters:
+ * - context    : The solver context, which receives the result.
+ * - width      : Gameboard width, 1 to MAX_LINE_SIZE.
+ * - length     : Gameboard length, 1 to MAX_LINE_SIZE.
+ * - clues      : width + length arrays of positive clues, rows first, then columns.
+ * - clueCounts : The number of clues in each array, at most MAX_CLUES.
  *
- * TODO:
- * - Refactor memory cleanup to better match the actual flow and dependencies of allocations.
- * - Consider breaking this function into smaller helpers for readability and maintenance.
+ * Return:
+ * - The context's result, as for solveBuffer().
  */
-int * solvePuzzle (FILE * filePtr, char mode, int * iterations)
+const SolveResult * solveClues (SolverContext * context, int width, int length, const int * const * clues, const int * clueCounts)
 {
-	int i, j = 0, width = 0, length = 0;
+	int i, j, clueBuffer[MAX_CLUES];
+	long start = monotonicNanos();
 	LineClue ** lineClues = NULL;
-	Line ** lines = NULL;
-	int * gameBoard = NULL, * rowsToUpdate = NULL, * columnsToUpdate = NULL;
-	int * columnPartialSolution = NULL;
 
-	if (mode == 0 || mode == 1)
+	resetResult(context);
+
+	if (width < 1 || width > MAX_LINE_SIZE || length < 1 || length > MAX_LINE_SIZE || clues == NULL || clueCounts == NULL)
 	{
-		lineClues = readFile(filePtr, &width, &length);
-		if (lineClues == NULL)
-			return NULL;
-
-		rowsToUpdate = (int *)calloc(length, sizeof(int));
-		if (rowsToUpdate == NULL)
-			goto row_Free;
-			
-		columnsToUpdate = (int *)calloc(width, sizeof(int));
-		if (columnsToUpdate == NULL)
-			goto column_Free;
-			
-		columnPartialSolution = (int *)calloc(length, sizeof(int));
-		if (columnPartialSolution == NULL)
-			goto partial_Free;
-
-		gameBoard = createGameBoard(width, length);
-		if (gameBoard == NULL)
-			goto gameBoard_Free;
-
-		lines = (Line **)malloc(sizeof(Line *) * (width + length));
-		if (lines == NULL)
-			goto lines_Free;
-
-		for (i = 0; i < length; ++i)
-		{
-			lines[i] = createLine(lineClues[i], width, i);
+		snprintf(context->result.error, sizeof(context->result.error),
+			"Invalid dimensions: width and length must be between 1 and %d.", MAX_LINE_SIZE);
+		goto clues_Done;
+	}
+
+	lineClues = (LineClue **)calloc(width + length, sizeof(LineClue *));
+	if (lineClues == NULL)
+	{
+		context->result.status = SOLVE_OUT_OF_MEMORY;
+		goto clues_Done;
+	}
 
-			if (lines[i] == NULL)
-				goto createLine_Free;
+	for (i = 0; i < width + length; ++i)
+	{
+		if (clueCounts[i] < 0 || clueCounts[i] > MAX_CLUES || (clueCounts[i] > 0 && clues[i] == NULL))
+		{
+			snprintf(context->result.error, sizeof(context->result.error),
+				"Invalid clues on line %d: expected at most %d clues.", i, MAX_CLUES);
+			goto free_Clues;
 		}
 
-		for ( ; i < width + length; ++i)
+		for (j = 0; j < clueCounts[i]; ++j)
 		{
-			lines[i] = createLine(lineClues[i], length, i);
+			if (clues[i][j] < 1)
+			{
+				snprintf(context->result.error, sizeof(context->result.error),
+					"Invalid clues on line %d: expecting positive integers.", i);
+				goto free_Clues;
+			}
 
-			if (lines[i] == NULL)
-				goto createLine_Free;
+			clueBuffer[j] = clues[i][j];
 		}
 
-		for (i = 0; i < length; ++i)
+		lineClues[i] = createLineClueSet(clueBuffer, clueCounts[i]);
+		if (lineClues[i] == NULL)
+		{
+			context->result.status = SOLVE_OUT_OF_MEMORY;
+			goto free_Clues;
+		}
+	}
+
+	return solveContext(context, lineClues, width, length, start);
+
+free_Clues:
+	freeLineClues(lineClues, i);
+	lineClues = NULL;
+
+clues_Done:
+	context->result.elapsedNanos = monotonicNanos() - start;
+
+	return &context->result;
+}
+
+/*
+ * Starts a step-wise solve of a puzzle held in memory (see readBuffer()), to be advanced
+ * with stepSolve(). Nothing is solved yet, so one thread can start many solves and share
+ * its time between them.
+ *
+ * Parameters:
+ * - context : The solver context, which holds the solve until it finishes, or until the
+ *             context's next solve or freeSolverContext().
+ * - buffer  : The puzzle text.
+ * - size    : Length of buffer in bytes.
+ *
+ * Return:
+ * - The context's result with status SOLVE_PAUSED, or a final status as for
+ *   solveBuffer() when the puzzle is rejected. The context's time limit counts from now.
+ */
+const SolveResult * beginSolve (SolverContext * context, const char * buffer, size_t size)
+{
+	int width = 0, length = 0;
+	long start = monotonicNanos();
+	LineClue ** lineClues = NULL;
+	SolveResult * result = &context->result;
+
+	resetResult(context);
+
+	lineClues = readBuffer(buffer, size, &width, &length, result->error, sizeof(result->error));
+
+	if (lineClues != NULL)
+		context->puzzle = buildPuzzle(lineClues, width, length, context->lineCache, &result->status);
+
+	if (context->puzzle != NULL)
+	{
+		result->width = width;
+		result->length = length;
+		result->status = SOLVE_PAUSED;
+
+		setSolveOptions(context->puzzle, &context->options);
+		markAllDirty(context->puzzle);
+		context->stage = STAGE_RULES;
+	}
+
+	result->elapsedNanos = monotonicNanos() - start;
+
+	return result;
+}
+
+/*
+ * Advances a solve started with beginSolve() by a bounded amount of work.
+ *
+ * The solve runs the stages of solveBuffer() (rule pass, line sweeps, probing, then one
+ * clause learning search over every remaining cell) and keeps each stage's state between
+ * steps. A step ends when the next unit of work (a line visited, a probe or a search
+ * decision or conflict) would exceed its budget, and always does at least one unit.
+ *
+ * Parameters:
+ * - context : A context with a solve in flight.
+ * - units   : Units of work the step may do, 0 for no count.
+ * - micros  : Microseconds the step may take, 0 for no time. Checked between units, so a
+ *             long unit (such as enumerating a long line) can overrun it.
+ *
+ * Return:
+ * - The context's result: SOLVE_PAUSED while work remains (iterations and elapsedNanos,
+ *   the time spent in steps, are kept up to date), then the final status with the game
+ *   board as for solveBuffer(). Once finished, further steps return the result unchanged.
+ */
+const SolveResult * stepSolve (SolverContext * context, long units, long micros)
+{
+	long start = monotonicNanos();
+	Puzzle * puzzle = context->puzzle;
+	SolveResult * result = &context->result;
+	SolveStatus status;
+
+	if (puzzle == NULL)
+		return result;
+
+	setStepBudget(puzzle, units, micros);
+
+	for ( ; ; )
+	{
+		if (context->stage == STAGE_RULES)
 		{
-			overlap(lines[i]);
-			setGameBoardRow(gameBoard, lines[i], columnsToUpdate);
+			status = propagateRules(puzzle);
+			if (status != SOLVE_IN_PROGRESS)
+				break;
+
+			markAllDirty(puzzle);
+			context->stage = STAGE_SWEEPS;
 		}
 
-		for ( ; i < width + length; ++i)
+		else if (context->stage == STAGE_SWEEPS)
 		{
-			overlap(lines[i]);
-			setGameBoardColumn(gameBoard, lines[i], width, rowsToUpdate);
+			status = resumePropagation(puzzle);
+			if (status != SOLVE_INCOMPLETE)
+				break;
+
+			endSpeculation(puzzle);
+			context->stage = STAGE_PROBE;
 		}
 
-		while (!isSolved(gameBoard, width, length))
+		else if (context->stage == STAGE_PROBE)
 		{
-			++(*iterations);
-			for (i = 0; i < length; ++i)
-			{
-				if (rowsToUpdate[i] == 1)
-				{
-					updateBitMasks(lines[i], gameBoard + (i * width));
-
-					if (lines[i]->permutationCount == 0)
-					{
-						generatePermutations(lines[i], 0, 0ULL, 0, TRUE, &(lines[i]->permutationCount));
-
-						lines[i]->permutations = (uint64_t *)malloc(sizeof(uint64_t) * lines[i]->permutationCount);
-						if (lines[i]->permutations == NULL)
-							goto permutation_Free;
-							
-						lines[i]->bitSet = newBitSet(lines[i]->permutationCount);
-						if (lines[i]->bitSet == NULL)
-							goto bitSet_Free;
-
-						generatePermutations(lines[i], 0, 0ULL, 0, FALSE, &(lines[i]->storeCount));
-					}
-
-					else
-						filterPermutations(lines[i]);
-					
-					generateConsistentPattern(lines[i]);
-					setGameBoardRow(gameBoard, lines[i], columnsToUpdate);
-				}
-			}
+			status = probePuzzle(puzzle);
 
-			memset(rowsToUpdate, 0x00, sizeof(int) * length);
+			if (status == SOLVE_IN_PROGRESS)
+				context->stage = STAGE_SWEEPS;
 
+			else if (status != SOLVE_INCOMPLETE)
+				break;
 
-			/* TODO: update memory freeing since memory is allocated through the solve and not sequencially */
-			for ( ; i < width + length; ++i)
+			else
 			{
-				if (columnsToUpdate[i - length] == 1)
+				context->search = createCdcl(puzzle, NULL, 0);
+				if (context->search == NULL)
 				{
-					getGameBoardColumn(gameBoard, columnPartialSolution, width, length, i - length);
-					updateBitMasks(lines[i], columnPartialSolution);
-
-					if (lines[i]->permutationCount == 0)
-					{
-						generatePermutations(lines[i], 0, 0ULL, 0, TRUE, &(lines[i]->permutationCount));
-
-						lines[i]->permutations = (uint64_t *)malloc(sizeof(uint64_t) * lines[i]->permutationCount);
-						if (lines[i]->permutations == NULL)
-							goto permutation_Free;
-							
-						lines[i]->bitSet = newBitSet(lines[i]->permutationCount);
-						if (lines[i]->bitSet == NULL)
-							goto bitSet_Free;
-
-						generatePermutations(lines[i], 0, 0ULL, 0, FALSE, &(lines[i]->storeCount));
-					}
-
-					else
-						filterPermutations(lines[i]);
-					
-					generateConsistentPattern(lines[i]);
-					setGameBoardColumn(gameBoard, lines[i], width, rowsToUpdate);
-				}		
-			}
+					status = SOLVE_OUT_OF_MEMORY;
+					break;
+				}
 
-			memset(columnsToUpdate, 0x00, sizeof(int) * width);
+				context->stage = STAGE_SEARCH;
+			}
 		}
-	}
 
-	if (mode == 0)
-		printGameBoard(gameBoard, width, length);
-	
-	for (i = 0; i < width + length; ++i)
-	{
-		free(lineClues[i]->clues);
-		lineClues[i]->clues = NULL;
-		lines[i]->clueSet->clues = NULL;
-		free(lineClues[i]);
-		lineClues[i] = NULL;
-		lines[i]->clueSet = NULL;
+		else
+		{
+			status = resumeCdcl(context->search, 1, NULL, NULL, NULL);
+			break;
+		}
 	}
 
-	free(lineClues);
-	lineClues = NULL;
+	result->iterations = puzzle->iterations;
 
-bitSet_Free:
-	if (i < width + length)
+	if (status != SOLVE_PAUSED)
 	{
-		free(lines[i]->permutations);
-		lines[i]->permutations = NULL;
-	}
+		reportProgress(puzzle, PROGRESS_DONE, status);
+		collectResult(context, puzzle, status);
 
-permutation_Free:	
-	j = i - 1;
-	i = width + length;
-	for ( ; j >= 0; --j)
-	{
-		free(lines[j]->bitSet->words);
-		lines[j]->bitSet->words = NULL;
-		
-		free(lines[j]->bitSet);
-		lines[j]->bitSet = NULL;
-
-		free(lines[j]->permutations);
-		lines[j]->permutations = NULL;
-	}
+		freeCdcl(context->search);
+		context->search = NULL;
 
-createLine_Free:
-	for (i = i - 1; i >= 0 ; --i)
-	{
-		free(lines[i]);
-		lines[i] = NULL;
+		freePuzzle(puzzle);
+		context->puzzle = NULL;
 	}
 
-	free(lines);
-	lines = NULL;
-lines_Free:
-
-gameBoard_Free:
-	
-	free(columnPartialSolution);
-	columnPartialSolution = NULL;
-partial_Free:
-	
-	free(columnsToUpdate);
-	columnsToUpdate = NULL;
-column_Free:
-
-	free(rowsToUpdate);
-	rowsToUpdate = NULL;
-row_Free:
-		
+	result->status = status;
+	result->elapsedNanos += monotonicNanos() - start;
 
-	return gameBoard;
+	return result;
 }
@@ -0,0 +1,232 @@
+#include "../include/speculate.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include "../include/parallel.h"
+#include "../include/puzzle.h"
+#include "../include/solver.h"
+#include "../include/spill.h"
+
+/*
+ * Speculative enumeration: when propagation moves from the line rules to the full
+ * sweeps, every line left unsolved and unenumerated will be enumerated as soon as the
+ * sweep reaches it, each call blocking the sweep. Pool threads enumerate copies of the
+ * large ones in the meantime, from the cells known when they were queued, and the sweep
+ * adopts a copy instead of enumerating and filters it against the cells solved since.
+ *
+ * The sweep claims lines from the front of the sweep order, the helpers work from the
+ * back, so they meet in the middle with little wasted work: a line the sweep reaches
+ * before any helper started it is enumerated by the sweep as usual.
+ */
+
+/* Placements below which a line enumerates faster than a helper can hand it over */
+#define SPECULATION_THRESHOLD 4096.0
+
+/* Pool threads per puzzle, beyond which they mostly wait on memory */
+#define MAX_SPECULATION_HELPERS 8
+
+typedef enum JobState {
+	JOB_PENDING = 0,
+	JOB_RUNNING,
+	JOB_DONE,
+	JOB_TAKEN
+} JobState;
+
+typedef struct SpeculativeJob {
+	Line * line;          /* The copy being enumerated, NULL once handed over or failed */
+	JobState state;
+} SpeculativeJob;
+
+struct Speculation {
+	SpeculativeJob * jobs;  /* By line index */
+	int * order;            /* Line indexes of the jobs, last in the sweep first */
+	int jobCount;
+	EnumerationGuard guard; /* The solve's cancel flag and deadline, shared by every copy */
+	ParallelJob * helpers;
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+};
+
+/*
+ * Task: enumerates the queued line at position index of the order unless the sweep has
+ * claimed it or the speculation is stopped, by its owner or the solve's limits.
+ */
+static void speculate (void * arg, int index)
+{
+	Speculation * speculation = (Speculation *)arg;
+	SpeculativeJob * job = &speculation->jobs[speculation->order[index]];
+	bool enumerated;
+
+	pthread_mutex_lock(&speculation->lock);
+
+	if (job->state != JOB_PENDING || checkEnumerationGuard(&speculation->guard))
+	{
+		pthread_mutex_unlock(&speculation->lock);
+		return;
+	}
+
+	job->state = JOB_RUNNING;
+	pthread_mutex_unlock(&speculation->lock);
+
+	enumerated = enumeratePermutations(job->line);
+
+	pthread_mutex_lock(&speculation->lock);
+
+	if (!enumerated)
+	{
+		freeLine(job->line);
+		job->line = NULL;
+	}
+
+	job->state = JOB_DONE;
+	pthread_cond_broadcast(&speculation->done);
+	pthread_mutex_unlock(&speculation->lock);
+
+	return;
+}
+
+/*
+ * Queues every unsolved, unenumerated line of the puzzle with at least
+ * SPECULATION_THRESHOLD placements for enumeration on the shared thread pool (see
+ * queueParallel()), each a copy of the line with the cells it knows now. The copies
+ * watch the puzzle's cancel flag and deadline, so a cancelled or timed out solve does
+ * not leave the pool busy with them.
+ *
+ * Nothing is speculated on a single worker or under a permutation or step budget, whose
+ * accounting needs each enumeration to be decided when the sweep reaches it.
+ *
+ * Returns the speculation, or NULL when nothing is worth speculating or it could not be
+ * started (the sweep then enumerates every line itself).
+ */
+Speculation * startSpeculation (Puzzle * puzzle)
+{
+	int i;
+	const int lineCount = puzzle->width + puzzle->length;
+	double placements;
+	Line * line = NULL;
+	Speculation * speculation = NULL;
+
+	if (getWorkerCount() < 2 || puzzle->permutationBudget > 0 || puzzle->stepUnits > 0 || puzzle->stepDeadline > 0)
+		return NULL;
+
+	speculation = (Speculation *)calloc(1, sizeof(Speculation));
+	if (speculation == NULL)
+		return NULL;
+
+	speculation->jobs = (SpeculativeJob *)calloc(lineCount, sizeof(SpeculativeJob));
+	speculation->order = (int *)malloc(sizeof(int) * lineCount);
+
+	if (speculation->jobs == NULL || speculation->order == NULL)
+		goto start_Fail;
+
+	atomic_init(&speculation->guard.stop, FALSE);
+	speculation->guard.cancel = puzzle->cancel;
+	speculation->guard.deadline = puzzle->deadline;
+
+	for (i = lineCount - 1; i >= 0; --i)
+	{
+		line = puzzle->lines[i];
+		speculation->jobs[i].state = JOB_TAKEN;
+
+		if (line->bitSet != NULL || line->spill != NULL || isLineSolved(line))
+			continue;
+
+		/* Lines the sweep would spill to disk are left to it */
+		placements = countPlacements(line);
+		if (placements < SPECULATION_THRESHOLD || needsSpill(placements, line->size))
+			continue;
+
+		speculation->jobs[i].line = createLine(line->clueSet, line->size, i);
+		if (speculation->jobs[i].line == NULL)
+			continue;
+
+		speculation->jobs[i].line->maskBits = line->maskBits;
+		speculation->jobs[i].line->partialBits = line->partialBits;
+		speculation->jobs[i].line->guard = &speculation->guard;
+		speculation->jobs[i].state = JOB_PENDING;
+		speculation->order[speculation->jobCount++] = i;
+	}
+
+	if (speculation->jobCount == 0)
+		goto start_Fail;
+
+	pthread_mutex_init(&speculation->lock, NULL);
+	pthread_cond_init(&speculation->done, NULL);
+
+	speculation->helpers = queueParallel(speculate, speculation, speculation->jobCount, MAX_SPECULATION_HELPERS);
+
+	if (speculation->helpers == NULL)
+	{
+		stopSpeculation(speculation);
+		return NULL;
+	}
+
+	return speculation;
+
+start_Fail:
+	for (i = 0; speculation->jobs != NULL && i < lineCount; ++i)
+		freeLine(speculation->jobs[i].line);
+
+	free(speculation->jobs);
+	free(speculation->order);
+	free(speculation);
+
+	return NULL;
+}
+
+/*
+ * Hands over the speculative enumeration of line index, waiting for a helper that is
+ * still enumerating it. A line no helper has started is withdrawn instead.
+ *
+ * Returns the enumerated copy, which the caller adopts and frees, or NULL when the line
+ * was not speculated, was withdrawn or its enumeration failed; the caller then
+ * enumerates the line itself.
+ */
+Line * takeSpeculation (Speculation * speculation, int index)
+{
+	Line * line = NULL;
+	SpeculativeJob * job = &speculation->jobs[index];
+
+	pthread_mutex_lock(&speculation->lock);
+
+	while (job->state == JOB_RUNNING)
+		pthread_cond_wait(&speculation->done, &speculation->lock);
+
+	if (job->state == JOB_DONE)
+	{
+		line = job->line;
+		job->line = NULL;
+	}
+
+	job->state = JOB_TAKEN;
+
+	pthread_mutex_unlock(&speculation->lock);
+
+	return line;
+}
+
+/*
+ * Stops the speculation: lines no helper has started are dropped and the enumerations in
+ * progress are abandoned rather than waited out, then every speculative enumeration not
+ * handed over is freed.
+ */
+void stopSpeculation (Speculation * speculation)
+{
+	int i;
+
+	if (speculation == NULL) return;
+
+	atomic_store(&speculation->guard.stop, TRUE);
+	finishParallel(speculation->helpers);
+
+	for (i = 0; i < speculation->jobCount; ++i)
+		freeLine(speculation->jobs[speculation->order[i]].line);
+
+	pthread_mutex_destroy(&speculation->lock);
+	pthread_cond_destroy(&speculation->done);
+
+	free(speculation->jobs);
+	free(speculation->order);
+	free(speculation);
+
+	return;
+}
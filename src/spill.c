@@ -0,0 +1,334 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../include/spill.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../include/puzzle.h"
+#include "../include/solver.h"
+
+/*
+ * Out-of-core permutations: a line with more permutations than memory (or an int) holds
+ * writes them to a temporary file and streams them back in large sequential chunks. Each
+ * pass drops the permutations the newly solved cells rule out, compacting the survivors
+ * towards the start of the file and truncating it, so the file shrinks as the line gets
+ * solved. Passes fold the consensus of the survivors as they go, in place of the per-cell
+ * counts in-memory lines keep, and poll the puzzle's cancel flag and deadline after every
+ * chunk so a spill never outlives the solve's limits.
+ */
+
+/* Smallest chunk worth streaming with when memory is too short for SPILL_CHUNK_WORDS */
+#define SPILL_MIN_CHUNK_WORDS 4096
+
+/* The generation pass: permutations gather in the spill's chunk until it is written out */
+typedef struct SpillWriter {
+	Line * line;
+	PermutationSpill * spill;
+	size_t used;
+	off_t offset;
+	uint64_t andMask;
+	uint64_t orMask;
+	struct Puzzle * puzzle;
+	SolveStatus status;        /* SOLVE_IN_PROGRESS until a write fails or a limit stops it */
+} SpillWriter;
+
+/*
+ * Returns TRUE when a line of size cells with placements permutations should be kept on
+ * disk rather than enumerated in memory: an int cannot count them, or their words, BitSet
+ * bits and per-cell index would take more than the physical memory free now.
+ */
+bool needsSpill (double placements, int size)
+{
+	long pages, pageSize;
+	double bytes = placements * (sizeof(uint64_t) + (size + 1) / 8.0);
+
+	if (placements > SPILL_MIN_PLACEMENTS)
+		return TRUE;
+
+	/* Smaller than a chunk always fits, spare the system call */
+	if (bytes <= SPILL_CHUNK_WORDS * sizeof(uint64_t))
+		return FALSE;
+
+	pages = sysconf(_SC_AVPHYS_PAGES);
+	pageSize = sysconf(_SC_PAGESIZE);
+
+	/* A system that cannot tell leaves the line to fail its allocation instead */
+	if (pages <= 0 || pageSize <= 0)
+		return FALSE;
+
+	return bytes > (double)pages * pageSize;
+}
+
+/*
+ * Reads (or writes) bytes of buffer at offset of the file, retrying short transfers.
+ * Returns FALSE on an I/O error or an early end of file.
+ */
+static bool transfer (int fd, void * buffer, size_t bytes, off_t offset, bool writing)
+{
+	ssize_t done;
+	char * cursor = (char *)buffer;
+
+	while (bytes > 0)
+	{
+		done = writing ? pwrite(fd, cursor, bytes, offset) : pread(fd, cursor, bytes, offset);
+
+		if (done < 0 && errno == EINTR)
+			continue;
+
+		if (done <= 0)
+			return FALSE;
+
+		cursor += done;
+		offset += done;
+		bytes -= (size_t)done;
+	}
+
+	return TRUE;
+}
+
+/*
+ * The puzzle's checkDeadline() status, SOLVE_IN_PROGRESS without a puzzle.
+ */
+static SolveStatus pollLimits (struct Puzzle * puzzle)
+{
+	return (puzzle != NULL) ? checkDeadline(puzzle) : SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Writes the filled part of the chunk to the end of the file, then polls the limits.
+ */
+static void flushChunk (SpillWriter * writer)
+{
+	size_t bytes = writer->used * sizeof(uint64_t);
+
+	if (writer->status == SOLVE_IN_PROGRESS && !transfer(fileno(writer->spill->file), writer->spill->chunk, bytes, writer->offset, TRUE))
+		writer->status = SOLVE_OUT_OF_MEMORY;
+
+	if (writer->status == SOLVE_IN_PROGRESS)
+		writer->status = pollLimits(writer->puzzle);
+
+	writer->offset += (off_t)bytes;
+	writer->used = 0;
+
+	return;
+}
+
+/*
+ * generatePermutations() writing each permutation that fits the line's solved cells to
+ * the spill, with the same early pruning.
+ */
+static void spillFrom (SpillWriter * writer, int clueIndex, uint64_t current, int position)
+{
+	int groupSize, maxStart, newPosition, start;
+	uint64_t newBits, compareMask;
+	Line * line = writer->line;
+
+	if (writer->status != SOLVE_IN_PROGRESS)
+		return;
+
+	if (clueIndex >= line->clueSet->clueCount)
+	{
+		if (((current & line->maskBits) ^ line->partialBits) != 0)
+			return;
+
+		writer->andMask &= current;
+		writer->orMask |= current;
+		writer->spill->chunk[writer->used++] = current;
+		++writer->spill->count;
+
+		if (writer->used == writer->spill->chunkWords)
+			flushChunk(writer);
+
+		return;
+	}
+
+	groupSize = line->clueSet->clues[clueIndex];
+	maxStart = line->size - totalRemainingLength(line, clueIndex);
+
+	for (start = position; start <= maxStart; ++start)
+	{
+		newBits = current | (((1ULL << groupSize) - 1ULL) << start);
+		newPosition = start + groupSize + 1;
+		compareMask = ((newPosition >= 64) ? ~0ULL : (1ULL << newPosition) - 1ULL) & line->maskBits;
+
+		if (((newBits ^ line->partialBits) & compareMask) != 0)
+			continue;
+
+		spillFrom(writer, clueIndex + 1, newBits, newPosition);
+	}
+
+	return;
+}
+
+/*
+ * Adds the cells every remaining permutation agrees on (andMask filled, orMask's gaps
+ * empty) to the line's solved cells.
+ */
+static void foldConsensus (Line * line, uint64_t andMask, uint64_t orMask)
+{
+	uint64_t widthMask = (line->size == 64) ? ~0ULL : (1ULL << line->size) - 1ULL;
+	uint64_t unsolved = ~(line->maskBits) & widthMask;
+
+	line->maskBits |= (andMask | ~orMask) & unsolved;
+	line->partialBits |= andMask & unsolved;
+
+	return;
+}
+
+/*
+ * Writes every permutation of the line that is consistent with its solved cells to a
+ * temporary file, then adds the cells they all agree on to the line's solved cells.
+ *
+ * The chunk is as large as SPILL_CHUNK_WORDS when memory allows, halving down to
+ * SPILL_MIN_CHUNK_WORDS when it does not. The puzzle's limits (see checkDeadline()) are
+ * polled after every chunk written, a NULL puzzle sets none.
+ *
+ * Returns SOLVE_IN_PROGRESS, or SOLVE_UNSATISFIABLE with a spill count of 0 and the masks
+ * untouched when no permutation is consistent. Otherwise the line is left as it was and
+ * the result is SOLVE_OUT_OF_MEMORY if the file cannot be created or written or not even
+ * the smallest chunk can be allocated, or the limit's status that stopped the spill.
+ */
+SolveStatus spillPermutations (Line * line, struct Puzzle * puzzle)
+{
+	SpillWriter writer;
+	PermutationSpill * spill = (PermutationSpill *)calloc(1, sizeof(PermutationSpill));
+
+	if (spill == NULL)
+		return SOLVE_OUT_OF_MEMORY;
+
+	for (spill->chunkWords = SPILL_CHUNK_WORDS; spill->chunkWords >= SPILL_MIN_CHUNK_WORDS; spill->chunkWords /= 2)
+	{
+		spill->chunk = (uint64_t *)malloc(sizeof(uint64_t) * spill->chunkWords);
+		if (spill->chunk != NULL)
+			break;
+	}
+
+	writer.status = SOLVE_OUT_OF_MEMORY;
+	spill->file = (spill->chunk != NULL) ? tmpfile() : NULL;
+
+	if (spill->file == NULL)
+		goto spill_Fail;
+
+	writer.line = line;
+	writer.spill = spill;
+	writer.used = 0;
+	writer.offset = 0;
+	writer.andMask = ~0ULL;
+	writer.orMask = 0ULL;
+	writer.puzzle = puzzle;
+	writer.status = SOLVE_IN_PROGRESS;
+
+	spillFrom(&writer, 0, 0ULL, 0);
+
+	if (writer.used > 0)
+		flushChunk(&writer);
+
+	if (writer.status != SOLVE_IN_PROGRESS)
+		goto spill_Fail;
+
+	line->spill = spill;
+	line->appliedMaskBits = line->maskBits;
+
+	if (spill->count == 0)
+		return SOLVE_UNSATISFIABLE;
+
+	foldConsensus(line, writer.andMask, writer.orMask);
+
+	return SOLVE_IN_PROGRESS;
+
+spill_Fail:
+	freeSpill(spill);
+
+	return writer.status;
+}
+
+/*
+ * Streams a spilled line's permutations through the cells solved since the last pass,
+ * one chunk at a time: the survivors of each chunk are written back right after those of
+ * the chunks before (never past what has been read), then the file is truncated to them.
+ * The cells all survivors agree on are added to the line's solved cells.
+ *
+ * The puzzle's limits (see checkDeadline()) are polled after every chunk, a NULL puzzle
+ * sets none.
+ *
+ * Returns SOLVE_IN_PROGRESS, SOLVE_UNSATISFIABLE if no permutation is left, or
+ * SOLVE_OUT_OF_MEMORY if the file cannot be read, written or truncated, or the limit's
+ * status that stopped the pass. The spill is of no further use after those last two, the
+ * line's masks are left untouched.
+ */
+SolveStatus filterSpilledPermutations (Line * line, struct Puzzle * puzzle)
+{
+	PermutationSpill * spill = line->spill;
+	const int fd = fileno(spill->file);
+	const uint64_t mask = line->maskBits;
+	const uint64_t partial = line->partialBits & mask;
+	SolveStatus status;
+	uint64_t andMask = ~0ULL, orMask = 0ULL, remaining = spill->count, kept = 0, bits;
+	size_t i, words, survivors;
+	off_t readOffset = 0, writeOffset = 0;
+
+	if ((mask & ~(line->appliedMaskBits)) == 0ULL)
+		return (spill->count > 0) ? SOLVE_IN_PROGRESS : SOLVE_UNSATISFIABLE;
+
+	line->appliedMaskBits = mask;
+
+	while (remaining > 0)
+	{
+		words = (remaining < spill->chunkWords) ? (size_t)remaining : spill->chunkWords;
+
+		if (!transfer(fd, spill->chunk, words * sizeof(uint64_t), readOffset, FALSE))
+			return SOLVE_OUT_OF_MEMORY;
+
+		readOffset += (off_t)(words * sizeof(uint64_t));
+		remaining -= words;
+
+		for (i = 0, survivors = 0; i < words; ++i)
+		{
+			bits = spill->chunk[i];
+
+			if (((bits ^ partial) & mask) != 0ULL)
+				continue;
+
+			andMask &= bits;
+			orMask |= bits;
+			spill->chunk[survivors++] = bits;
+		}
+
+		if (survivors > 0 && !transfer(fd, spill->chunk, survivors * sizeof(uint64_t), writeOffset, TRUE))
+			return SOLVE_OUT_OF_MEMORY;
+
+		writeOffset += (off_t)(survivors * sizeof(uint64_t));
+		kept += survivors;
+
+		status = pollLimits(puzzle);
+		if (status != SOLVE_IN_PROGRESS)
+			return status;
+	}
+
+	spill->count = kept;
+
+	if (ftruncate(fd, writeOffset) != 0)
+		return SOLVE_OUT_OF_MEMORY;
+
+	if (kept == 0)
+		return SOLVE_UNSATISFIABLE;
+
+	foldConsensus(line, andMask, orMask);
+
+	return SOLVE_IN_PROGRESS;
+}
+
+/*
+ * Closes (and so removes) a spill's file and frees its chunk. Safe to call with NULL.
+ */
+void freeSpill (PermutationSpill * spill)
+{
+	if (spill == NULL) return;
+
+	if (spill->file != NULL)
+		fclose(spill->file);
+
+	free(spill->chunk);
+	free(spill);
+
+	return;
+}
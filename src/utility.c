@@ -27,6 +27,7 @@ LineClue * createLineClueSet(int * clueBuffer, int clueCount)
 
 	/* Initializing struct data elements */
 	lineClueSet->clueCount = clueCount;
+	lineClueSet->colours = NULL;
 	lineClueSet->clues = (int *)malloc(sizeof(int) * clueCount);
 
 	if (lineClueSet->clues == NULL)
@@ -42,6 +43,35 @@ LineClue * createLineClueSet(int * clueBuffer, int clueCount)
 	return lineClueSet;
 }
 
+/*
+ * createLineClueSet() for a colour puzzle's line, also copying the colour (1 based) of
+ * each clue from colourBuffer.
+ *
+ * Returns NULL if memory runs out.
+ */
+LineClue * createColourClueSet (int * clueBuffer, int * colourBuffer, int clueCount)
+{
+	int i;
+	LineClue * lineClueSet = createLineClueSet(clueBuffer, clueCount);
+
+	if (lineClueSet == NULL) return NULL;
+
+	/* At least one element, so an empty line still owns an array */
+	lineClueSet->colours = (int *)malloc(sizeof(int) * (clueCount + 1));
+
+	if (lineClueSet->colours == NULL)
+	{
+		free(lineClueSet->clues);
+		free(lineClueSet);
+		return NULL;
+	}
+
+	for (i = 0; i < clueCount; ++i)
+		lineClueSet->colours[i] = colourBuffer[i];
+
+	return lineClueSet;
+}
+
 /*
  * Prints detailed debugging information about a single Line.
  *
@@ -129,3 +159,24 @@ void printFormattedTime (long nano)
 
 	return;
 }
+
+/*
+ * Returns a short human readable description of a SolveStatus.
+ */
+const char * solveStatusName (SolveStatus status)
+{
+	switch (status)
+	{
+		case SOLVE_SOLVED: 			return "solved";
+		case SOLVE_IN_PROGRESS: 	return "in progress";
+		case SOLVE_INCOMPLETE: 		return "incomplete (line logic stalled)";
+		case SOLVE_UNSATISFIABLE: 	return "unsatisfiable";
+		case SOLVE_INVALID_INPUT: 	return "invalid input";
+		case SOLVE_OUT_OF_MEMORY: 	return "out of memory";
+		case SOLVE_TIMED_OUT: 		return "timed out";
+		case SOLVE_CANCELLED: 		return "cancelled";
+		case SOLVE_PAUSED: 			return "paused";
+	}
+
+	return "unknown";
+}
@@ -0,0 +1,207 @@
+#include "../include/verify.h"
+#include <string.h>
+#include "../include/solver.h"
+
+/*
+ * Checks candidate boards against a puzzle's clues without solving it. Boards are packed
+ * a row to a word (bit c of a row is column c), the columns transposed from the rows, so
+ * each line is checked in one pass over its word rather than cell by cell.
+ *
+ * Lines are numbered as the clues are: rows 0..length-1, then columns length.. .
+ */
+
+/*
+ * Returns TRUE if the filled cells of a size cell line read back as exactly its clues.
+ * Runs are extracted a word at a time: the trailing zero count skips to the next run and
+ * the trailing one count measures it.
+ */
+bool lineMatchesClues (uint64_t cells, int size, const LineClue * clueSet)
+{
+	int clueIndex = 0, run;
+
+	/* Nothing may be filled past the end of the line */
+	if (cells != 0ULL && 64 - __builtin_clzll(cells) > size)
+		return FALSE;
+
+	while (cells != 0ULL)
+	{
+		if (clueIndex == clueSet->clueCount)
+			return FALSE;
+
+		cells >>= __builtin_ctzll(cells);
+		run = (~cells == 0ULL) ? 64 : __builtin_ctzll(~cells);
+
+		if (run != clueSet->clues[clueIndex++])
+			return FALSE;
+
+		cells = (run == 64) ? 0ULL : cells >> run;
+	}
+
+	return clueIndex == clueSet->clueCount;
+}
+
+/*
+ * Packs a gameboard (1 filled, 0 empty, -1 unknown) a row to a word.
+ *
+ * Parameters:
+ * - gameBoard : The board, row major.
+ * - width, length : Its dimensions, width at most 64.
+ * - filled : Receives length words, bit c of word r set when cell (r, c) is filled.
+ * - known : Optional (may be NULL), receives length words, bit c of word r set when cell
+ *           (r, c) is solved.
+ */
+void packGameBoard (const int * gameBoard, int width, int length, uint64_t * filled, uint64_t * known)
+{
+	int row, column;
+	const int * cells = NULL;
+
+	for (row = 0; row < length; ++row)
+	{
+		cells = gameBoard + (size_t)row * width;
+		filled[row] = 0ULL;
+
+		if (known != NULL)
+			known[row] = 0ULL;
+
+		for (column = 0; column < width; ++column)
+		{
+			filled[row] |= (uint64_t)(cells[column] == 1) << column;
+
+			if (known != NULL)
+				known[row] |= (uint64_t)(cells[column] >= 0) << column;
+		}
+	}
+
+	return;
+}
+
+/* Bits of the cells of a size cell line */
+static uint64_t lineMask (int size)
+{
+	return (size == 64) ? ~0ULL : (1ULL << size) - 1ULL;
+}
+
+/*
+ * Transposes the set bits of length row words, within the first width bits and, when
+ * within is not NULL, the bits of its words, into width column words.
+ */
+static void transposeRows (const uint64_t * rows, const uint64_t * within, int width, int length, uint64_t * columns)
+{
+	int row;
+	uint64_t bits;
+
+	memset(columns, 0, sizeof(uint64_t) * width);
+
+	for (row = 0; row < length; ++row)
+		for (bits = rows[row] & lineMask(width) & ((within != NULL) ? within[row] : ~0ULL); bits != 0ULL; bits &= bits - 1)
+			columns[__builtin_ctzll(bits)] |= 1ULL << row;
+
+	return;
+}
+
+/*
+ * Checks a complete packed board against the clues (rows first, then columns).
+ *
+ * Parameters:
+ * - lineClues : The puzzle's clues, as readFile() returns them.
+ * - width, length : The board dimensions, each at most 64.
+ * - filled : length words, bit c of word r set when cell (r, c) is filled.
+ *
+ * Returns -1 if every line matches its clues, otherwise the first line that does not.
+ */
+int verifyPackedBoard (LineClue ** lineClues, int width, int length, const uint64_t * filled)
+{
+	int i;
+	uint64_t columns[64];
+
+	for (i = 0; i < length; ++i)
+		if (!lineMatchesClues(filled[i], width, lineClues[i]))
+			return i;
+
+	transposeRows(filled, NULL, width, length, columns);
+
+	for (i = 0; i < width; ++i)
+		if (!lineMatchesClues(columns[i], length, lineClues[length + i]))
+			return length + i;
+
+	return -1;
+}
+
+/*
+ * Returns TRUE if some placement of a line's clues agrees with its solved cells, matching
+ * the runs directly when every cell is solved.
+ */
+static bool lineConsistent (LineClue * clueSet, int size, uint64_t filled, uint64_t known)
+{
+	Line line;
+
+	if (known == lineMask(size))
+		return lineMatchesClues(filled, size, clueSet);
+
+	memset(&line, 0, sizeof(line));
+	line.clueSet = clueSet;
+	line.size = size;
+
+	return isLineFeasible(&line, known, filled);
+}
+
+/*
+ * Checks whether a partially solved packed board can still be completed line by line:
+ * every row and column must have some placement of its clues agreeing with its solved
+ * cells. Lines are checked independently, so a board passing this may still have no
+ * solution, but one failing it certainly has none.
+ *
+ * Parameters:
+ * - lineClues : The puzzle's clues, as readFile() returns them.
+ * - width, length : The board dimensions, each at most 64.
+ * - filled : length words, bit c of word r set when cell (r, c) is filled.
+ * - known : length words, bit c of word r set when cell (r, c) is solved, bits past the
+ *           width ignored.
+ *
+ * Returns -1 if every line is consistent, otherwise the first line that is not.
+ */
+int checkPackedBoard (LineClue ** lineClues, int width, int length, const uint64_t * filled, const uint64_t * known)
+{
+	int i;
+	uint64_t columnsFilled[64], columnsKnown[64];
+
+	/* Filled cells count only where solved, and nothing past the width */
+	for (i = 0; i < length; ++i)
+		if (!lineConsistent(lineClues[i], width, filled[i] & known[i] & lineMask(width), known[i] & lineMask(width)))
+			return i;
+
+	transposeRows(filled, known, width, length, columnsFilled);
+	transposeRows(known, NULL, width, length, columnsKnown);
+
+	for (i = 0; i < width; ++i)
+		if (!lineConsistent(lineClues[length + i], length, columnsFilled[i], columnsKnown[i]))
+			return length + i;
+
+	return -1;
+}
+
+/*
+ * verifyPackedBoard() for a complete gameboard (1 filled, 0 empty, row major); any cell
+ * other than 1 counts as empty.
+ */
+int verifyGameBoard (LineClue ** lineClues, int width, int length, const int * gameBoard)
+{
+	uint64_t filled[64];
+
+	packGameBoard(gameBoard, width, length, filled, NULL);
+
+	return verifyPackedBoard(lineClues, width, length, filled);
+}
+
+/*
+ * checkPackedBoard() for a partially solved gameboard (1 filled, 0 empty, -1 unknown,
+ * row major).
+ */
+int checkGameBoard (LineClue ** lineClues, int width, int length, const int * gameBoard)
+{
+	uint64_t filled[64], known[64];
+
+	packGameBoard(gameBoard, width, length, filled, known);
+
+	return checkPackedBoard(lineClues, width, length, filled, known);
+}
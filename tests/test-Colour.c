@@ -0,0 +1,220 @@
+#include "test-Colour.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/colour.h"
+#include "../include/fileIO.h"
+#include "../include/gameBoard.h"
+#include "../include/puzzle.h"
+#include "../include/solverAPI.h"
+
+#define COLOUR_30X25 "tests/testPuzzles/test-colour-30x25.txt"
+#define TEST_50X50 "tests/testPuzzles/test-50x50.txt"
+#define UNSAT_LINES "tests/testPuzzles/test-unsatisfiable-lines.txt"
+
+/*
+ * Counts the lines of a colour gameboard (0 background, k colour k) whose runs and their
+ * colours do not read back as the clues.
+ */
+static int colourMismatches (LineClue ** lineClues, int width, int length, const int * gameBoard)
+{
+	int i, cell, size, step, value, previous, run, clueIndex, mismatches = 0;
+	const int * cells = NULL;
+	bool match;
+
+	for (i = 0; i < width + length; ++i)
+	{
+		cells = (i < length) ? gameBoard + i * width : gameBoard + (i - length);
+		size = (i < length) ? width : length;
+		step = (i < length) ? 1 : width;
+		match = TRUE;
+		clueIndex = 0;
+		previous = 0;
+		run = 0;
+
+		/* One step past the end closes the last run */
+		for (cell = 0; cell <= size && match; ++cell)
+		{
+			value = (cell < size) ? cells[cell * step] : 0;
+
+			if (value == previous && value != 0)
+			{
+				++run;
+				continue;
+			}
+
+			if (previous != 0)
+				match = clueIndex < lineClues[i]->clueCount && lineClues[i]->clues[clueIndex] == run
+					&& ((lineClues[i]->colours != NULL) ? lineClues[i]->colours[clueIndex] : 1) == previous && ++clueIndex;
+
+			previous = value;
+			run = 1;
+		}
+
+		mismatches += !(match && clueIndex == lineClues[i]->clueCount);
+	}
+
+	return mismatches;
+}
+
+/*
+ * Colour clues parse with their colours, black and white files as one colour without
+ * them, and the black and white readers refuse colour files.
+ */
+int test_colourParse (void)
+{
+	int failures = 0, width = 0, length = 0, colours = 0;
+	char error[128] = "";
+	LineClue ** lineClues = NULL;
+	const char * text = "3 2 2\n1a 2b\n3\n2b\n1b\n1a 1b\n";
+
+	lineClues = readColourBuffer(text, strlen(text), &width, &length, &colours, error, sizeof(error));
+
+	if (lineClues == NULL || colours != 2 || lineClues[0]->colours == NULL || lineClues[0]->colours[1] != 2
+		|| lineClues[1]->colours[0] != 1 || lineClues[4]->clueCount != 2)
+	{
+		printf("Test Failure: test-ColourParse #1: Expected: 2 colours, \"1a 2b\" as colours 1 and 2, Actual: %s\n", error);
+		++failures;
+	}
+
+	freeLineClues(lineClues, width + length);
+
+	lineClues = readColourBuffer("1 1\n1\n1\n", 8, &width, &length, &colours, NULL, 0);
+
+	if (lineClues == NULL || colours != 1 || lineClues[0]->colours != NULL)
+	{
+		printf("Test Failure: test-ColourParse #2: Expected: a black and white file read as 1 colour\n");
+		++failures;
+	}
+
+	freeLineClues(lineClues, width + length);
+
+	if (readBuffer(text, strlen(text), &width, &length, error, sizeof(error)) != NULL
+		|| readColourBuffer("1 1 1\n1b\n1\n", 11, &width, &length, &colours, NULL, 0) != NULL
+		|| readColourBuffer("1 1 2\n1a1b\n1\n", 13, &width, &length, &colours, NULL, 0) != NULL)
+	{
+		printf("Test Failure: test-ColourParse #3: Expected: colour files refused by readBuffer(), bad colours refused\n");
+		++failures;
+	}
+
+	return failures;
+}
+
+/*
+ * A 5 cell line of "2a 2b" has 3 placements (aabb., aa.bb, .aabb): cell 1 is always a and
+ * cell 3 always b, and only cells 0, 2 and 4 can be background. Blocks of one colour need a gap, so "2a 2a" has only 1 placement.
+ */
+int test_colourLine (void)
+{
+	int failures = 0, clues[] = {2, 2}, colours[] = {1, 2}, same[] = {1, 1};
+	LineClue clueSet = {clues, 2, colours};
+	ColourLine line = {5, 2, &clueSet, NULL, 0};
+	uint64_t planes[3] = {0x1F, 0x1F, 0x1F};
+	const uint64_t solved[3] = {0x15, 0x07, 0x1C};
+
+	if (countColourPlacements(&line, planes) != 3.0 || !solveColourPlacements(&line, planes)
+		|| planes[1] != solved[1] || planes[2] != solved[2] || planes[0] != solved[0])
+	{
+		printf("Test Failure: test-ColourLine #1: Expected: planes {%#llx, %#llx, %#llx}, Actual: {%#llx, %#llx, %#llx}\n",
+			(unsigned long long)solved[0], (unsigned long long)solved[1], (unsigned long long)solved[2],
+			(unsigned long long)planes[0], (unsigned long long)planes[1], (unsigned long long)planes[2]);
+		++failures;
+	}
+
+	/* Stored permutations agree with the table, and filter down once cell 0 is background */
+	if (!enumerateColourPermutations(&line, planes) || line.permutationCount != 3)
+	{
+		printf("Test Failure: test-ColourLine #2: Expected: 3 permutations, Actual: %d\n", line.permutationCount);
+		++failures;
+	}
+
+	planes[1] &= ~1ULL;
+	planes[2] &= ~1ULL;
+
+	if (!filterColourPermutations(&line, planes) || line.permutationCount != 1 || planes[1] != 0x06 || planes[2] != 0x18)
+	{
+		printf("Test Failure: test-ColourLine #3: Expected: .aabb alone, Actual: %d permutations\n", line.permutationCount);
+		++failures;
+	}
+
+	/* Ruling b out of cell 4 leaves nothing */
+	planes[2] &= ~0x10ULL;
+
+	if (solveColourLine(&line, planes) || line.permutationCount != 1)
+	{
+		printf("Test Failure: test-ColourLine #4: Expected: no placement, permutations kept\n");
+		++failures;
+	}
+
+	free(line.permutations);
+
+	clueSet.colours = same;
+	planes[0] = planes[1] = planes[2] = 0x1F;
+
+	if (countColourPlacements(&line, planes) != 1.0)
+	{
+		printf("Test Failure: test-ColourLine #5: Expected: 1 placement of \"2a 2a\" in 5 cells\n");
+		++failures;
+	}
+
+	return failures;
+}
+
+/*
+ * Solves a four colour puzzle and a black and white one read as one colour, checking each
+ * against its clues, and rejects an unsatisfiable one.
+ */
+int test_colourPuzzles (void)
+{
+	int failures = 0, i, width = 0, length = 0, colours = 0, iterations = 0, mismatches;
+	int * gameBoard = NULL;
+	const char * files[] = {COLOUR_30X25, TEST_50X50};
+	LineClue ** lineClues = NULL;
+	ColourPuzzle * puzzle = NULL;
+	FILE * filePtr = NULL;
+	SolveStatus status;
+
+	for (i = 0; i < 2; ++i)
+	{
+		filePtr = fopen(files[i], "r");
+		if (filePtr == NULL)
+			return -1;
+
+		lineClues = readColourFile(filePtr, &width, &length, &colours);
+		fclose(filePtr);
+
+		if (lineClues == NULL || !validateColourClues(lineClues, width, length, colours)
+			|| (puzzle = createColourPuzzle(lineClues, width, length, colours)) == NULL)
+			return -1;
+
+		status = solveColourPuzzle(puzzle, NULL);
+		gameBoard = colourGameBoard(puzzle);
+		mismatches = (gameBoard != NULL) ? colourMismatches(lineClues, width, length, gameBoard) : -1;
+
+		if (status != SOLVE_SOLVED || mismatches != 0)
+		{
+			printf("Test Failure: test-ColourPuzzles #%d: %s %s, %d lines mismatched\n", i + 1, files[i], solveStatusName(status), mismatches);
+			++failures;
+		}
+
+		free(gameBoard);
+		freeColourPuzzle(puzzle);
+	}
+
+	filePtr = fopen(UNSAT_LINES, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	gameBoard = solveColourFile(filePtr, &width, &length, &colours, &iterations, &status, NULL);
+	fclose(filePtr);
+
+	if (gameBoard != NULL || status != SOLVE_UNSATISFIABLE)
+	{
+		printf("Test Failure: test-ColourPuzzles #3: Expected: %s unsatisfiable, Actual: %s\n", UNSAT_LINES, solveStatusName(status));
+		++failures;
+	}
+
+	free(gameBoard);
+
+	return failures;
+}
@@ -0,0 +1,10 @@
+#ifndef TEST_COLOUR_H
+#define TEST_COLOUR_H
+
+int test_colourParse (void);
+
+int test_colourLine (void);
+
+int test_colourPuzzles (void);
+
+#endif
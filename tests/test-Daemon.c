@@ -0,0 +1,174 @@
+#define _POSIX_C_SOURCE 200809L
+#include "test-Daemon.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/daemon.h"
+
+#define DAEMON_SOCKET "build/test-daemon.sock"
+
+/* Requests and the start of the response each should get (responses may come in any order) */
+static const char * requests = "a 2 2;2;1;2;1\nstats\n\nb 2 x\nc 2 2;1;1;2;1\nd 1 1;;;\n";
+static const char * expected[] = {"a solved ", "stats uptime_ms=", "b invalid-input ", "c unsatisfiable ", "d solved "};
+static const char * boards[] = {" ##;#.\n", NULL, NULL, " -\n", " .\n"};
+
+/*
+ * Counts the expected responses missing from output, each matched by its prefix and, for
+ * a board, its ending.
+ */
+static int missingResponses (const char * output)
+{
+	int i, missing = 0;
+	const char * line = NULL, * end = NULL;
+
+	for (i = 0; i < 5; ++i)
+	{
+		for (line = output; line != NULL && *line != '\0'; line = (end != NULL) ? end + 1 : NULL)
+		{
+			end = strchr(line, '\n');
+
+			if (strncmp(line, expected[i], strlen(expected[i])) != 0)
+				continue;
+
+			if (boards[i] == NULL || (end != NULL && (size_t)(end + 1 - line) >= strlen(boards[i])
+				&& strncmp(end + 1 - strlen(boards[i]), boards[i], strlen(boards[i])) == 0))
+				break;
+		}
+
+		if (line == NULL || *line == '\0')
+		{
+			printf("Test Failure: test-Daemon: no response \"%s\"\n", expected[i]);
+			++missing;
+		}
+	}
+
+	return missing;
+}
+
+/*
+ * Requests on a pipe, responses in a file: each request is answered once, blank lines
+ * are skipped.
+ */
+int test_daemon_requests (void)
+{
+	int failures = 0, pipeFds[2], result;
+	char output[2048];
+	size_t size;
+	FILE * outputFile = tmpfile();
+
+	if (outputFile == NULL || pipe(pipeFds) != 0)
+		return 1;
+
+	if (write(pipeFds[1], requests, strlen(requests)) != (ssize_t)strlen(requests))
+		return 1;
+
+	close(pipeFds[1]);
+
+	result = runDaemon(pipeFds[0], fileno(outputFile), NULL, SEARCH_CDCL);
+	close(pipeFds[0]);
+
+	rewind(outputFile);
+	size = fread(output, 1, sizeof(output) - 1, outputFile);
+	output[size] = '\0';
+	fclose(outputFile);
+
+	if (result != 0)
+	{
+		printf("Test Failure: test_daemon_requests #1: Expected: 0, Actual: %d\n", result);
+		++failures;
+	}
+
+	failures += missingResponses(output);
+
+	return failures;
+}
+
+typedef struct SocketServer {
+	SolveOptions options;
+	int result;
+} SocketServer;
+
+static void * serveSocket (void * arg)
+{
+	SocketServer * server = (SocketServer *)arg;
+
+	server->result = runSocketDaemon(DAEMON_SOCKET, &server->options, SEARCH_PARALLEL);
+
+	return NULL;
+}
+
+/*
+ * Two clients of the socket daemon in turn each get their answers and an end of stream
+ * once they stop sending, then the cancel flag stops the daemon.
+ */
+int test_daemon_socket (void)
+{
+	int failures = 0, client, attempt, fd = -1, connected;
+	char output[2048];
+	size_t size;
+	ssize_t received;
+	struct sockaddr_un address;
+	struct timespec pause = { 0, 10000000L };
+	atomic_bool stop = FALSE;
+	SocketServer server = { { 0, 0, &stop, NULL, NULL, 0, 0 }, -1 };
+	pthread_t thread;
+
+	if (pthread_create(&thread, NULL, serveSocket, &server) != 0)
+		return 1;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, DAEMON_SOCKET);
+
+	for (client = 0; client < 2; ++client)
+	{
+		/* The daemon may not be listening yet */
+		for (attempt = 0, connected = -1; attempt < 200 && connected != 0; ++attempt)
+		{
+			fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			connected = (fd < 0) ? -1 : connect(fd, (struct sockaddr *)&address, sizeof(address));
+
+			if (connected != 0)
+			{
+				if (fd >= 0)
+					close(fd);
+
+				nanosleep(&pause, NULL);
+			}
+		}
+
+		if (connected != 0)
+		{
+			printf("Test Failure: test_daemon_socket #1: cannot connect\n");
+			++failures;
+			break;
+		}
+
+		if (write(fd, requests, strlen(requests)) != (ssize_t)strlen(requests))
+			++failures;
+
+		shutdown(fd, SHUT_WR);
+
+		for (size = 0; size < sizeof(output) - 1 && (received = read(fd, output + size, sizeof(output) - 1 - size)) > 0; size += (size_t)received);
+		output[size] = '\0';
+		close(fd);
+
+		failures += missingResponses(output);
+	}
+
+	atomic_store(&stop, TRUE);
+	pthread_join(thread, NULL);
+
+	if (server.result != 0 || access(DAEMON_SOCKET, F_OK) == 0)
+	{
+		printf("Test Failure: test_daemon_socket #2: Expected: 0 and the socket removed, Actual: %d\n", server.result);
+		++failures;
+	}
+
+	return failures;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_DAEMON_H
+#define TEST_DAEMON_H
+
+int test_daemon_requests (void);
+
+int test_daemon_socket (void);
+
+#endif
@@ -1,7 +1,15 @@
 #include "test-FullPuzzles.h"
 #include <stdlib.h>
+#include <string.h>
+#include "../include/batch.h"
+#include "../include/estimate.h"
+#include "../include/fileIO.h"
 #include "../include/gameBoard.h"
+#include "../include/lineSolve.h"
+#include "../include/parallel.h"
+#include "../include/puzzle.h"
 #include "../include/solverAPI.h"
+#include "../include/verify.h"
 
 #define TEST1 "tests/testPuzzles/test-10x10.txt"
 #define TEST1_SOLUTION "tests/testPuzzles/test-10x10-solution.txt"
@@ -11,6 +19,14 @@
 #define TEST3_SOLUTION "tests/testPuzzles/test-30x30-solution.txt"
 #define TEST4 "tests/testPuzzles/test-50x50.txt"
 #define TEST4_SOLUTION "tests/testPuzzles/test-50x50-solution.txt"
+#define TEST5 "tests/testPuzzles/test-15x15-probing.txt"
+#define TEST5_SOLUTION "tests/testPuzzles/test-15x15-probing-solution.txt"
+#define UNSAT_TOTALS "tests/testPuzzles/test-unsatisfiable-totals.txt"
+#define UNSAT_LINES "tests/testPuzzles/test-unsatisfiable-lines.txt"
+#define INVALID_SIZE "tests/testPuzzles/test-invalid-size.txt"
+#define SEARCH_AMBIGUOUS "tests/testPuzzles/test-2x2-ambiguous.txt"
+#define SEARCH_20X20 "tests/testPuzzles/test-20x20-search.txt"
+#define WIDE_64X3 "tests/testPuzzles/test-64x3-wide.txt"
 
 int test_fullPuzzles ()
 {
@@ -24,7 +40,7 @@ int test_fullPuzzles ()
 	if (filePtr == NULL)
 		return -1;
 
-	actualSolution = solvePuzzle(filePtr, 1, &iterations);
+	actualSolution = solvePuzzle(filePtr, 1, &iterations, NULL);
 	fclose(filePtr);
 
 	filePtr = fopen(TEST1_SOLUTION, "r");
@@ -55,7 +71,7 @@ int test_fullPuzzles ()
 	if (filePtr == NULL)
 		return -1;
 
-	actualSolution = solvePuzzle(filePtr, 1, &iterations);
+	actualSolution = solvePuzzle(filePtr, 1, &iterations, NULL);
 	fclose(filePtr);
 
 	filePtr = fopen(TEST2_SOLUTION, "r");
@@ -86,7 +102,7 @@ int test_fullPuzzles ()
 	if (filePtr == NULL)
 		return -1;
 
-	actualSolution = solvePuzzle(filePtr, 1, &iterations);
+	actualSolution = solvePuzzle(filePtr, 1, &iterations, NULL);
 	fclose(filePtr);
 
 	filePtr = fopen(TEST3_SOLUTION, "r");
@@ -117,7 +133,7 @@ int test_fullPuzzles ()
 	if (filePtr == NULL)
 		return -1;
 
-	actualSolution = solvePuzzle(filePtr, 1, &iterations);
+	actualSolution = solvePuzzle(filePtr, 1, &iterations, NULL);
 	fclose(filePtr);
 
 	filePtr = fopen(TEST4_SOLUTION, "r");
@@ -142,9 +158,993 @@ int test_fullPuzzles ()
 		++failures;
 	}
 
+	/* Test 5 15x15 Puzzle, stalls line logic and needs probing */
+	filePtr = fopen(TEST5, "r");
+
+	if (filePtr == NULL)
+		return -1;
+
+	actualSolution = solvePuzzle(filePtr, 1, &iterations, NULL);
+	fclose(filePtr);
+
+	filePtr = fopen(TEST5_SOLUTION, "r");
+	if (filePtr == NULL)
+		return -1;
+	
+	expectedSolution = generateSolutionGameBoard(filePtr, 15, 15);
+	difference = (actualSolution == NULL) ? 1 : compareGameBoards(expectedSolution, actualSolution, 225);
+
+	free(expectedSolution);
+	expectedSolution = NULL;
+
+	free(actualSolution);
+	actualSolution = NULL;
+	
+	fclose(filePtr);
+	filePtr = NULL;
+
+	if (difference != 0)
+	{
+		printf("Test Failure: test-FullPuzzles #5: 15x15 probing\n");
+		++failures;
+	}
+
+	return failures;
+}
+
+int test_unsolvablePuzzles ()
+{
+	int failures = 0, i, iterations = 0;
+	int * actualSolution = NULL;
+	FILE * filePtr = NULL;
+	SolveStatus status;
+	const char * files[] = {UNSAT_TOTALS, UNSAT_LINES, INVALID_SIZE};
+	const SolveStatus expected[] = {SOLVE_UNSATISFIABLE, SOLVE_UNSATISFIABLE, SOLVE_INVALID_INPUT};
+
+	for (i = 0; i < 3; ++i)
+	{
+		filePtr = fopen(files[i], "r");
+
+		if (filePtr == NULL)
+			return -1;
+
+		actualSolution = solvePuzzle(filePtr, 1, &iterations, &status);
+		fclose(filePtr);
+		filePtr = NULL;
+
+		if (status != expected[i] || actualSolution != NULL)
+		{
+			printf("Test Failure: test-UnsolvablePuzzles #%d: Expected: %s, Actual: %s\n", i + 1,
+				solveStatusName(expected[i]), solveStatusName(status));
+			++failures;
+		}
+
+		free(actualSolution);
+		actualSolution = NULL;
+	}
+
+	return failures;
+}
+
+/*
+ * Solve bounds: a permutation budget too small for any line still solves the puzzle
+ * (without enumerating), a raised cancel flag or a passed deadline stop it.
+ */
+int test_solveOptions ()
+{
+	int failures = 0, iterations = 0, width = 0, length = 0, i;
+	int * expectedSolution = NULL, * actualSolution = NULL;
+	atomic_bool cancel = TRUE;
+	SolveOptions options = { 0, 1, NULL, NULL, NULL, 0, 0 };
+	LineClue ** lineClues = NULL;
+	Puzzle * puzzle = NULL;
+	SolveStatus status;
+	FILE * filePtr = fopen(TEST5, "r");
+
+	if (filePtr == NULL)
+		return -1;
+
+	actualSolution = solvePuzzleWithOptions(filePtr, 1, &iterations, &status, &options);
+	fclose(filePtr);
+
+	filePtr = fopen(TEST5_SOLUTION, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	expectedSolution = generateSolutionGameBoard(filePtr, 15, 15);
+	fclose(filePtr);
+
+	if (status != SOLVE_SOLVED || compareGameBoards(expectedSolution, actualSolution, 225) != 0)
+	{
+		printf("Test Failure: test-SolveOptions #1: 1 byte budget, %s\n", solveStatusName(status));
+		++failures;
+	}
+
+	free(expectedSolution);
+	expectedSolution = NULL;
+
+	free(actualSolution);
+	actualSolution = NULL;
+
+	/* Within the budget no line is enumerated */
+	filePtr = fopen(TEST5, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	puzzle = (lineClues != NULL) ? createPuzzle(lineClues, width, length) : NULL;
+	if (puzzle == NULL)
+		return -1;
+
+	setSolveOptions(puzzle, &options);
+	propagatePuzzle(puzzle);
+
+	for (i = 0; i < width + length && puzzle->lines[i]->bitSet == NULL; ++i);
+
+	if (i < width + length || puzzle->permutationBytes != 0)
+	{
+		printf("Test Failure: test-SolveOptions #2: line %d enumerated\n", i);
+		++failures;
+	}
+
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
+	/* Cancelled before the first line, the untouched board still comes back */
+	options.permutationBytes = 0;
+	options.cancel = &cancel;
+
+	filePtr = fopen(TEST1, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	actualSolution = solvePuzzleWithOptions(filePtr, 1, &iterations, &status, &options);
+	fclose(filePtr);
+
+	if (status != SOLVE_CANCELLED || actualSolution == NULL || actualSolution[0] != -1)
+	{
+		printf("Test Failure: test-SolveOptions #3: Expected: cancelled, Actual: %s\n", solveStatusName(status));
+		++failures;
+	}
+
+	free(actualSolution);
+	actualSolution = NULL;
+
+	filePtr = fopen(TEST1, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	puzzle = (lineClues != NULL) ? createPuzzle(lineClues, width, length) : NULL;
+	if (puzzle == NULL)
+		return -1;
+
+	/* A deadline long gone */
+	puzzle->deadline = 1;
+	status = propagatePuzzle(puzzle);
+
+	if (status != SOLVE_TIMED_OUT)
+	{
+		printf("Test Failure: test-SolveOptions #4: Expected: timed out, Actual: %s\n", solveStatusName(status));
+		++failures;
+	}
+
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
 	return failures;
 }
 
+typedef struct ContextTask {
+	const char * text;
+	size_t size;
+	int * expected;
+	int mismatches;
+} ContextTask;
+
+/*
+ * ParallelTask: solves the shared puzzle text with a context of its own.
+ */
+static void solveWithContext (void * arg, int index)
+{
+	ContextTask * task = (ContextTask *)arg + index;
+	SolverContext * context = createSolverContext(NULL, (index % 2 == 0) ? SEARCH_CDCL : SEARCH_PARALLEL);
+	const SolveResult * result = NULL;
+
+	task->mismatches = 1;
+
+	if (context == NULL)
+		return;
+
+	result = solveBuffer(context, task->text, task->size);
+
+	if (result->status == SOLVE_SOLVED && result->gameBoard != NULL)
+		task->mismatches = compareGameBoards(task->expected, result->gameBoard, result->width * result->length);
+
+	freeSolverContext(context);
+
+	return;
+}
+
+/*
+ * The reentrant API: puzzles from memory buffers and clue arrays, parse errors reported
+ * in the result, and contexts solving side by side on several threads.
+ */
+int test_solverContext ()
+{
+	int failures = 0, i;
+	char text[4096];
+	size_t size;
+	int * expectedSolution = NULL;
+	const int rowTop[] = {2}, rowBottom[] = {1}, columnLeft[] = {2}, columnRight[] = {1};
+	const int * clues[] = {rowTop, rowBottom, columnLeft, columnRight};
+	const int clueCounts[] = {1, 1, 1, 1}, expectedClues[] = {1, 1, 1, 0};
+	ContextTask tasks[4];
+	SolverContext * context = NULL;
+	const SolveResult * result = NULL;
+	FILE * filePtr = fopen(TEST2, "r");
+
+	if (filePtr == NULL)
+		return -1;
+
+	size = fread(text, 1, sizeof(text), filePtr);
+	fclose(filePtr);
+
+	filePtr = fopen(TEST2_SOLUTION, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	expectedSolution = generateSolutionGameBoard(filePtr, 20, 20);
+	fclose(filePtr);
+
+	context = createSolverContext(NULL, SEARCH_CDCL);
+	if (context == NULL || expectedSolution == NULL)
+		return -1;
+
+	result = solveBuffer(context, text, size);
+
+	if (result->status != SOLVE_SOLVED || result->width != 20 || result->length != 20 || result->elapsedNanos <= 0
+		|| compareGameBoards(expectedSolution, result->gameBoard, 400) != 0)
+	{
+		printf("Test Failure: test-SolverContext #1: 20x20 from memory, %s\n", solveStatusName(result->status));
+		++failures;
+	}
+
+	/* A parse error comes back in the result instead of on a stream */
+	result = solveBuffer(context, "20 x\n", 5);
+
+	if (result->status != SOLVE_INVALID_INPUT || result->gameBoard != NULL || result->error[0] == '\0')
+	{
+		printf("Test Failure: test-SolverContext #2: Expected: invalid input, Actual: %s\n", solveStatusName(result->status));
+		++failures;
+	}
+
+	/* Only the first size bytes are read: the clue lines are cut off */
+	result = solveBuffer(context, text, 10);
+
+	if (result->status != SOLVE_INVALID_INPUT)
+	{
+		printf("Test Failure: test-SolverContext #3: Expected: invalid input, Actual: %s\n", solveStatusName(result->status));
+		++failures;
+	}
+
+	result = solveClues(context, 2, 2, clues, clueCounts);
+
+	if (result->status != SOLVE_SOLVED || compareGameBoards((int *)expectedClues, result->gameBoard, 4) != 0)
+	{
+		printf("Test Failure: test-SolverContext #4: clue arrays, %s\n", solveStatusName(result->status));
+		++failures;
+	}
+
+	freeSolverContext(context);
+	context = NULL;
+
+	for (i = 0; i < 4; ++i)
+	{
+		tasks[i].text = text;
+		tasks[i].size = size;
+		tasks[i].expected = expectedSolution;
+	}
+
+	runParallel(solveWithContext, tasks, 4);
+
+	for (i = 0; i < 4; ++i)
+	{
+		if (tasks[i].mismatches != 0)
+		{
+			printf("Test Failure: test-SolverContext #5: context %d\n", i);
+			++failures;
+		}
+	}
+
+	free(expectedSolution);
+	expectedSolution = NULL;
+
+	return failures;
+}
+
+/*
+ * Step-wise solves: puzzles that need propagation only, probing and search each finish
+ * under the smallest budget, interleaved on one thread, and match a solve run through.
+ */
+int test_stepSolve ()
+{
+	int failures = 0, i, active;
+	long steps[3] = {0, 0, 0};
+	char texts[3][4096];
+	size_t sizes[3];
+	const char * files[] = {TEST2, TEST5, SEARCH_20X20};
+	SolverContext * contexts[3] = {NULL, NULL, NULL};
+	const SolveResult * results[3];
+	SolverContext * reference = createSolverContext(NULL, SEARCH_CDCL);
+	const SolveResult * result = NULL, * expected = NULL;
+	FILE * filePtr = NULL;
+
+	for (i = 0; i < 3; ++i)
+	{
+		filePtr = fopen(files[i], "r");
+		contexts[i] = createSolverContext(NULL, SEARCH_CDCL);
+
+		if (filePtr == NULL || contexts[i] == NULL || reference == NULL)
+			return -1;
+
+		sizes[i] = fread(texts[i], 1, sizeof(texts[i]), filePtr);
+		fclose(filePtr);
+
+		result = results[i] = beginSolve(contexts[i], texts[i], sizes[i]);
+
+		if (result->status != SOLVE_PAUSED)
+		{
+			printf("Test Failure: test-StepSolve #1: Expected: paused, Actual: %s\n", solveStatusName(result->status));
+			++failures;
+		}
+	}
+
+	/* Round robin, one unit of work each */
+	do {
+		active = 0;
+
+		for (i = 0; i < 3; ++i)
+		{
+			if (results[i]->status != SOLVE_PAUSED)
+				continue;
+
+			++steps[i];
+			++active;
+			stepSolve(contexts[i], 1, 0);
+		}
+	} while (active > 0);
+
+	for (i = 0; i < 3; ++i)
+	{
+		result = results[i];
+		expected = solveBuffer(reference, texts[i], sizes[i]);
+
+		if (result->status != SOLVE_SOLVED || steps[i] < 2 || result->gameBoard == NULL
+			|| (i < 2 && compareGameBoards(expected->gameBoard, result->gameBoard, result->width * result->length) != 0)
+			|| (i == 2 && clueMismatches(files[i], result->gameBoard) != 0))
+		{
+			printf("Test Failure: test-StepSolve #2: %s after %ld steps, %s\n", files[i], steps[i], solveStatusName(result->status));
+			++failures;
+		}
+
+		freeSolverContext(contexts[i]);
+		contexts[i] = NULL;
+	}
+
+	/* A time slice still advances by a unit, and a finished solve stays finished */
+	result = beginSolve(reference, texts[1], sizes[1]);
+
+	while (result->status == SOLVE_PAUSED)
+		result = stepSolve(reference, 0, 1);
+
+	result = stepSolve(reference, 1, 0);
+
+	if (result->status != SOLVE_SOLVED || result->gameBoard == NULL)
+	{
+		printf("Test Failure: test-StepSolve #3: Expected: solved, Actual: %s\n", solveStatusName(result->status));
+		++failures;
+	}
+
+	freeSolverContext(reference);
+	reference = NULL;
+
+	return failures;
+}
+
+/*
+ * Checks the shipped solutions with the verifier, then boards it must reject: a flipped
+ * cell, and partial boards with and without a line left no placement.
+ */
+int test_verifyBoard (void)
+{
+	int failures = 0, i, cell, width = 0, length = 0, line;
+	int * gameBoard = NULL;
+	LineClue ** lineClues = NULL;
+	FILE * filePtr = NULL;
+	const char * puzzles[] = {TEST1, TEST2, TEST3, TEST4, TEST5};
+	const char * solutions[] = {TEST1_SOLUTION, TEST2_SOLUTION, TEST3_SOLUTION, TEST4_SOLUTION, TEST5_SOLUTION};
+	int runClues[] = {3, 1};
+	LineClue runClueSet = {runClues, 2, NULL};
+
+	/* Cells 1-3 and 5 */
+	if (!lineMatchesClues(0x2EULL, 6, &runClueSet) || lineMatchesClues(0x2EULL, 5, &runClueSet) || lineMatchesClues(0x6EULL, 7, &runClueSet))
+	{
+		printf("Test Failure: test-VerifyBoard #1: Expected: {3, 1} to match 0x2e on 6 cells only\n");
+		++failures;
+	}
+
+	for (i = 0; i < 5; ++i)
+	{
+		filePtr = fopen(puzzles[i], "r");
+		if (filePtr == NULL)
+			return -1;
+
+		lineClues = readFile(filePtr, &width, &length);
+		fclose(filePtr);
+
+		filePtr = fopen(solutions[i], "r");
+		if (filePtr == NULL || lineClues == NULL)
+			return -1;
+
+		gameBoard = readGameBoard(filePtr, width, length);
+		fclose(filePtr);
+
+		if (gameBoard == NULL || verifyGameBoard(lineClues, width, length, gameBoard) != -1
+			|| checkGameBoard(lineClues, width, length, gameBoard) != -1)
+		{
+			printf("Test Failure: test-VerifyBoard #2: Expected: %s to verify\n", solutions[i]);
+			++failures;
+		}
+
+		if (gameBoard == NULL)
+		{
+			freeLineClues(lineClues, width + length);
+			continue;
+		}
+
+		/* A flipped cell breaks its row first */
+		cell = (length / 2) * width + width / 2;
+		gameBoard[cell] = 1 - gameBoard[cell];
+
+		if ((line = verifyGameBoard(lineClues, width, length, gameBoard)) != length / 2)
+		{
+			printf("Test Failure: test-VerifyBoard #3: %s Expected: row %d, Actual: %d\n", solutions[i], length / 2, line);
+			++failures;
+		}
+
+		/* Unknown cells everywhere but a checkerboard of the solution */
+		gameBoard[cell] = 1 - gameBoard[cell];
+		for (cell = 0; cell < width * length; ++cell)
+			if ((cell / width + cell % width) % 2 == 0)
+				gameBoard[cell] = -1;
+
+		if ((line = checkGameBoard(lineClues, width, length, gameBoard)) != -1)
+		{
+			printf("Test Failure: test-VerifyBoard #4: %s Expected: consistent, Actual: line %d\n", solutions[i], line);
+			++failures;
+		}
+
+		/* A first row all filled fits no clue but a full row */
+		for (cell = 0; cell < width * length; ++cell)
+			gameBoard[cell] = (cell < width) ? 1 : -1;
+
+		line = checkGameBoard(lineClues, width, length, gameBoard);
+		if (line != ((lineClues[0]->clueCount == 1 && lineClues[0]->clues[0] == width) ? -1 : 0))
+		{
+			printf("Test Failure: test-VerifyBoard #5: %s Actual: line %d\n", solutions[i], line);
+			++failures;
+		}
+
+		free(gameBoard);
+		gameBoard = NULL;
+
+		freeLineClues(lineClues, width + length);
+		lineClues = NULL;
+	}
+
+	return failures;
+}
+
+#define BATCH_TEST_WIDTH 8
+#define BATCH_TEST_LENGTH 6
+#define BATCH_TEST_COUNT 70
+
+/*
+ * Solves more puzzles than a group of lanes holds in one batch: boards drawn from a fixed
+ * generator, one whose clues contradict, one only search can finish and one with an
+ * invalid clue. Every solution must match its clues.
+ */
+int test_solveBatch (void)
+{
+	int failures = 0, p, i, j, line, run, size, scalarCount;
+	int clues[BATCH_TEST_COUNT][BATCH_TEST_WIDTH + BATCH_TEST_LENGTH][BATCH_TEST_WIDTH];
+	int clueCounts[BATCH_TEST_COUNT][BATCH_TEST_WIDTH + BATCH_TEST_LENGTH];
+	const int * cluePointers[BATCH_TEST_COUNT][BATCH_TEST_WIDTH + BATCH_TEST_LENGTH];
+	BatchPuzzle puzzles[BATCH_TEST_COUNT];
+	BatchResult * results = (BatchResult *)malloc(sizeof(BatchResult) * BATCH_TEST_COUNT);
+	SolverContext * context = createSolverContext(NULL, SEARCH_CDCL);
+	unsigned int seed = 12345;
+	uint64_t cells, board[BATCH_TEST_LENGTH];
+	LineClue clueSet;
+
+	if (results == NULL || context == NULL)
+	{
+		free(results);
+		freeSolverContext(context);
+		return 1;
+	}
+
+	for (p = 0; p < BATCH_TEST_COUNT; ++p)
+	{
+		for (i = 0; i < BATCH_TEST_LENGTH; ++i)
+		{
+			seed = seed * 1103515245U + 12345U;
+			board[i] = (seed >> 8) & ((1ULL << BATCH_TEST_WIDTH) - 1);
+		}
+
+		/* Only cells (0, 0), (0, 1), (1, 0) and (1, 1) can hold the two filled cells */
+		if (p == 1)
+		{
+			board[0] = 1ULL;
+			board[1] = 2ULL;
+			for (i = 2; i < BATCH_TEST_LENGTH; ++i)
+				board[i] = 0ULL;
+		}
+
+		for (line = 0; line < BATCH_TEST_WIDTH + BATCH_TEST_LENGTH; ++line)
+		{
+			size = (line < BATCH_TEST_LENGTH) ? BATCH_TEST_WIDTH : BATCH_TEST_LENGTH;
+			clueCounts[p][line] = 0;
+			run = 0;
+
+			for (j = 0; j <= size; ++j)
+			{
+				if (j < size && ((line < BATCH_TEST_LENGTH) ? board[line] >> j : board[j] >> (line - BATCH_TEST_LENGTH)) & 1ULL)
+					++run;
+
+				else if (run > 0)
+				{
+					clues[p][line][clueCounts[p][line]++] = run;
+					run = 0;
+				}
+			}
+
+			cluePointers[p][line] = clues[p][line];
+		}
+
+		puzzles[p].clues = cluePointers[p];
+		puzzles[p].clueCounts = clueCounts[p];
+	}
+
+	/* A full first row no column allows, and a clue of 0 */
+	clues[0][0][0] = BATCH_TEST_WIDTH;
+	clueCounts[0][0] = 1;
+	clues[2][0][0] = 0;
+	clueCounts[2][0] = 1;
+
+	scalarCount = solveBatch(context, BATCH_TEST_WIDTH, BATCH_TEST_LENGTH, puzzles, results, BATCH_TEST_COUNT);
+
+	if (scalarCount < 2 || results[0].status != SOLVE_UNSATISFIABLE || results[2].status != SOLVE_INVALID_INPUT
+		|| results[1].status != SOLVE_SOLVED || !results[1].searched)
+	{
+		printf("Test Failure: test-SolveBatch #1: %d scalar, statuses %s, %s, %s\n", scalarCount,
+			solveStatusName(results[0].status), solveStatusName(results[1].status), solveStatusName(results[2].status));
+		++failures;
+	}
+
+	for (p = 1; p < BATCH_TEST_COUNT; ++p)
+	{
+		if (p == 2)
+			continue;
+
+		if (results[p].status != SOLVE_SOLVED)
+		{
+			printf("Test Failure: test-SolveBatch #2: Puzzle %d Expected: solved, Actual: %s\n", p, solveStatusName(results[p].status));
+			++failures;
+			continue;
+		}
+
+		for (line = 0; line < BATCH_TEST_WIDTH + BATCH_TEST_LENGTH; ++line)
+		{
+			cells = 0ULL;
+			for (j = 0; line >= BATCH_TEST_LENGTH && j < BATCH_TEST_LENGTH; ++j)
+				cells |= ((results[p].rows[j] >> (line - BATCH_TEST_LENGTH)) & 1ULL) << j;
+
+			clueSet.clues = clues[p][line];
+			clueSet.clueCount = clueCounts[p][line];
+
+			if (!lineMatchesClues((line < BATCH_TEST_LENGTH) ? results[p].rows[line] : cells,
+				(line < BATCH_TEST_LENGTH) ? BATCH_TEST_WIDTH : BATCH_TEST_LENGTH, &clueSet))
+			{
+				printf("Test Failure: test-SolveBatch #3: Puzzle %d line %d does not match its clues\n", p, line);
+				++failures;
+				break;
+			}
+		}
+	}
+
+	if (solveBatch(context, BATCH_MAX_SIZE + 1, BATCH_TEST_LENGTH, puzzles, results, 1) != -1)
+	{
+		printf("Test Failure: test-SolveBatch #4: Expected: -1 for a width over %d\n", BATCH_MAX_SIZE);
+		++failures;
+	}
+
+	free(results);
+	freeSolverContext(context);
+
+	return failures;
+}
+
+/*
+ * Estimates: the rules solve the stock puzzles outright, the search puzzle leaves lines to
+ * enumerate, and contradictory clues or text are rejected.
+ */
+int test_estimatePuzzle (void)
+{
+	int failures = 0, i, width = 0, length = 0;
+	double lineCounts[2 * MAX_LINE_SIZE], sum = 0.0;
+	char error[128] = "";
+	LineClue ** lineClues = NULL;
+	FILE * filePtr = NULL;
+	PuzzleEstimate estimate;
+	const char * unsatisfiable = "3 3\n3\n3\n1\n3\n3\n1\n";
+
+	filePtr = fopen(TEST4, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	if (lineClues == NULL)
+		return -1;
+
+	if (!estimateClues(lineClues, width, length, &estimate, NULL) || estimate.openLines != 0 || estimate.risk != RISK_TRIVIAL)
+	{
+		printf("Test Failure: test-EstimatePuzzle #1: Expected: %s trivial, Actual: %d open lines, %s\n",
+			TEST4, estimate.openLines, riskClassName(estimate.risk));
+		++failures;
+	}
+
+	freeLineClues(lineClues, width + length);
+
+	filePtr = fopen(SEARCH_20X20, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	if (lineClues == NULL)
+		return -1;
+
+	if (!estimateClues(lineClues, width, length, &estimate, lineCounts) || estimate.openLines == 0 || estimate.largestLine < 0)
+	{
+		printf("Test Failure: test-EstimatePuzzle #2: Expected: %s to leave open lines\n", SEARCH_20X20);
+		++failures;
+	}
+
+	else
+	{
+		for (i = 0; i < width + length; ++i)
+			sum += lineCounts[i];
+
+		if (sum != estimate.totalPlacements || lineCounts[estimate.largestLine] != estimate.largestPlacements)
+		{
+			printf("Test Failure: test-EstimatePuzzle #3: Expected: %g placements, Actual: %g\n", estimate.totalPlacements, sum);
+			++failures;
+		}
+	}
+
+	freeLineClues(lineClues, width + length);
+
+	filePtr = fopen(UNSAT_TOTALS, "r");
+	if (filePtr == NULL)
+		return -1;
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	if (lineClues != NULL && estimateClues(lineClues, width, length, &estimate, NULL))
+	{
+		printf("Test Failure: test-EstimatePuzzle #4: Expected: %s rejected\n", UNSAT_TOTALS);
+		++failures;
+	}
+
+	if (lineClues != NULL)
+		freeLineClues(lineClues, width + length);
+
+	/* Totals agree, but the full rows overfill the last column */
+	if (estimateBuffer(unsatisfiable, strlen(unsatisfiable), &estimate, error, sizeof(error)) || error[0] == '\0')
+	{
+		printf("Test Failure: test-EstimatePuzzle #5: Expected: contradictory clues rejected\n");
+		++failures;
+	}
+
+	if (estimateBuffer("2 x\n", 4, &estimate, NULL, 0) || estimate.largestLine != -1)
+	{
+		printf("Test Failure: test-EstimatePuzzle #6: Expected: bad text rejected\n");
+		++failures;
+	}
+
+	return failures;
+}
+
+/* What test_solveProgress() gathers from the reports of one solve */
+typedef struct ProgressLog {
+	int reports;
+	int doneReports;
+	int undersized;          /* Interim reports with fewer new cells than asked for */
+	int lastIterations;
+	int solvedCells;
+	int minimumCells;
+	bool ordered;            /* Iterations never went back, and nothing came after done */
+	SolveStatus status;
+	unsigned char seen[64 * 64];
+	int repeats;             /* Cells reported more than once */
+} ProgressLog;
+
+static void logProgress (const SolveProgress * progress, void * context)
+{
+	int i;
+	ProgressLog * log = (ProgressLog *)context;
+
+	++log->reports;
+	log->ordered = log->ordered && progress->iterations >= log->lastIterations && log->doneReports == 0;
+	log->lastIterations = progress->iterations;
+	log->solvedCells = progress->solvedCells;
+
+	if (progress->stage == PROGRESS_DONE)
+	{
+		++log->doneReports;
+		log->status = progress->status;
+	}
+
+	else if (progress->newCellCount < log->minimumCells)
+		++log->undersized;
+
+	for (i = 0; i < progress->newCellCount; ++i)
+		log->repeats += log->seen[progress->newCells[i]]++ > 0;
+
+	return;
+}
+
+/*
+ * Progress reports: every cell is reported solved exactly once, ending with one done
+ * report carrying the status (the search puzzle's last cells come from the search), and
+ * progressCells holds interim reports back until enough cells are new.
+ */
+int test_solveProgress (void)
+{
+	int failures = 0, i, iterations = 0;
+	int * gameBoard = NULL;
+	FILE * filePtr = NULL;
+	ProgressLog log;
+	SolveStatus status;
+	SolveOptions options = { 0, 0, NULL, logProgress, &log, 0, 0 };
+	const char * files[] = {SEARCH_20X20, TEST4};
+	const int cellCounts[] = {400, 2500}, minimumCells[] = {0, 100};
+
+	for (i = 0; i < 2; ++i)
+	{
+		memset(&log, 0, sizeof(log));
+		log.ordered = TRUE;
+		log.minimumCells = minimumCells[i];
+		options.progressCells = minimumCells[i];
+
+		filePtr = fopen(files[i], "r");
+		if (filePtr == NULL)
+			return -1;
+
+		gameBoard = solvePuzzleWithOptions(filePtr, 1, &iterations, &status, &options);
+		fclose(filePtr);
+		free(gameBoard);
+
+		if (status != SOLVE_SOLVED || log.doneReports != 1 || log.status != SOLVE_SOLVED || !log.ordered || log.reports < 2
+			|| log.solvedCells != cellCounts[i] || log.repeats != 0 || log.undersized != 0)
+		{
+			printf("Test Failure: test-SolveProgress #%d: %s: %d reports, %d done, %d/%d cells, %d repeated, %d undersized\n", i + 1,
+				files[i], log.reports, log.doneReports, log.solvedCells, cellCounts[i], log.repeats, log.undersized);
+			++failures;
+		}
+	}
+
+	return failures;
+}
+
+/*
+ * Captures the line solves of a puzzle that needs the search, and replays them through
+ * both line engines: each must answer every captured line as the solve did.
+ */
+int test_lineCapture (void)
+{
+	int failures = 0, count = 0, iterations = 0, engine;
+	char error[256] = "";
+	int * gameBoard = NULL;
+	LineRecord * records = NULL;
+	LineReplay replay;
+	SolveStatus status;
+	FILE * capture = tmpfile(), * filePtr = fopen(SEARCH_20X20, "r");
+
+	if (capture == NULL || filePtr == NULL || !startLineCapture(capture))
+	{
+		if (capture != NULL) fclose(capture);
+		if (filePtr != NULL) fclose(filePtr);
+		return -1;
+	}
+
+	if (startLineCapture(capture))
+	{
+		printf("Test Failure: test-LineCapture #1: Expected: a second capture refused\n");
+		++failures;
+	}
+
+	gameBoard = solvePuzzle(filePtr, 1, &iterations, &status);
+	stopLineCapture();
+	fclose(filePtr);
+	free(gameBoard);
+
+	rewind(capture);
+	records = readLineCapture(capture, &count, error, sizeof(error));
+	fclose(capture);
+
+	if (status != SOLVE_SOLVED || records == NULL || count == 0)
+	{
+		printf("Test Failure: test-LineCapture #2: Expected: a solve with captured lines, Actual: %s, %d lines %s\n",
+			solveStatusName(status), count, error);
+		free(records);
+		return failures + 1;
+	}
+
+	for (engine = LINE_ENGINE_PLACEMENTS; engine <= LINE_ENGINE_PERMUTATIONS; ++engine)
+	{
+		status = replayLineCapture(records, count, (LineEngine)engine, 2, &replay);
+
+		if (status != SOLVE_SOLVED || replay.mismatches != 0 || replay.solves != 2L * count || replay.contradictions == 0)
+		{
+			printf("Test Failure: test-LineCapture #3 (%s): %s, %ld solves of %d lines, %ld mismatches, %ld contradictions\n",
+				lineEngineName((LineEngine)engine), solveStatusName(status), replay.solves, count, replay.mismatches, replay.contradictions);
+			++failures;
+		}
+	}
+
+	free(records);
+
+	return failures;
+}
+
+/*
+ * A row with 2.7e11 placements, far more than memory or a spill file could take, under a
+ * time limit and a memory limit: the limits keep it from being enumerated, so the solve
+ * finishes instead of running into the time limit. The limit is generous and only the
+ * outcome is checked, as the time taken varies too much between builds (sanitizers,
+ * debug) to assert on.
+ */
+int test_spillLimits (void)
+{
+	int failures = 0, iterations = 0;
+	int * gameBoard = NULL;
+	SolveStatus status;
+	SolveOptions options = { 60000, (size_t)100 << 20, NULL, NULL, NULL, 0, 0 };
+	FILE * filePtr = fopen(WIDE_64X3, "r");
+
+	if (filePtr == NULL)
+		return -1;
+
+	gameBoard = solvePuzzleWithOptions(filePtr, 1, &iterations, &status, &options);
+	fclose(filePtr);
+
+	if (status != SOLVE_SOLVED || gameBoard == NULL)
+	{
+		printf("Test Failure: test-SpillLimits #1: Expected: solved, Actual: %s\n", solveStatusName(status));
+		++failures;
+	}
+
+	free(gameBoard);
+
+	return failures;
+}
+
+/*
+ * Puzzles that line logic and probing leave unfinished, so the clause learning search has
+ * to finish them. Several solutions may exist, the result only has to match the clues.
+ */
+int test_searchPuzzles ()
+{
+	int failures = 0, i, iterations = 0;
+	int * actualSolution = NULL;
+	FILE * filePtr = NULL;
+	SolveStatus status;
+	const char * files[] = {SEARCH_AMBIGUOUS, SEARCH_20X20};
+
+	for (i = 0; i < 2; ++i)
+	{
+		filePtr = fopen(files[i], "r");
+
+		if (filePtr == NULL)
+			return -1;
+
+		actualSolution = solvePuzzle(filePtr, 1, &iterations, &status);
+		fclose(filePtr);
+		filePtr = NULL;
+
+		if (status != SOLVE_SOLVED || clueMismatches(files[i], actualSolution) != 0)
+		{
+			printf("Test Failure: test-SearchPuzzles #%d: %s\n", i + 1, solveStatusName(status));
+			++failures;
+		}
+
+		free(actualSolution);
+		actualSolution = NULL;
+	}
+
+	return failures;
+}
+
+/*
+ * Counts the lines of a puzzle file whose clues the gameboard does not reproduce, -1 if
+ * the file cannot be read.
+ */
+int clueMismatches (const char * path, int * gameBoard)
+{
+	int width = 0, length = 0, i, j, cell, run, clueIndex, mismatches = 0;
+	LineClue ** lineClues = NULL;
+	FILE * filePtr = fopen(path, "r");
+
+	if (filePtr == NULL || gameBoard == NULL)
+	{
+		if (filePtr != NULL)
+			fclose(filePtr);
+
+		return -1;
+	}
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	if (lineClues == NULL)
+		return -1;
+
+	for (i = 0; i < width + length; ++i)
+	{
+		run = 0;
+		clueIndex = 0;
+
+		/* One cell past the end closes the last run */
+		for (j = 0; j <= ((i < length) ? width : length); ++j)
+		{
+			cell = (i < length) ? i * width + j : j * width + (i - length);
+
+			if (j < ((i < length) ? width : length) && gameBoard[cell] == 1)
+				++run;
+
+			else if (run > 0)
+			{
+				if (clueIndex >= lineClues[i]->clueCount || lineClues[i]->clues[clueIndex] != run)
+					clueIndex = -1;
+
+				if (clueIndex < 0)
+					break;
+
+				++clueIndex;
+				run = 0;
+			}
+		}
+
+		if (clueIndex != lineClues[i]->clueCount)
+			++mismatches;
+	}
+
+	freeLineClues(lineClues, width + length);
+
+	return mismatches;
+}
+
 int * generateSolutionGameBoard (FILE * filePtr, int width, int length)
 {
 	
@@ -5,6 +5,30 @@
 
 int test_fullPuzzles (void);
 
+int test_unsolvablePuzzles (void);
+
+int test_searchPuzzles (void);
+
+int test_solveOptions (void);
+
+int test_solverContext (void);
+
+int test_stepSolve (void);
+
+int test_verifyBoard (void);
+
+int test_solveBatch (void);
+
+int test_estimatePuzzle (void);
+
+int test_solveProgress (void);
+
+int test_lineCapture (void);
+
+int test_spillLimits (void);
+
+int clueMismatches (const char *, int *);
+
 int * generateSolutionGameBoard (FILE *, int, int);
 
 int compareGameBoards (int *, int *, int);
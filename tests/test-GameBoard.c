@@ -1 +1,107 @@
 #include "test-GameBoard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/gameBoard.h"
+
+/*
+ * Renders a small board in every format, then a 64 column grid, whose border the old
+ * fixed buffer could not hold, into a buffer sized by a first render.
+ */
+int test_renderGameBoard (void)
+{
+	int failures = 0, i;
+	size_t size;
+	char buffer[64], * grid = NULL;
+	int * wide = NULL;
+
+	/* 2 rows of 3 cells: filled, empty, unsolved / empty, empty, filled */
+	const int board[] = {1, 0, -1, 0, 0, 1};
+	const char binary[] = {3, 2, 0x01, 0x04};
+	const char pbm[] = "P4\n3 2\n\x80\x20";
+
+	size = renderGameBoard(board, 3, 2, BOARD_ROWS, buffer, sizeof(buffer));
+	if (size != 8 || memcmp(buffer, "#.?;..#\n", 8) != 0)
+	{
+		printf("Test Failure: test_renderGameBoard #1: Expected: \"#.?;..#\", Actual: \"%.*s\"\n", (int)size, buffer);
+		++failures;
+	}
+
+	size = renderGameBoard(board, 3, 2, BOARD_BINARY, buffer, sizeof(buffer));
+	if (size != sizeof(binary) || memcmp(buffer, binary, sizeof(binary)) != 0)
+	{
+		printf("Test Failure: test_renderGameBoard #2: Binary output of %zu bytes does not match\n", size);
+		++failures;
+	}
+
+	size = renderGameBoard(board, 3, 2, BOARD_PBM, buffer, sizeof(buffer));
+	if (size != sizeof(pbm) - 1 || memcmp(buffer, pbm, sizeof(pbm) - 1) != 0)
+	{
+		printf("Test Failure: test_renderGameBoard #3: PBM output of %zu bytes does not match\n", size);
+		++failures;
+	}
+
+	/* Read as a colour board: colour a, background, unsolved / background, background, colour a */
+	size = renderColourBoard(board, 3, 2, BOARD_GRID, buffer, sizeof(buffer));
+	if (size != 8 || memcmp(buffer, "a.?\n..a\n", 8) != 0)
+	{
+		printf("Test Failure: test_renderGameBoard #8: Expected: \"a.?\\n..a\\n\", Actual: \"%.*s\"\n", (int)size, buffer);
+		++failures;
+	}
+
+	size = renderColourBoard(board, 3, 2, BOARD_ROWS, buffer, sizeof(buffer));
+	if (size != 8 || memcmp(buffer, "a.?;..a\n", 8) != 0)
+	{
+		printf("Test Failure: test_renderGameBoard #9: Expected: \"a.?;..a\\n\", Actual: \"%.*s\"\n", (int)size, buffer);
+		++failures;
+	}
+
+	if (renderColourBoard(board, 3, 2, BOARD_QUIET, buffer, sizeof(buffer)) != 0 || renderColourBoard(board, 3, 2, BOARD_PBM, buffer, sizeof(buffer)) != 0)
+	{
+		printf("Test Failure: test_renderGameBoard #10: Expected: no colour output when quiet or as PBM\n");
+		++failures;
+	}
+
+	if (renderGameBoard(board, 3, 2, BOARD_QUIET, buffer, sizeof(buffer)) != 0)
+	{
+		printf("Test Failure: test_renderGameBoard #4: Expected: no output when quiet\n");
+		++failures;
+	}
+
+	/* A short buffer is filled and no further, the full length still returned */
+	memset(buffer, '*', sizeof(buffer));
+	size = renderGameBoard(board, 3, 2, BOARD_ROWS, buffer, 4);
+	if (size != 8 || memcmp(buffer, "#.?;*", 5) != 0)
+	{
+		printf("Test Failure: test_renderGameBoard #5: Expected: 4 of 8 bytes written, Actual: %zu, \"%.5s\"\n", size, buffer);
+		++failures;
+	}
+
+	wide = createGameBoard(64, 5);
+	if (wide == NULL)
+		return failures + 1;
+
+	for (i = 0; i < 64 * 5; ++i)
+		wide[i] = i % 2;
+
+	size = renderGameBoard(wide, 64, 5, BOARD_GRID, NULL, 0);
+	grid = (char *)malloc(size);
+
+	if (grid == NULL || renderGameBoard(wide, 64, 5, BOARD_GRID, grid, size) != size)
+	{
+		printf("Test Failure: test_renderGameBoard #6: Grid render failed\n");
+		++failures;
+	}
+
+	/* A border is a space and 2 * (64 + 64 / 5) + 1 dashes */
+	else if (grid[0] != ' ' || grid[153] != '-' || grid[154] != '\n' || grid[size - 1] != '\n')
+	{
+		printf("Test Failure: test_renderGameBoard #7: 64 column grid border is malformed\n");
+		++failures;
+	}
+
+	free(grid);
+	free(wide);
+
+	return failures;
+}
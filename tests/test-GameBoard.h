@@ -1,6 +1,6 @@
 #ifndef TEST_GAMEBOARD_H
 #define TEST_GAMEBOARD_H
 
+int test_renderGameBoard (void);
 
-	
 #endif
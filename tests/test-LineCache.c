@@ -0,0 +1,248 @@
+#include "test-LineCache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/fileIO.h"
+#include "../include/lineCache.h"
+#include "../include/puzzle.h"
+#include "../include/solver.h"
+
+#define CACHE_PUZZLE "tests/testPuzzles/test-15x15-probing.txt"
+
+int test_lineCache_lookup (void)
+{
+	int returnValue = 0, result;
+	long lookups = 0, hits = 0;
+	uint64_t maskBits, partialBits;
+	LineCache * cache = createLineCache(16);
+
+	if (cache == NULL)
+		return 1;
+
+	lineCacheStore(cache, 3, 0x0FULL, 0x05ULL, TRUE, 0xFFULL, 0x35ULL);
+	lineCacheStore(cache, 4, 0x0FULL, 0x05ULL, FALSE, 0ULL, 0ULL);
+
+	maskBits = 0x0FULL;
+	partialBits = 0x05ULL;
+	result = lineCacheLookup(cache, 3, &maskBits, &partialBits);
+
+	if (result != 1 || maskBits != 0xFFULL || partialBits != 0x35ULL)
+	{
+		printf("Test Failure: test_lineCache_lookup #1: Expected: 1 (ff, 35), Actual: %d (%llx, %llx)\n",
+			result, (unsigned long long)maskBits, (unsigned long long)partialBits);
+		++returnValue;
+	}
+
+	/* Same cells under another key is a contradiction */
+	maskBits = 0x0FULL;
+	partialBits = 0x05ULL;
+	result = lineCacheLookup(cache, 4, &maskBits, &partialBits);
+
+	if (result != 0 || maskBits != 0x0FULL || partialBits != 0x05ULL)
+	{
+		printf("Test Failure: test_lineCache_lookup #2: Expected: 0, Actual: %d\n", result);
+		++returnValue;
+	}
+
+	/* A state never stored misses and keeps its bits */
+	partialBits = 0x06ULL;
+	result = lineCacheLookup(cache, 3, &maskBits, &partialBits);
+
+	if (result != -1 || maskBits != 0x0FULL || partialBits != 0x06ULL)
+	{
+		printf("Test Failure: test_lineCache_lookup #3: Expected: -1, Actual: %d\n", result);
+		++returnValue;
+	}
+
+	lineCacheStats(cache, &lookups, &hits);
+
+	if (lookups != 3 || hits != 2)
+	{
+		printf("Test Failure: test_lineCache_lookup #4: Expected: 3 lookups, 2 hits, Actual: %ld, %ld\n", lookups, hits);
+		++returnValue;
+	}
+
+	freeLineCache(cache);
+	cache = NULL;
+
+	return returnValue;
+}
+
+int test_solveBoardLine_cached (void)
+{
+	int returnValue = 0, width = 0, length = 0, index;
+	long lookups = 0, hits = 0;
+	uint64_t maskBits, partialBits, cachedMask, cachedPartial, expectedMask, expectedPartial;
+	bool feasible, cachedFeasible, expectedFeasible;
+	LineClue ** lineClues = NULL;
+	Puzzle * puzzle = NULL;
+	FILE * filePtr = fopen(CACHE_PUZZLE, "r");
+
+	if (filePtr == NULL)
+		return 1;
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	if (lineClues == NULL)
+		return 1;
+
+	puzzle = createPuzzle(lineClues, width, length);
+	if (puzzle == NULL)
+	{
+		freeLineClues(lineClues, width + length);
+		return 1;
+	}
+
+	/* Every row with its first cell filled and its third empty, solved twice */
+	for (index = 0; index < length; ++index)
+	{
+		maskBits = expectedMask = 0x05ULL;
+		partialBits = expectedPartial = 0x01ULL;
+
+		feasible = solveBoardLine(puzzle, index, &maskBits, &partialBits);
+
+		cachedMask = 0x05ULL;
+		cachedPartial = 0x01ULL;
+		cachedFeasible = solveBoardLine(puzzle, index, &cachedMask, &cachedPartial);
+
+		expectedFeasible = solveLinePlacements(puzzle->lines[index], &expectedMask, &expectedPartial);
+
+		if (feasible != expectedFeasible || cachedFeasible != expectedFeasible
+			|| (expectedFeasible && (maskBits != expectedMask || partialBits != expectedPartial
+			|| cachedMask != expectedMask || cachedPartial != expectedPartial)))
+		{
+			printf("Test Failure: test_solveBoardLine_cached: row %d differs from solveLinePlacements()\n", index);
+			++returnValue;
+		}
+	}
+
+	lineCacheStats(puzzle->lineCache, &lookups, &hits);
+
+	/* The second solve of each row is a hit, as is the first of a row repeating another's clues */
+	if (lookups != 2 * length || hits < length)
+	{
+		printf("Test Failure: test_solveBoardLine_cached: Expected: %d lookups, %d+ hits, Actual: %ld, %ld\n",
+			2 * length, length, lookups, hits);
+		++returnValue;
+	}
+
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
+	return returnValue;
+}
+
+/*
+ * Reads CACHE_PUZZLE into a puzzle solving lines through cache.
+ */
+static Puzzle * loadSharedPuzzle (LineCache * cache)
+{
+	int width = 0, length = 0;
+	LineClue ** lineClues = NULL;
+	Puzzle * puzzle = NULL;
+	FILE * filePtr = fopen(CACHE_PUZZLE, "r");
+
+	if (filePtr == NULL)
+		return NULL;
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	if (lineClues == NULL)
+		return NULL;
+
+	puzzle = createPuzzleWithCache(lineClues, width, length, cache);
+	if (puzzle == NULL)
+		freeLineClues(lineClues, width + length);
+
+	return puzzle;
+}
+
+int test_sharedLineCache (void)
+{
+	int returnValue = 0, index, i, first, again, clues[2];
+	long lookups = 0, hits = 0;
+	uint64_t maskBits, partialBits;
+	LineCache * cache = createLineCache(4096);
+	Puzzle * solved = NULL, * repeat = NULL;
+
+	if (cache == NULL)
+		return 1;
+
+	solved = loadSharedPuzzle(cache);
+	repeat = loadSharedPuzzle(cache);
+
+	if (solved == NULL || repeat == NULL)
+	{
+		printf("Test Failure: test_sharedLineCache #1: Puzzles could not be built\n");
+		++returnValue;
+		goto shared_Done;
+	}
+
+	/* The same clues get the same key in either puzzle */
+	for (index = 0; index < solved->width + solved->length; ++index)
+		if (solved->lineKeys[index] != repeat->lineKeys[index])
+		{
+			printf("Test Failure: test_sharedLineCache #2: Line %d keyed %d and %d\n", index, solved->lineKeys[index], repeat->lineKeys[index]);
+			++returnValue;
+			break;
+		}
+
+	for (index = 0; index < solved->length; ++index)
+	{
+		maskBits = 0x05ULL;
+		partialBits = 0x01ULL;
+		solveBoardLine(solved, index, &maskBits, &partialBits);
+	}
+
+	freePuzzle(solved);
+	solved = NULL;
+
+	/* The second puzzle finds every row the first one solved, the cache outliving it */
+	lineCacheStats(cache, &lookups, &hits);
+	i = (int)hits;
+
+	for (index = 0; index < repeat->length; ++index)
+	{
+		maskBits = 0x05ULL;
+		partialBits = 0x01ULL;
+		solveBoardLine(repeat, index, &maskBits, &partialBits);
+	}
+
+	lineCacheStats(cache, &lookups, &hits);
+
+	if (hits - i != repeat->length)
+	{
+		printf("Test Failure: test_sharedLineCache #3: Expected: %d hits, Actual: %ld\n", repeat->length, hits - i);
+		++returnValue;
+	}
+
+	/* Filling the key table empties it without handing an old key out again */
+	clues[0] = 1;
+	clues[1] = 1;
+	first = lineCacheKey(cache, clues, 2, 64);
+
+	for (i = 0; i < 4096; ++i)
+	{
+		clues[0] = 2 + i % 64;
+		clues[1] = 1 + i / 64;
+		lineCacheKey(cache, clues, 2, 64);
+	}
+
+	clues[0] = 1;
+	clues[1] = 1;
+	again = lineCacheKey(cache, clues, 2, 64);
+
+	if (first < 0 || again <= first || lineCacheKey(cache, clues, 2, 64) != again)
+	{
+		printf("Test Failure: test_sharedLineCache #4: Expected: a new stable key after %d, Actual: %d\n", first, again);
+		++returnValue;
+	}
+
+shared_Done:
+	freePuzzle(solved);
+	freePuzzle(repeat);
+	freeLineCache(cache);
+
+	return returnValue;
+}
@@ -0,0 +1,10 @@
+#ifndef TEST_LINE_CACHE_H
+#define TEST_LINE_CACHE_H
+
+int test_lineCache_lookup (void);
+
+int test_solveBoardLine_cached (void);
+
+int test_sharedLineCache (void);
+
+#endif
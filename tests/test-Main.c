@@ -1,8 +1,12 @@
 #include <stdio.h>
 #include "test-BitSet.h"
+#include "test-Colour.h"
 #include "test-GameBoard.h"
 #include "test-Solver.h"
 #include "test-FullPuzzles.h"
+#include "test-Search.h"
+#include "test-LineCache.h"
+#include "test-Daemon.h"
 
 int main (void)
 {
@@ -15,21 +19,77 @@ int main (void)
 
 	if (failures == 0) printf("All BitSet tests passed!\n");
 	totalFailures += failures;
+
+	failures = test_renderGameBoard();
+
+	if (failures == 0) printf("All GameBoard tests passed!\n");
+	totalFailures += failures;
 	
 	failures = test_createLine();
 	failures += test_updateBitMask();
 	failures += test_minRequiredLength();
 	failures += test_overlap();
+	failures += test_applyLineRules();
+	failures += test_solveLinePlacements();
 	failures += test_generatePermutations_counting();
+	failures += test_filterPermutations();
+	failures += test_generateConsistentPattern();
+	failures += test_enumeratePermutations_parallel();
+	failures += test_lookupPatterns();
+	failures += test_speculation();
+	failures += test_solveSingleLine();
+	failures += test_spillPermutations();
 
 	if (failures == 0) printf("All Solver tests passed!\n");
 	totalFailures += failures;
 
 	failures = test_fullPuzzles();
+	failures += test_unsolvablePuzzles();
+	failures += test_searchPuzzles();
+	failures += test_solveOptions();
+	failures += test_solverContext();
+	failures += test_stepSolve();
+	failures += test_verifyBoard();
+	failures += test_solveBatch();
+	failures += test_estimatePuzzle();
+	failures += test_solveProgress();
+	failures += test_lineCapture();
+	failures += test_spillLimits();
 
 	if (failures == 0) printf("All Full Puzzle tests passed!\n");
 	totalFailures += failures;
 
+	failures = test_colourParse();
+	failures += test_colourLine();
+	failures += test_colourPuzzles();
+
+	if (failures == 0) printf("All Colour tests passed!\n");
+	totalFailures += failures;
+
+	failures = test_searchPuzzle_counting();
+	failures += test_searchPuzzle_parallel();
+	failures += test_searchPuzzle_probing();
+	failures += test_findComponents();
+	failures += test_solveComponents();
+	failures += test_countSolutions_ambiguous();
+	failures += test_countSolutions_unique();
+
+	if (failures == 0) printf("All Search tests passed!\n");
+	totalFailures += failures;
+
+	failures = test_lineCache_lookup();
+	failures += test_solveBoardLine_cached();
+	failures += test_sharedLineCache();
+
+	if (failures == 0) printf("All Line Cache tests passed!\n");
+	totalFailures += failures;
+
+	failures = test_daemon_requests();
+	failures += test_daemon_socket();
+
+	if (failures == 0) printf("All Daemon tests passed!\n");
+	totalFailures += failures;
+
 	if (totalFailures == 0) printf ("\nAll Tests Passed!\n");
 
 	else printf("\n%d Tests Failed.\n", totalFailures);
@@ -0,0 +1,302 @@
+#include "test-Search.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "test-FullPuzzles.h"
+#include "../include/cdcl.h"
+#include "../include/components.h"
+#include "../include/fileIO.h"
+#include "../include/parallel.h"
+#include "../include/puzzle.h"
+#include "../include/search.h"
+#include "../include/solverAPI.h"
+
+#define SEARCH_AMBIGUOUS "tests/testPuzzles/test-2x2-ambiguous.txt"
+#define SEARCH_20X20 "tests/testPuzzles/test-20x20-search.txt"
+#define SEARCH_RANDOM "tests/testPuzzles/test-29x23-search.txt"
+#define SEARCH_COMPONENTS "tests/testPuzzles/test-10x10-components.txt"
+#define SEARCH_UNIQUE "tests/testPuzzles/test-15x15-probing.txt"
+
+/*
+ * Reads a puzzle and runs line propagation on it, leaving the stalled state for the
+ * search. Returns NULL if the file cannot be read.
+ */
+static Puzzle * loadStalledPuzzle (const char * path)
+{
+	int width = 0, length = 0;
+	LineClue ** lineClues = NULL;
+	Puzzle * puzzle = NULL;
+	FILE * filePtr = fopen(path, "r");
+
+	if (filePtr == NULL)
+		return NULL;
+
+	lineClues = readFile(filePtr, &width, &length);
+	fclose(filePtr);
+
+	if (lineClues == NULL)
+		return NULL;
+
+	puzzle = createPuzzle(lineClues, width, length);
+	if (puzzle == NULL)
+	{
+		freeLineClues(lineClues, width + length);
+		return NULL;
+	}
+
+	propagatePuzzle(puzzle);
+
+	return puzzle;
+}
+
+/*
+ * RegionSolver running the parallel search on a region.
+ */
+static SolveStatus searchRegion (Puzzle * puzzle, const int * cells, int cellCount)
+{
+	return searchPuzzle(puzzle, cells, cellCount, 1, NULL);
+}
+
+int test_searchPuzzle_counting (void)
+{
+	int returnValue = 0;
+	long solutionCount = 0;
+	SolveStatus status;
+	Puzzle * puzzle = loadStalledPuzzle(SEARCH_AMBIGUOUS);
+
+	if (puzzle == NULL)
+		return 1;
+
+	/* Both diagonals solve the 2x2 */
+	setWorkerCount(4);
+	status = searchPuzzle(puzzle, NULL, 0, 0, &solutionCount);
+	setWorkerCount(0);
+
+	if (status != SOLVE_SOLVED || solutionCount != 2 || clueMismatches(SEARCH_AMBIGUOUS, puzzle->gameBoard) != 0)
+	{
+		printf("Test Failure: test_searchPuzzle_counting: Expected: 2 solutions, Actual: %ld (%s)\n",
+			solutionCount, solveStatusName(status));
+		++returnValue;
+	}
+
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
+	return returnValue;
+}
+
+int test_searchPuzzle_parallel (void)
+{
+	int returnValue = 0, workers;
+	long solutionCount = 0;
+	SolveStatus status;
+	Puzzle * puzzle = NULL;
+
+	/* Stopping at the first solution, with one worker and with several */
+	for (workers = 1; workers <= 4; workers += 3)
+	{
+		puzzle = loadStalledPuzzle(SEARCH_20X20);
+		if (puzzle == NULL)
+			return 1;
+
+		setWorkerCount(workers);
+		status = searchPuzzle(puzzle, NULL, 0, 1, &solutionCount);
+
+		if (status != SOLVE_SOLVED || solutionCount < 1 || clueMismatches(SEARCH_20X20, puzzle->gameBoard) != 0)
+		{
+			printf("Test Failure: test_searchPuzzle_parallel: %d workers, %s\n", workers, solveStatusName(status));
+			++returnValue;
+		}
+
+		freePuzzle(puzzle);
+		puzzle = NULL;
+	}
+
+	setWorkerCount(0);
+
+	return returnValue;
+}
+
+int test_searchPuzzle_probing (void)
+{
+	int returnValue = 0;
+	long solutionCount = 0;
+	SolveStatus status;
+	Puzzle * puzzle = loadStalledPuzzle(SEARCH_RANDOM);
+
+	if (puzzle == NULL)
+		return 1;
+
+	/* A random board line propagation stalls on early, counting every solution checks the
+		nogoods the workers learn and share never cut one off */
+	setWorkerCount(4);
+	status = searchPuzzle(puzzle, NULL, 0, 0, &solutionCount);
+	setWorkerCount(0);
+
+	if (status != SOLVE_SOLVED || solutionCount != 768 || clueMismatches(SEARCH_RANDOM, puzzle->gameBoard) != 0)
+	{
+		printf("Test Failure: test_searchPuzzle_probing: Expected: 768 solutions, Actual: %ld (%s)\n",
+			solutionCount, solveStatusName(status));
+		++returnValue;
+	}
+
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
+	return returnValue;
+}
+
+int test_findComponents (void)
+{
+	int returnValue = 0, count, i, j;
+	int cellComponent[100];
+	Puzzle * puzzle = loadStalledPuzzle(SEARCH_COMPONENTS);
+
+	if (puzzle == NULL)
+		return 1;
+
+	count = findComponents(puzzle, cellComponent);
+
+	if (count != 2)
+	{
+		printf("Test Failure: test_findComponents #1: Expected: 2, Actual: %d\n", count);
+		++returnValue;
+	}
+
+	/* Unsolved cells sharing a row or column share a component */
+	for (i = 0; i < 100; ++i)
+	{
+		if ((cellComponent[i] == -1) != (puzzle->gameBoard[i] != -1))
+		{
+			printf("Test Failure: test_findComponents #2: cell %d labelled %d\n", i, cellComponent[i]);
+			++returnValue;
+		}
+
+		for (j = 0; j < 100; ++j)
+			if (cellComponent[i] >= 0 && cellComponent[j] >= 0 && (i / 10 == j / 10 || i % 10 == j % 10)
+				&& cellComponent[i] != cellComponent[j])
+			{
+				printf("Test Failure: test_findComponents #3: cells %d and %d split\n", i, j);
+				++returnValue;
+			}
+	}
+
+	freePuzzle(puzzle);
+	puzzle = NULL;
+
+	return returnValue;
+}
+
+int test_solveComponents (void)
+{
+	int returnValue = 0, concurrent, i;
+	SolveStatus status;
+	Puzzle * puzzle = NULL;
+
+	setWorkerCount(4);
+
+	/* Clause learning on concurrent regions, then the parallel search one region at a time */
+	for (concurrent = 1; concurrent >= 0; --concurrent)
+	{
+		puzzle = loadStalledPuzzle(SEARCH_COMPONENTS);
+		if (puzzle == NULL)
+		{
+			++returnValue;
+			break;
+		}
+
+		status = solveComponents(puzzle, concurrent ? cdclSolve : searchRegion, concurrent);
+
+		for (i = 0; i < 100 && puzzle->gameBoard[i] != -1; ++i);
+
+		if (status != SOLVE_SOLVED || i < 100 || clueMismatches(SEARCH_COMPONENTS, puzzle->gameBoard) != 0)
+		{
+			printf("Test Failure: test_solveComponents: concurrent %d, %s\n", concurrent, solveStatusName(status));
+			++returnValue;
+		}
+
+		freePuzzle(puzzle);
+		puzzle = NULL;
+	}
+
+	setWorkerCount(0);
+
+	return returnValue;
+}
+
+/*
+ * SolutionCallback counting the solutions it is given that match the clues.
+ */
+static void checkSolution (const int * gameBoard, int width, int length, void * context)
+{
+	int * valid = (int *)context;
+
+	(void)width;
+	(void)length;
+
+	if (clueMismatches(SEARCH_AMBIGUOUS, (int *)gameBoard) == 0)
+		++*valid;
+
+	return;
+}
+
+int test_countSolutions_ambiguous (void)
+{
+	int returnValue = 0, valid = 0, firstDifference = -1;
+	long solutionCount = 0;
+	SolveStatus status;
+	FILE * filePtr = fopen(SEARCH_AMBIGUOUS, "r");
+
+	if (filePtr == NULL)
+		return 1;
+
+	/* The two diagonals differ in every cell, so from the first cell on */
+	status = countSolutions(filePtr, 0, checkSolution, &valid, &solutionCount, &firstDifference, NULL);
+	fclose(filePtr);
+
+	if (status != SOLVE_SOLVED || solutionCount != 2 || valid != 2 || firstDifference != 0)
+	{
+		printf("Test Failure: test_countSolutions_ambiguous: Expected: 2 solutions differing at 0, Actual: %ld (%d streamed) differing at %d (%s)\n",
+			solutionCount, valid, firstDifference, solveStatusName(status));
+		++returnValue;
+	}
+
+	return returnValue;
+}
+
+int test_countSolutions_unique (void)
+{
+	int returnValue = 0, firstDifference = 0;
+	long solutionCount = 0;
+	SolveStatus status;
+	FILE * filePtr = fopen(SEARCH_UNIQUE, "r");
+
+	if (filePtr == NULL)
+		return 1;
+
+	status = countSolutions(filePtr, 2, NULL, NULL, &solutionCount, &firstDifference, NULL);
+	fclose(filePtr);
+
+	if (status != SOLVE_SOLVED || solutionCount != 1 || firstDifference != -1)
+	{
+		printf("Test Failure: test_countSolutions_unique: Expected: 1 solution, Actual: %ld (%s)\n",
+			solutionCount, solveStatusName(status));
+		++returnValue;
+	}
+
+	/* The search puzzle has several solutions, the limit stops at the second */
+	filePtr = fopen(SEARCH_20X20, "r");
+	if (filePtr == NULL)
+		return returnValue + 1;
+
+	status = countSolutions(filePtr, 2, NULL, NULL, &solutionCount, &firstDifference, NULL);
+	fclose(filePtr);
+
+	if (status != SOLVE_SOLVED || solutionCount != 2 || firstDifference < 0 || firstDifference >= 400)
+	{
+		printf("Test Failure: test_countSolutions_unique: Expected: 2 solutions, Actual: %ld differing at %d (%s)\n",
+			solutionCount, firstDifference, solveStatusName(status));
+		++returnValue;
+	}
+
+	return returnValue;
+}
@@ -0,0 +1,18 @@
+#ifndef TEST_SEARCH_H
+#define TEST_SEARCH_H
+
+int test_searchPuzzle_counting (void);
+
+int test_searchPuzzle_parallel (void);
+
+int test_searchPuzzle_probing (void);
+
+int test_findComponents (void);
+
+int test_solveComponents (void);
+
+int test_countSolutions_ambiguous (void);
+
+int test_countSolutions_unique (void);
+
+#endif
@@ -1,15 +1,24 @@
+#define _POSIX_C_SOURCE 200809L
 #include "test-Solver.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "../include/solver.h"
 #include "../include/utility.h"
+#include "../include/lineSolve.h"
+#include "../include/parallel.h"
+#include "../include/patternTable.h"
+#include "../include/puzzle.h"
+#include "../include/speculate.h"
+#include "../include/spill.h"
 
 int test_createLine (void)
 {
 	int returnValue = 0;
 
 	int clues[] = {1, 1, 1};
-	LineClue lineclue = {(int *)&clues, 3};
+	LineClue lineclue = {(int *)&clues, 3, NULL};
 
 	Line * line = createLine (&lineclue, 5, 0);
 
@@ -30,17 +39,17 @@ int test_generatePermutations_counting (void)
 	int returnValue = 0;
 
 	int clues1[] = {4, 3};
-	LineClue lineclue1 = {(int *)&clues1, 2};
+	LineClue lineclue1 = {(int *)&clues1, 2, NULL};
 	Line * line1 = createLine (&lineclue1, 10, 0);
 	/* 4 choose 2 */
 
 	int clues2[] = {1, 3, 5};
-	LineClue lineclue2 = {(int *)&clues2, 3};
+	LineClue lineclue2 = {(int *)&clues2, 3, NULL};
 	Line * line2 = createLine (&lineclue2, 20, 1);
 	/* 12 choose 3 */
 
 	int clues3[] = {6, 3, 5, 1, 7};
-	LineClue lineclue3 = {(int *)&clues3, 5};
+	LineClue lineclue3 = {(int *)&clues3, 5, NULL};
 	Line * line3 = createLine (&lineclue3, 40, 2);
 	/* 19 choose 5 */
 
@@ -88,7 +97,7 @@ int test_updateBitMask (void)
 	int clues[] = {3};
 	uint64_t targetMaskBits = 0;
 	uint64_t targetPartialBits = 0;
-	LineClue lineclue = {(int *)&clues, 1};
+	LineClue lineclue = {(int *)&clues, 1, NULL};
 	Line * line = createLine (&lineclue, 5, 0);
 
 	updateBitMasks(line, (int *)&partialSolution);
@@ -116,12 +125,101 @@ int test_updateBitMask (void)
 
 int test_filterPermutations (void)
 {
-	int returnValue = 0;
-		
+	int returnValue = 0, i, liveCount = 0;
+
+	int clues[] = {2, 1};
+	LineClue lineclue = {(int *)&clues, 2, NULL};
+	Line * line = createLine (&lineclue, 6, 0);
+	/* 6 permutations, 3 with cell 0 filled and 2 of those with cell 5 empty */
+
+	if (!enumeratePermutations(line))
+	{
+		printf("Test Failure: test_filterPermutations #1: Allocation failed\n");
+		freeLine(line);
+		return 1;
+	}
+
+	line->maskBits = 0x21;
+	line->partialBits = 0x01;
+	filterPermutations(line);
+
+	for (i = nextSetBit(line->bitSet, 0); i >= 0; i = nextSetBit(line->bitSet, i + 1))
+	{
+		++liveCount;
+
+		if ((line->permutations[i] & 0x21) != 0x01)
+		{
+			printf("Test Failure: test_filterPermutations #1: Inconsistent permutation %lX kept\n", line->permutations[i]);
+			++returnValue;
+		}
+	}
+
+	if (liveCount != 2)
+	{
+		printf("Test Failure: test_filterPermutations #1: Expected: 2, Actual: %d\n", liveCount);
+		++returnValue;
+	}
+
+	if (line->appliedMaskBits != 0x21)
+	{
+		printf("Test Failure: test_filterPermutations #1: AppliedMaskBits no match\n");
+		++returnValue;
+	}
+
+	/* Remaining permutations: 11 0 1 0 0 and 11 0 0 1 0 */
+	if (line->liveCount != 2 || line->cellCounts[1] != 2 || line->cellCounts[3] != 1 || line->cellCounts[5] != 0)
+	{
+		printf("Test Failure: test_filterPermutations #2: Cell counts no match\n");
+		++returnValue;
+	}
+
+	freeLine(line);
+	line = NULL;
+
 	return returnValue;
 }
 
-int test_generateConsistentPattern (void);
+int test_generateConsistentPattern (void)
+{
+	int returnValue = 0;
+
+	int clues[] = {3, 1};
+	LineClue lineclue = {(int *)&clues, 2, NULL};
+	Line * line = createLine (&lineclue, 7, 0);
+	/* Cell 2 is always filled, known cell 6 empty leaves 111 0 1 0 0 and 111 0 0 1 0
+		once cell 0 is known filled */
+
+	if (!enumeratePermutations(line))
+	{
+		printf("Test Failure: test_generateConsistentPattern #1: Allocation failed\n");
+		freeLine(line);
+		return 1;
+	}
+
+	generateConsistentPattern(line);
+
+	if (line->maskBits != 0x04 || line->partialBits != 0x04)
+	{
+		printf("Test Failure: test_generateConsistentPattern #1: Expected: 4/4, Actual: %lX/%lX\n", line->maskBits, line->partialBits);
+		++returnValue;
+	}
+
+	line->maskBits |= 0x41;
+	line->partialBits |= 0x01;
+	filterPermutations(line);
+	generateConsistentPattern(line);
+
+	if (line->maskBits != 0x4F || line->partialBits != 0x07)
+	{
+		printf("Test Failure: test_generateConsistentPattern #2: Expected: 4F/7, Actual: %lX/%lX\n", line->maskBits, line->partialBits);
+		++returnValue;
+	}
+
+	freeLine(line);
+	line = NULL;
+
+	return returnValue;
+}
 
 int test_minRequiredLength (void)
 {
@@ -129,17 +227,17 @@ int test_minRequiredLength (void)
 	int length = 0;
 
 	int clues1[] = {1, 1, 1};
-	LineClue lineclue1 = {(int *)&clues1, 3};
+	LineClue lineclue1 = {(int *)&clues1, 3, NULL};
 	Line * line1 = createLine (&lineclue1, 5, 0);
 	/* Length = 5 */
 
 	int clues2[] = {1, 3, 8, 5};
-	LineClue lineclue2 = {(int *)&clues2, 4};
+	LineClue lineclue2 = {(int *)&clues2, 4, NULL};
 	Line * line2 = createLine (&lineclue2, 25, 0);
 	/* Length = 20 */
 
 	int clues3[] = {7, 1, 8, 2, 1, 5, 7, 3, 3};
-	LineClue lineclue3 = {(int *)&clues3, 9};
+	LineClue lineclue3 = {(int *)&clues3, 9, NULL};
 	Line * line3 = createLine (&lineclue3, 50, 0);
 	/* Length = 45 */
 
@@ -186,17 +284,17 @@ int test_overlap (void)
 	uint64_t targetPartialBits = 0;
 	
 	int clues1[] = {7};
-	LineClue lineclue1 = {(int *)&clues1, 1};
+	LineClue lineclue1 = {(int *)&clues1, 1, NULL};
 	Line * line1 = createLine (&lineclue1, 10, 0);
 	/* 00011 11000 */
 
 	int clues2[] = {14, 6};
-	LineClue lineclue2 = {(int *)&clues2, 2};
+	LineClue lineclue2 = {(int *)&clues2, 2, NULL};
 	Line * line2 = createLine (&lineclue2, 30, 0);
 	/* 00000 00001 11110 00000 00000 00000 */
 
 	int clues3[] = {15, 2, 8, 2, 13};
-	LineClue lineclue3 = {(int *)&clues3, 5};
+	LineClue lineclue3 = {(int *)&clues3, 5, NULL};
 	Line * line3 = createLine (&lineclue3, 50, 0);
 	/* 00000 01111 11111 00000 00000 11000 00000 00111 11110 00000 */
 
@@ -262,3 +360,610 @@ int test_overlap (void)
 
 	return returnValue;
 }
+
+int test_enumeratePermutations_parallel (void)
+{
+	int returnValue = 0, i;
+
+	int clues[] = {1, 1, 1, 1, 1};
+	LineClue lineclue = {(int *)&clues, 5, NULL};
+	Line * serial = createLine (&lineclue, 40, 0);
+	Line * parallel = createLine (&lineclue, 40, 0);
+	/* 36 choose 5 = 376992, large enough to be split by start and by word range */
+
+	serial->maskBits = parallel->maskBits = 0x3ULL;
+	serial->partialBits = parallel->partialBits = 0x1ULL;
+
+	setWorkerCount(1);
+	if (!enumeratePermutations(serial))
+		++returnValue;
+
+	setWorkerCount(4);
+	if (!enumeratePermutations(parallel))
+		++returnValue;
+
+	if (returnValue == 0 && serial->storeCount != parallel->storeCount)
+	{
+		printf("Test Failure: test_enumeratePermutations_parallel #1: Expected: %d, Actual: %d\n", serial->storeCount, parallel->storeCount);
+		++returnValue;
+	}
+
+	for (i = 0; returnValue == 0 && i < serial->storeCount; ++i)
+		if (serial->permutations[i] != parallel->permutations[i])
+		{
+			printf("Test Failure: test_enumeratePermutations_parallel #2: Permutation %d no match\n", i);
+			++returnValue;
+		}
+
+	serial->maskBits = parallel->maskBits |= 0xF00ULL;
+	serial->partialBits = parallel->partialBits |= 0x100ULL;
+
+	setWorkerCount(1);
+	filterPermutations(serial);
+	generateConsistentPattern(serial);
+
+	setWorkerCount(4);
+	filterPermutations(parallel);
+	generateConsistentPattern(parallel);
+
+	if (returnValue == 0 && (serial->liveCount != parallel->liveCount || serial->maskBits != parallel->maskBits))
+	{
+		printf("Test Failure: test_enumeratePermutations_parallel #3: Filtering no match\n");
+		++returnValue;
+	}
+
+	for (i = 0; returnValue == 0 && i < serial->size; ++i)
+		if (serial->cellCounts[i] != parallel->cellCounts[i])
+		{
+			printf("Test Failure: test_enumeratePermutations_parallel #4: Cell %d count no match\n", i);
+			++returnValue;
+		}
+
+	setWorkerCount(0);
+
+	freeLine(serial);
+	serial = NULL;
+
+	freeLine(parallel);
+	parallel = NULL;
+
+	return returnValue;
+}
+
+int test_applyLineRules (void)
+{
+	int returnValue = 0;
+
+	int clues1[] = {3, 1};
+	LineClue lineclue1 = {(int *)&clues1, 2, NULL};
+	Line * line1 = createLine (&lineclue1, 10, 0);
+	/* Known blank at cell 2 and filled cell 9: the 3 can only start at 3..5 and the 1 sits on cell 9
+		..X.. .... # → cells 0,1,2,8 blank, cell 5 filled, cell 9 filled */
+
+	int clues2[] = {2};
+	LineClue lineclue2 = {(int *)&clues2, 1, NULL};
+	Line * line2 = createLine (&lineclue2, 8, 1);
+	/* Known filled cell 6 keeps the 2 within cells 5..7, cells 0..4 blank */
+
+	int clues3[] = {4};
+	LineClue lineclue3 = {(int *)&clues3, 1, NULL};
+	Line * line3 = createLine (&lineclue3, 5, 2);
+	/* Known blank at cell 1 leaves no room for the 4 */
+
+	line1->maskBits = 0x204;
+	line1->partialBits = 0x200;
+
+	if (!applyLineRules(line1) || line1->maskBits != 0x327 || line1->partialBits != 0x220)
+	{
+		printf("Test Failure: test_applyLineRules #1: Expected: 327/220, Actual: %lX/%lX\n", line1->maskBits, line1->partialBits);
+		++returnValue;
+	}
+
+	line2->maskBits = 0x40;
+	line2->partialBits = 0x40;
+
+	if (!applyLineRules(line2) || line2->maskBits != 0x5F || line2->partialBits != 0x40)
+	{
+		printf("Test Failure: test_applyLineRules #2: Expected: 5F/40, Actual: %lX/%lX\n", line2->maskBits, line2->partialBits);
+		++returnValue;
+	}
+
+	line3->maskBits = 0x02;
+
+	if (applyLineRules(line3))
+	{
+		printf("Test Failure: test_applyLineRules #3: Contradiction not detected\n");
+		++returnValue;
+	}
+
+	free(line1);
+	line1 = NULL;
+
+	free(line2);
+	line2 = NULL;
+
+	free(line3);
+	line3 = NULL;
+
+	return returnValue;
+}
+
+int test_solveLinePlacements (void)
+{
+	int returnValue = 0;
+	uint64_t maskBits, partialBits;
+
+	int clues1[] = {1, 1};
+	LineClue lineclue1 = {(int *)&clues1, 2, NULL};
+	Line * line1 = createLine (&lineclue1, 5, 0);
+	/* Filled cell 2 is one of the two 1s either way, so cells 1 and 3 are blank. The rule
+		pass deduces nothing here */
+
+	int clues2[] = {3};
+	LineClue lineclue2 = {(int *)&clues2, 1, NULL};
+	Line * line2 = createLine (&lineclue2, 5, 1);
+	/* Filled cells 0 and 4 cannot both be covered by the 3 */
+
+	int clues3[] = {63};
+	LineClue lineclue3 = {(int *)&clues3, 1, NULL};
+	Line * line3 = createLine (&lineclue3, 64, 2);
+	/* Known blank at cell 0 leaves cells 1..63 for the 63 (table path for wide lines) */
+
+	maskBits = 0x04;
+	partialBits = 0x04;
+
+	if (!isLineFeasible(line1, maskBits, partialBits) || !solveLinePlacements(line1, &maskBits, &partialBits)
+		|| maskBits != 0x0E || partialBits != 0x04)
+	{
+		printf("Test Failure: test_solveLinePlacements #1: Expected: E/4, Actual: %lX/%lX\n", maskBits, partialBits);
+		++returnValue;
+	}
+
+	maskBits = 0x11;
+	partialBits = 0x11;
+
+	if (isLineFeasible(line2, maskBits, partialBits) || solveLinePlacements(line2, &maskBits, &partialBits))
+	{
+		printf("Test Failure: test_solveLinePlacements #2: Contradiction not detected\n");
+		++returnValue;
+	}
+
+	maskBits = 0x01;
+	partialBits = 0x00;
+
+	if (!solveLinePlacements(line3, &maskBits, &partialBits) || maskBits != ~0ULL || partialBits != ~1ULL)
+	{
+		printf("Test Failure: test_solveLinePlacements #3: Expected: all/all but cell 0, Actual: %lX/%lX\n", maskBits, partialBits);
+		++returnValue;
+	}
+
+	free(line1);
+	line1 = NULL;
+
+	free(line2);
+	line2 = NULL;
+
+	free(line3);
+	line3 = NULL;
+
+	return returnValue;
+}
+
+int test_lookupPatterns (void)
+{
+	int returnValue = 0, count = 0, again = 0, i, j, runs, run;
+	const uint64_t * patterns = NULL, * repeated = NULL;
+
+	int clues[] = {2, 1};
+	LineClue lineclue = {(int *)&clues, 2, NULL};
+	Line * line = NULL;
+
+	int longClues[] = {1};
+
+	if (!lookupPatterns(clues, 2, 6, &patterns, &count) || count != 6)
+	{
+		printf("Test Failure: test_lookupPatterns #1: Expected: 6 placements, Actual: %d\n", count);
+		return 1;
+	}
+
+	/* Every placement is distinct and reads back as a run of 2 then a run of 1 */
+	for (i = 0; i < count; ++i)
+	{
+		runs = 0;
+		run = 0;
+
+		for (j = 0; j <= 6; ++j)
+		{
+			if (j < 6 && (patterns[i] >> j & 1ULL))
+				++run;
+
+			else if (run > 0)
+			{
+				if (runs >= 2 || run != clues[runs])
+					runs = 3;
+				else
+					++runs;
+
+				run = 0;
+			}
+		}
+
+		for (j = 0; j < i; ++j)
+			if (patterns[j] == patterns[i])
+				runs = 3;
+
+		if (runs != 2)
+		{
+			printf("Test Failure: test_lookupPatterns #2: Placement %d (0x%llx) does not match {2, 1}\n", i, (unsigned long long)patterns[i]);
+			++returnValue;
+		}
+	}
+
+	if (!lookupPatterns(clues, 2, 6, &repeated, &again) || repeated != patterns || again != count)
+	{
+		printf("Test Failure: test_lookupPatterns #3: Expected: the same tabled placements on a repeat lookup\n");
+		++returnValue;
+	}
+
+	if (lookupPatterns(longClues, 1, PATTERN_TABLE_MAX_SIZE + 1, &repeated, &again))
+	{
+		printf("Test Failure: test_lookupPatterns #4: Expected: no table for %d cell lines\n", PATTERN_TABLE_MAX_SIZE + 1);
+		++returnValue;
+	}
+
+	/* An unsolved line shares the table's placements */
+	line = createLine(&lineclue, 6, 0);
+	if (!enumeratePermutations(line) || !line->sharedPermutations || line->permutations != patterns || line->permutationCount != 6)
+	{
+		printf("Test Failure: test_lookupPatterns #5: Expected: the unsolved line to share the 6 tabled placements\n");
+		++returnValue;
+	}
+	freeLine(line);
+
+	/* With cell 0 filled only the 3 placements starting the 2 there are copied */
+	line = createLine(&lineclue, 6, 1);
+	line->maskBits = 1ULL;
+	line->partialBits = 1ULL;
+	if (!enumeratePermutations(line) || line->sharedPermutations || line->permutationCount != 3)
+	{
+		printf("Test Failure: test_lookupPatterns #6: Expected: 3 copied placements, Actual: %d\n", line->permutationCount);
+		++returnValue;
+	}
+
+	for (i = 0; i < line->storeCount; ++i)
+	{
+		if ((line->permutations[i] & 3ULL) != 3ULL)
+		{
+			printf("Test Failure: test_lookupPatterns #7: Placement 0x%llx does not fill cell 0\n", (unsigned long long)line->permutations[i]);
+			++returnValue;
+		}
+	}
+	freeLine(line);
+
+	return returnValue;
+}
+
+/*
+ * Speculates a 40 cell row with 66045 placements of {1, 1, 1, 1} (37 choose 4) and a row
+ * of one placement, then adopts the first: it must hand over every placement consistent
+ * with the cells known when queued, once, and not the second. A stopped guard abandons an
+ * enumeration, and a cancelled solve or a step budget speculates nothing.
+ */
+int test_speculation (void)
+{
+	int returnValue = 0, i;
+	atomic_bool cancel;
+	EnumerationGuard guard;
+	int clues[] = {1, 1, 1, 1}, full[] = {40}, single[] = {1};
+	LineClue ** lineClues = (LineClue **)calloc(42, sizeof(LineClue *));
+	Puzzle * puzzle = NULL;
+	Speculation * speculation = NULL;
+	Line * line = NULL;
+	struct timespec pause = { 0, 300000000L };
+
+	if (lineClues == NULL)
+		return 1;
+
+	lineClues[0] = createLineClueSet(clues, 4);
+	lineClues[1] = createLineClueSet(full, 1);
+	for (i = 2; i < 42; ++i)
+		lineClues[i] = createLineClueSet(single, 1);
+
+	puzzle = createPuzzle(lineClues, 40, 2);
+	if (puzzle == NULL)
+	{
+		freeLineClues(lineClues, 42);
+		return 1;
+	}
+
+	/* Cell 0 known empty: 36 choose 4 placements remain */
+	puzzle->lines[0]->maskBits = 1ULL;
+
+	setWorkerCount(4);
+	speculation = startSpeculation(puzzle);
+	setWorkerCount(0);
+
+	if (speculation == NULL)
+	{
+		printf("Test Failure: test_speculation #1: Expected: the 40 cell row to be speculated\n");
+		freePuzzle(puzzle);
+		return 1;
+	}
+
+	/* A line the helpers have not started is withdrawn, give them time to finish it */
+	nanosleep(&pause, NULL);
+
+	line = takeSpeculation(speculation, 0);
+	if (line == NULL || line->permutationCount != 58905 || line->appliedMaskBits != 1ULL)
+	{
+		printf("Test Failure: test_speculation #2: Expected: 58905 placements, Actual: %d\n", (line != NULL) ? line->permutationCount : -1);
+		++returnValue;
+	}
+
+	else
+	{
+		moveLinePermutations(puzzle->lines[0], line);
+
+		/* Cell 1 solved since: filtering catches up */
+		puzzle->lines[0]->maskBits |= 2ULL;
+		if (!filterPermutations(puzzle->lines[0]) || puzzle->lines[0]->liveCount != 52360)
+		{
+			printf("Test Failure: test_speculation #3: Expected: 52360 live placements, Actual: %d\n", puzzle->lines[0]->liveCount);
+			++returnValue;
+		}
+	}
+	freeLine(line);
+
+	if (takeSpeculation(speculation, 0) != NULL || takeSpeculation(speculation, 1) != NULL)
+	{
+		printf("Test Failure: test_speculation #4: Expected: nothing more to hand over\n");
+		++returnValue;
+	}
+
+	stopSpeculation(speculation);
+
+	/* A stopped guard abandons the enumeration in progress */
+	line = createLine(puzzle->lines[0]->clueSet, 40, 0);
+	if (line != NULL)
+	{
+		atomic_init(&guard.stop, TRUE);
+		guard.cancel = NULL;
+		guard.deadline = 0;
+		line->guard = &guard;
+
+		if (enumeratePermutations(line))
+		{
+			printf("Test Failure: test_speculation #5: Expected: a stopped enumeration to fail\n");
+			++returnValue;
+		}
+	}
+	freeLine(line);
+
+	/* The helpers skip every line of a cancelled solve */
+	atomic_init(&cancel, TRUE);
+	puzzle->cancel = &cancel;
+	clearLinePermutations(puzzle->lines[0]);
+	puzzle->lines[0]->maskBits = 1ULL;
+
+	setWorkerCount(4);
+	speculation = startSpeculation(puzzle);
+	setWorkerCount(0);
+
+	nanosleep(&pause, NULL);
+
+	if (speculation == NULL || takeSpeculation(speculation, 0) != NULL)
+	{
+		printf("Test Failure: test_speculation #6: Expected: nothing enumerated for a cancelled solve\n");
+		++returnValue;
+	}
+
+	stopSpeculation(speculation);
+	puzzle->cancel = NULL;
+
+	/* A step budget needs each enumeration decided by the sweep */
+	puzzle->stepUnits = 1;
+
+	setWorkerCount(4);
+	speculation = startSpeculation(puzzle);
+	setWorkerCount(0);
+
+	if (speculation != NULL)
+	{
+		printf("Test Failure: test_speculation #7: Expected: no speculation under a step budget\n");
+		++returnValue;
+	}
+
+	stopSpeculation(speculation);
+	freePuzzle(puzzle);
+
+	return returnValue;
+}
+
+int test_solveSingleLine (void)
+{
+	int returnValue = 0, engine;
+	uint64_t maskBits, partialBits;
+	SolveStatus status;
+
+	int clues[] = {1, 1};
+	int wide[] = {63};
+	int tooLong[] = {4, 4};
+	int zero[] = {0};
+
+	for (engine = LINE_ENGINE_PLACEMENTS; engine <= LINE_ENGINE_PERMUTATIONS; ++engine)
+	{
+		/* Filled cell 2 is one of the two 1s either way, so cells 1 and 3 are blank */
+		maskBits = 0x04;
+		partialBits = 0x04;
+		status = solveSingleLine((LineEngine)engine, clues, 2, 5, &maskBits, &partialBits);
+
+		if (status != SOLVE_IN_PROGRESS || maskBits != 0x0E || partialBits != 0x04)
+		{
+			printf("Test Failure: test_solveSingleLine #1 (%s): Expected: E/4, Actual: %s %lX/%lX\n", lineEngineName((LineEngine)engine),
+				solveStatusName(status), maskBits, partialBits);
+			++returnValue;
+		}
+
+		/* A known blank at cell 0 leaves cells 1..63 for the 63 */
+		maskBits = 0x01;
+		partialBits = 0x00;
+		status = solveSingleLine((LineEngine)engine, wide, 1, 64, &maskBits, &partialBits);
+
+		if (status != SOLVE_SOLVED || maskBits != ~0ULL || partialBits != ~1ULL)
+		{
+			printf("Test Failure: test_solveSingleLine #2 (%s): Expected: solved, Actual: %s %lX/%lX\n", lineEngineName((LineEngine)engine),
+				solveStatusName(status), maskBits, partialBits);
+			++returnValue;
+		}
+
+		/* Filled cells 0 and 1 make a 2, the masks stay as they were */
+		maskBits = 0x03;
+		partialBits = 0x03;
+		status = solveSingleLine((LineEngine)engine, clues, 2, 5, &maskBits, &partialBits);
+
+		if (status != SOLVE_UNSATISFIABLE || maskBits != 0x03 || partialBits != 0x03
+			|| solveSingleLine((LineEngine)engine, tooLong, 2, 8, &maskBits, &partialBits) != SOLVE_UNSATISFIABLE)
+		{
+			printf("Test Failure: test_solveSingleLine #3 (%s): Contradictions not detected\n", lineEngineName((LineEngine)engine));
+			++returnValue;
+		}
+
+		/* An empty line is all blank */
+		maskBits = 0x00;
+		partialBits = 0x00;
+		status = solveSingleLine((LineEngine)engine, NULL, 0, 7, &maskBits, &partialBits);
+
+		if (status != SOLVE_SOLVED || maskBits != 0x7F || partialBits != 0x00)
+		{
+			printf("Test Failure: test_solveSingleLine #4 (%s): Expected: 7F/0, Actual: %s %lX/%lX\n", lineEngineName((LineEngine)engine),
+				solveStatusName(status), maskBits, partialBits);
+			++returnValue;
+		}
+	}
+
+	/* Filled cells outside the known ones, cells beyond the line, a size of 0 and a 0 clue */
+	maskBits = 0x01;
+	partialBits = 0x02;
+	if (solveSingleLine(LINE_ENGINE_PLACEMENTS, clues, 2, 5, &maskBits, &partialBits) != SOLVE_INVALID_INPUT)
+	{
+		printf("Test Failure: test_solveSingleLine #5: Expected: filled cells outside the known ones rejected\n");
+		++returnValue;
+	}
+
+	maskBits = 0x20;
+	partialBits = 0x00;
+	if (solveSingleLine(LINE_ENGINE_PLACEMENTS, clues, 2, 5, &maskBits, &partialBits) != SOLVE_INVALID_INPUT
+		|| solveSingleLine(LINE_ENGINE_PLACEMENTS, clues, 2, 0, &partialBits, &partialBits) != SOLVE_INVALID_INPUT
+		|| solveSingleLine(LINE_ENGINE_PLACEMENTS, zero, 1, 5, &partialBits, &partialBits) != SOLVE_INVALID_INPUT)
+	{
+		printf("Test Failure: test_solveSingleLine #6: Expected: out of range lines rejected\n");
+		++returnValue;
+	}
+
+	return returnValue;
+}
+
+int test_spillPermutations (void)
+{
+	int returnValue = 0, step;
+	long fileBytes;
+	SolveStatus status;
+	Puzzle puzzle;
+	atomic_bool stop = TRUE;
+
+	/* 1,370,754 permutations, more than a spill chunk holds */
+	int clues[] = {1, 1, 1, 1, 1};
+	LineClue lineclue = {(int *)&clues, 5, NULL};
+	Line * memory = createLine(&lineclue, 50, 0);
+	Line * spilled = createLine(&lineclue, 50, 1);
+
+	/* Cell 49 blank, then cells 0, 2, 4 and 6 filled around blanks (cell 7 is then forced
+		blank), then two more 1s */
+	const uint64_t masks[] = {1ULL << 49, 0x7FULL | 1ULL << 49, 0x7FULL | 1ULL << 49 | 1ULL << 20 | 1ULL << 30};
+	const uint64_t partials[] = {0ULL, 0x55ULL, 0x55ULL | 1ULL << 20 | 1ULL << 30};
+
+	if (!enumeratePermutations(memory) || spillPermutations(spilled, NULL) != SOLVE_IN_PROGRESS)
+	{
+		printf("Test Failure: test_spillPermutations #1: Enumeration failed\n");
+		freeLine(memory);
+		freeLine(spilled);
+		return 1;
+	}
+
+	if (spilled->spill == NULL || spilled->spill->count != (uint64_t)memory->permutationCount || spilled->maskBits != 0ULL
+		|| memory->permutationCount <= SPILL_CHUNK_WORDS)
+	{
+		printf("Test Failure: test_spillPermutations #1: Expected: %d permutations, Actual: %llu\n", memory->permutationCount,
+			(spilled->spill != NULL) ? (unsigned long long)spilled->spill->count : 0ULL);
+		freeLine(memory);
+		freeLine(spilled);
+		return 1;
+	}
+
+	for (step = 0; step < 2; ++step)
+	{
+		memory->maskBits = spilled->maskBits = masks[step];
+		memory->partialBits = spilled->partialBits = partials[step];
+
+		if (!filterPermutations(memory) || !generateConsistentPattern(memory))
+		{
+			printf("Test Failure: test_spillPermutations #%d: In memory filter failed\n", step + 2);
+			++returnValue;
+			break;
+		}
+
+		status = filterSpilledPermutations(spilled, NULL);
+
+		fseek(spilled->spill->file, 0, SEEK_END);
+		fileBytes = ftell(spilled->spill->file);
+
+		if (status != SOLVE_IN_PROGRESS || spilled->spill->count != (uint64_t)memory->liveCount
+			|| fileBytes != memory->liveCount * (long)sizeof(uint64_t)
+			|| spilled->maskBits != memory->maskBits || spilled->partialBits != memory->partialBits)
+		{
+			printf("Test Failure: test_spillPermutations #%d: Expected: %d permutations, %lX/%lX, Actual: %s, %llu in %ld bytes, %lX/%lX\n",
+				step + 2, memory->liveCount, memory->maskBits, memory->partialBits, solveStatusName(status),
+				(unsigned long long)spilled->spill->count, fileBytes, spilled->maskBits, spilled->partialBits);
+			++returnValue;
+		}
+	}
+
+	if ((spilled->maskBits & 0x80ULL) == 0ULL || (spilled->partialBits & 0x80ULL) != 0ULL)
+	{
+		printf("Test Failure: test_spillPermutations #4: Expected: cell 7 blank\n");
+		++returnValue;
+	}
+
+	spilled->maskBits = masks[2];
+	spilled->partialBits = partials[2];
+
+	if (filterSpilledPermutations(spilled, NULL) != SOLVE_UNSATISFIABLE || spilled->spill->count != 0)
+	{
+		printf("Test Failure: test_spillPermutations #5: Expected: no permutation with six 1s\n");
+		++returnValue;
+	}
+
+	/* A cancelled solve stops the spill at its first chunk, leaving the line as it was */
+	clearLinePermutations(spilled);
+	spilled->maskBits = spilled->partialBits = 0ULL;
+	memset(&puzzle, 0, sizeof(puzzle));
+	puzzle.cancel = &stop;
+
+	if (spillPermutations(spilled, &puzzle) != SOLVE_CANCELLED || spilled->spill != NULL || spilled->maskBits != 0ULL)
+	{
+		printf("Test Failure: test_spillPermutations #6: Expected: the spill cancelled\n");
+		++returnValue;
+	}
+
+	/* Lines an int cannot count always spill, lines within a chunk never do */
+	if (!needsSpill(SPILL_MIN_PLACEMENTS * 2, 64) || needsSpill(1000.0, 50))
+	{
+		printf("Test Failure: test_spillPermutations #7: Expected: only the uncountable line spilled\n");
+		++returnValue;
+	}
+
+	freeLine(memory);
+	freeLine(spilled);
+
+	return returnValue;
+}
@@ -15,4 +15,18 @@ int test_minRequiredLength (void);
 
 int test_overlap (void);
 
+int test_enumeratePermutations_parallel (void);
+
+int test_applyLineRules (void);
+
+int test_solveLinePlacements (void);
+
+int test_lookupPatterns (void);
+
+int test_speculation (void);
+
+int test_solveSingleLine (void);
+
+int test_spillPermutations (void);
+
 #endif